@@ -0,0 +1,85 @@
+#version 150
+
+// Grid lines from the plane position alone, anti-aliased with the screen
+// space derivatives. The cell size follows the camera height in powers
+// of 'sub_divisions', the finest level fading out before it gets dense,
+// and everything fades out with distance.
+
+in vec3 near_point;
+in vec3 far_point;
+
+out vec4 frag_color;
+
+uniform mat4 p3d_ModelViewProjectionMatrix;
+uniform mat4 p3d_ViewMatrixInverse;
+
+uniform float grid_step;        // major cell size at the finest level
+uniform float sub_divisions;
+uniform float fade_distance;    // in camera heights, at least in major cells
+uniform vec4 x_axis_color;
+uniform vec4 y_axis_color;
+uniform vec4 grid_color;
+uniform vec4 sub_div_color;
+
+// 1 on a line of the given cell size, 0 away from it, about a pixel wide
+float grid_lines(vec2 position, float cell_size) {
+    vec2 coord = position / cell_size;
+    vec2 width = fwidth(coord);
+    vec2 lines = abs(fract(coord - 0.5) - 0.5) / width;
+    return 1.0 - min(min(lines.x, lines.y), 1.0);
+}
+
+float axis_line(float coord) {
+    return 1.0 - min(abs(coord) / fwidth(coord), 1.0);
+}
+
+void main() {
+    // Where the view ray hits the plane, nothing above the horizon
+    float t = -near_point.z / (far_point.z - near_point.z);
+    if (t <= 0.0) {
+        discard;
+    }
+    vec3 position = near_point + t * (far_point - near_point);
+
+    // Depth of the plane point, so the scene still hides the grid
+    vec4 clip = p3d_ModelViewProjectionMatrix * vec4(position, 1.0);
+    gl_FragDepth = (clip.z / clip.w) * 0.5 + 0.5;
+
+    vec3 camera = p3d_ViewMatrixInverse[3].xyz;
+    float height = max(abs(camera.z), 0.001);
+
+    // Level 0 is a camera height of one major cell
+    float base = max(sub_divisions, 2.0);
+    float lod = max(log(height / grid_step) / log(base), 0.0);
+    float lod_fade = fract(lod);
+    float minor_size = grid_step / base * pow(base, floor(lod));
+    float major_size = minor_size * base;
+
+    float minor = grid_lines(position.xy, minor_size) * (1.0 - lod_fade);
+    float major = grid_lines(position.xy, major_size);
+
+    vec4 color = sub_div_color;
+    color.a *= minor;
+    if (major > 0.0) {
+        color = mix(color, grid_color, major);
+    }
+
+    float x_axis = axis_line(position.y);
+    float y_axis = axis_line(position.x);
+    if (x_axis > 0.0) {
+        color = mix(color, x_axis_color, x_axis);
+    }
+    if (y_axis > 0.0) {
+        color = mix(color, y_axis_color, y_axis);
+    }
+
+    // Fade with distance relative to the height, far lines turn to noise
+    float fade_end = fade_distance * max(height, grid_step);
+    float distance_fade = 1.0 - smoothstep(0.0, fade_end, length(position.xy - camera.xy));
+    color.a *= distance_fade;
+
+    if (color.a <= 0.001) {
+        discard;
+    }
+    frag_color = color;
+}
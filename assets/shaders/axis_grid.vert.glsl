@@ -0,0 +1,22 @@
+#version 150
+
+// Full screen quad, the fragment shader finds where each pixel's view
+// ray hits the grid plane (z = 0 in the grid's space).
+
+in vec4 p3d_Vertex;     // { x, y } in -1..1
+
+out vec3 near_point;
+out vec3 far_point;
+
+uniform mat4 p3d_ModelViewProjectionMatrixInverse;
+
+vec3 unproject(vec2 ndc, float depth) {
+    vec4 point = p3d_ModelViewProjectionMatrixInverse * vec4(ndc, depth, 1.0);
+    return point.xyz / point.w;
+}
+
+void main() {
+    near_point = unproject(p3d_Vertex.xy, -1.0);
+    far_point = unproject(p3d_Vertex.xy, 1.0);
+    gl_Position = vec4(p3d_Vertex.xy, 0.0, 1.0);
+}
@@ -0,0 +1,72 @@
+#include <cmath>
+#include <cstdio>
+
+#include "runtimeScript.hpp"
+
+// Many debug draw shapes and labels redrawn every frame, lines go to
+// three streaming buffers whatever their number. Shapes move so the
+// buffers really are rewritten each frame.
+class DebugDrawBenchmark : public RuntimeScript {
+public:
+    DebugDrawBenchmark(Demon& demon) : RuntimeScript(demon) {}
+
+protected:
+    void on_update(const PT(AsyncTask)&) override
+    {
+        time += dt;
+
+        int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(num_shapes))));
+        for (int i = 0; i < num_shapes; ++i) {
+            float x = static_cast<float>(i % side - side / 2) * 2.0f;
+            float y = static_cast<float>(i / side - side / 2) * 2.0f;
+            float z = 1.0f + 0.5f * std::sin(time * 2.0f + x * 0.3f + y * 0.2f);
+            LPoint3 center(x, y, z);
+            LColor color(0.5f + 0.5f * std::sin(x * 0.1f), 0.5f + 0.5f * std::cos(y * 0.1f), 1.0f, 1.0f);
+            DebugDraw::Mode mode = overlay ? DebugDraw::OVERLAY : DebugDraw::DEPTH_TESTED;
+
+            switch (i % 3) {
+                case 0:
+                    debug_draw.box(center - LVector3(0.4f), center + LVector3(0.4f), color, mode);
+                    break;
+                case 1:
+                    debug_draw.sphere(center, 0.4f, color, mode, 12);
+                    break;
+                default:
+                    debug_draw.arrow(LPoint3(x, y, 0), center, color, mode);
+                    break;
+            }
+
+            if (i < num_labels) {
+                std::snprintf(label, sizeof(label), "%d", i);
+                debug_draw.text(center + LVector3(0, 0, 0.6f), label, LColor(1, 1, 1, 1), mode, 0.3f);
+            }
+        }
+
+        debug_draw.rect_2d(LPoint2(10, 10), LPoint2(210, 60), LColor(1, 1, 0, 1));
+        debug_draw.text_2d(LPoint2(20, 25), "debug draw", LColor(1, 1, 0, 1));
+    }
+
+    void render_game_imgui() override
+    {
+        ImGui::Begin("Debug Draw Benchmark");
+        ImGui::SliderInt("Shapes", &num_shapes, 0, 20000);
+        ImGui::SliderInt("Labels", &num_labels, 0, 500);
+        ImGui::Checkbox("Overlay", &overlay);
+        ImGui::Separator();
+
+        // Of the previous frame
+        ImGui::Text("lines:  %8d", debug_draw.get_num_lines());
+        ImGui::Text("labels: %8d", debug_draw.get_num_labels());
+        ImGui::Text("frame:  %8.3f ms", 1000.0f / ImGui::GetIO().Framerate);
+        ImGui::End();
+    }
+
+private:
+    int num_shapes = 2000;
+    int num_labels = 50;
+    bool overlay = false;
+    float time = 0.0f;
+    char label[16] = {};
+};
+
+REGISTER_SCRIPT(DebugDrawBenchmark)
@@ -0,0 +1,77 @@
+#include <vector>
+
+#include "runtimeScript.hpp"
+
+// Cost of the Panda3D ImGui backend with the ImGui demo window open,
+// retained mode against rebuilding all nodes, states and buffers every
+// frame. Numbers are averages over the last NUM_FRAMES frames.
+class ImGuiRenderBenchmark : public RuntimeScript {
+public:
+    ImGuiRenderBenchmark(Demon& demon) : RuntimeScript(demon) {}
+
+protected:
+    void render_imgui() override
+    {
+        // Stats of the previous frame, this one is not rendered yet
+        add_sample(demon.p3d_imgui.get_render_stats());
+
+        ImGui::SetNextWindowPos(ImVec2(400, 20), ImGuiCond_FirstUseEver);
+        ImGui::ShowDemoWindow(&show_demo_window);
+
+        ImGui::Begin("ImGui Render Benchmark");
+
+        bool retained = demon.p3d_imgui.is_retained();
+        if (ImGui::Checkbox("Retained", &retained)) {
+            demon.p3d_imgui.set_retained(retained);
+            samples.clear();
+        }
+        ImGui::Checkbox("Demo window", &show_demo_window);
+        ImGui::Separator();
+
+        if (!samples.empty()) {
+            double cpu_time = 0.0, frame_time = 0.0;
+            size_t vertex_bytes = 0, index_bytes = 0;
+            int reparents = 0, state_misses = 0, reused = 0;
+
+            for (const Panda3DImGui::RenderStats& stats : samples) {
+                cpu_time += stats.cpu_time;
+                frame_time += stats.frame_time;
+                vertex_bytes += stats.vertex_bytes;
+                index_bytes += stats.index_bytes;
+                reparents += stats.num_reparents;
+                state_misses += stats.num_state_misses;
+                reused += stats.reused ? 1 : 0;
+            }
+
+            double count = static_cast<double>(samples.size());
+            const Panda3DImGui::RenderStats& last = samples.back();
+
+            ImGui::Text("%d lists, %d draw commands", last.num_draw_lists, last.num_draw_commands);
+            ImGui::Text("backend cpu:   %8.3f ms", cpu_time / count * 1000.0);
+            ImGui::Text("editor ui:     %8.3f ms", frame_time / count * 1000.0);
+            ImGui::Text("vertex upload: %8.1f KB", vertex_bytes / count / 1024.0);
+            ImGui::Text("index upload:  %8.1f KB", index_bytes / count / 1024.0);
+            ImGui::Text("reparents:     %8.1f", reparents / count);
+            ImGui::Text("new states:    %8.1f", state_misses / count);
+            ImGui::Text("reused frames: %8d", reused);
+            ImGui::Text("frame:         %8.3f ms", 1000.0f / ImGui::GetIO().Framerate);
+        }
+
+        ImGui::End();
+    }
+
+private:
+    static constexpr size_t NUM_FRAMES = 120;
+
+    bool show_demo_window = true;
+    std::vector<Panda3DImGui::RenderStats> samples;
+
+    void add_sample(const Panda3DImGui::RenderStats& stats)
+    {
+        if (samples.size() >= NUM_FRAMES)
+            samples.erase(samples.begin());
+        samples.push_back(stats);
+    }
+};
+
+REGISTER_SCRIPT(ImGuiRenderBenchmark)
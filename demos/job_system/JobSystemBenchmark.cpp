@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <lpoint3.h>
+#include <lmatrix.h>
+
+#include "runtimeScript.hpp"
+#include "jobSystem.hpp"
+
+// Scaling benchmark for the engine JobSystem, transforms a large batch of
+// points with 1 to N cores and reports time and speedup for each core count.
+class JobSystemBenchmark : public RuntimeScript {
+public:
+    JobSystemBenchmark(Demon& demon) : RuntimeScript(demon) {}
+
+    void start()
+    {
+        RuntimeScript::start();
+
+        points.resize(NUM_POINTS);
+        results.resize(NUM_POINTS);
+        for (size_t i = 0; i < NUM_POINTS; ++i) {
+            points[i] = LPoint3f(float(i % 1000), float(i % 333), float(i % 77));
+        }
+
+        transform = LMatrix4f::translate_mat(1.0f, 2.0f, 3.0f) *
+            LMatrix4f::rotate_mat(30.0f, LVector3f(0.0f, 0.0f, 1.0f)) *
+            LMatrix4f::scale_mat(1.5f);
+
+        run_benchmark();
+    }
+
+protected:
+    void render_imgui() override
+    {
+        ImGui::Begin("JobSystem Benchmark");
+        ImGui::Text("%d points, best of %d runs", static_cast<int>(NUM_POINTS), NUM_RUNS);
+        ImGui::Separator();
+
+        for (const Result& result : timings) {
+            ImGui::Text(
+                "%2d cores: %8.3f ms  speedup %5.2fx",
+                result.num_cores,
+                result.ms,
+                timings.front().ms / result.ms);
+        }
+
+        if (ImGui::Button("Run again"))
+            run_benchmark();
+
+        ImGui::End();
+    }
+
+private:
+    struct Result {
+        int num_cores;
+        double ms;
+    };
+
+    static constexpr size_t NUM_POINTS = 4000000;
+    static constexpr int NUM_RUNS = 5;
+
+    std::vector<LPoint3f> points;
+    std::vector<LPoint3f> results;
+    std::vector<Result> timings;
+    LMatrix4f transform;
+
+    void run_benchmark()
+    {
+        timings.clear();
+        int max_cores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+        for (int num_cores = 1; num_cores <= max_cores; ++num_cores) {
+            // The calling thread helps while waiting, so it counts as a core
+            JobSystem jobs;
+            jobs.start(num_cores - 1);
+
+            double best_ms = 0.0;
+            for (int run = 0; run < NUM_RUNS; ++run) {
+                auto begin = std::chrono::high_resolution_clock::now();
+
+                jobs.parallel_for(0, NUM_POINTS, [this](size_t range_begin, size_t range_end) {
+                    for (size_t i = range_begin; i < range_end; ++i) {
+                        results[i] = transform.xform_point(points[i]);
+                    }
+                });
+
+                auto end = std::chrono::high_resolution_clock::now();
+                double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+                if (run == 0 || ms < best_ms)
+                    best_ms = ms;
+            }
+
+            jobs.stop();
+            timings.push_back({ num_cores, best_ms });
+            std::cout << "JobSystemBenchmark: " << num_cores << " cores "
+                      << best_ms << " ms" << std::endl;
+        }
+    }
+};
+
+REGISTER_SCRIPT(JobSystemBenchmark)
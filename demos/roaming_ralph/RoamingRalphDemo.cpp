@@ -1,3 +1,4 @@
+#include <iostream>
 #include <string>
 #include <unordered_map>
 
@@ -28,6 +29,13 @@ public:
         third_person_cam(game.main_cam, ralph, mouse),
         cam_collision_handler(ralph, c_trav),
         character_controller(ralph, c_trav) {}
+
+    ~RoamingRalphDemo()
+    {
+        // don't deliver load callbacks to an unloaded script
+        for (const AsyncLoadHandle& load : asset_loads)
+            load->cancel();
+    }
         
     void start()
     {
@@ -37,20 +45,44 @@ public:
         // Create a key map and register keys to their corresponding events
         register_keys();
         
+        // Load all models in the background, the game keeps rendering meanwhile
+        asset_loads = resource_manager.load_batch_async(
+            { environment_path, ralph_path, ralph_anims_path },
+            [this](const std::vector<AsyncLoadHandle>& loads) { on_assets_loaded(loads); });
+    }
+
+protected:
+    void on_assets_loaded(const std::vector<AsyncLoadHandle>& loads)
+    {
+        asset_loads.clear();
+
+        for (const AsyncLoadHandle& load : loads) {
+            if (load->get_status() != AsyncLoad::LOADED) {
+                std::cerr << "RoamingRalphDemo: could not load " << load->get_path() << std::endl;
+                return;
+            }
+        }
+
+        NodePath start = loads[0]->get_model().find("**/Start_Pos");
+        if (start.is_empty()) {
+            std::cerr << "RoamingRalphDemo: no Start_Pos in " << environment_path << std::endl;
+            return;
+        }
+
         // load environment
-        environment = resource_manager.load_model(environment_path);
+        environment = loads[0]->get_model();
         environment.reparent_to(game.render);
         environment.set_pos(LPoint3(0.0f, 0.0f, 0.0f));
         
         // ------------------------------------------------------------------------------ //
         // --------------------------- Setup Character Controller ----------------------- //
         // ------------------------------------------------------------------------------ //
-        ralph = resource_manager.load_model(ralph_path);
+        ralph = loads[1]->get_model();
         ralph.reparent_to(game.render);
         ralph.set_scale(0.5f);
         
-        std::vector<NodePath> anims = { resource_manager.load_model(ralph_anims_path) };
-        LPoint3 start_pos = environment.find("**/Start_Pos").get_pos();
+        std::vector<NodePath> anims = { loads[2]->get_model() };
+        LPoint3 start_pos = start.get_pos();
         character_controller.init(anims, start_pos);
 
         // ------------------------------------------------------------------------------ //
@@ -65,11 +97,15 @@ public:
         c_trav.traverse(game.render);
         character_controller.update(dt, game.render, input_map);
         update_cam();
+
+        assets_loaded = true;
     }
 
-protected:
     void on_update(const PT(AsyncTask)&)
     {
+        if (!assets_loaded)
+            return;
+
         c_trav.traverse(game.render);
         character_controller.update(dt, game.render, input_map);
         update_cam();
@@ -97,7 +133,7 @@ protected:
     {
 		RuntimeScript::on_event(event_name);
         
-        if (event_name == "wheel_up")
+        if (event_name == "wheel_up" && assets_loaded)
             third_person_cam.zoom(1, dt);
     }
 
@@ -117,6 +153,8 @@ private:
     
     // Other
     enum CamType cam_type = Classic;
+    std::vector<AsyncLoadHandle> asset_loads;
+    bool assets_loaded = false;
         
     void register_keys()
     {
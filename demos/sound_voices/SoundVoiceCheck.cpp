@@ -0,0 +1,96 @@
+#include <iostream>
+
+#include "runtimeScript.hpp"
+#include "soundManager.hpp"
+
+// Checks voice limiting and virtualisation against Panda's null audio
+// manager, so it runs the same with or without a sound device. Plays
+// more one shots than there are voices and checks the voice counts
+// while they play and once they have ended.
+class SoundVoiceCheck : public RuntimeScript {
+public:
+    SoundVoiceCheck(Demon& demon) : RuntimeScript(demon)
+    {
+        sounds.initialize(true);
+        sounds.set_max_voices(MAX_VOICES);
+        sounds.set_null_sound_length(SOUND_LENGTH);
+
+        for (int i = 0; i < NUM_SOUNDS; ++i)
+            handles[i] = sounds.play("sounds/check.wav", SoundManager::EFFECT, i < NUM_HIGH_PRIORITY ? 1 : 0);
+        looping = sounds.play("sounds/check_loop.wav", SoundManager::EFFECT, -1, 1.0f, true);
+
+        check("started", sounds.get_num_voices() == NUM_SOUNDS + 1);
+    }
+
+    ~SoundVoiceCheck()
+    {
+        // Also removes the stream task of its managers
+        sounds.shutdown();
+    }
+
+protected:
+    void on_update(const PT(AsyncTask)&) override
+    {
+        if (done)
+            return;
+
+        sounds.update();
+        elapsed += dt;
+
+        if (!checked_playing && elapsed > SOUND_LENGTH * 0.5) {
+            checked_playing = true;
+            check("all voices alive", sounds.get_num_voices() == NUM_SOUNDS + 1);
+            check("over the limit virtual", sounds.get_num_virtual() == NUM_SOUNDS + 1 - MAX_VOICES);
+
+            bool high_priority_real = true;
+            for (int i = 0; i < NUM_HIGH_PRIORITY; ++i)
+                high_priority_real = high_priority_real && !sounds.is_virtual(handles[i]);
+            check("high priority real", high_priority_real);
+            check("low priority loop virtual", sounds.is_virtual(looping));
+        }
+
+        if (elapsed > SOUND_LENGTH * 1.5) {
+            check("one shots ended", sounds.get_num_voices() == 1 && sounds.is_playing(looping));
+            check("loop got a slot", !sounds.is_virtual(looping) && sounds.get_num_virtual() == 0);
+
+            sounds.stop(looping);
+            check("all stopped", sounds.get_num_voices() == 0);
+
+            std::cout << "SoundVoiceCheck: " << (num_failed == 0 ? "passed" : "FAILED") << std::endl;
+            done = true;
+        }
+    }
+
+    void render_game_imgui() override
+    {
+        ImGui::Begin("Sound Voice Check");
+        ImGui::Text("null audio: %s", sounds.is_null() ? "yes" : "no");
+        ImGui::Text("voices:     %d / %d", sounds.get_num_voices(), sounds.get_max_voices());
+        ImGui::Text("virtual:    %d", sounds.get_num_virtual());
+        ImGui::Text("%s", done ? (num_failed == 0 ? "passed" : "FAILED") : "running");
+        ImGui::End();
+    }
+
+private:
+    static constexpr int NUM_SOUNDS = 10;
+    static constexpr int NUM_HIGH_PRIORITY = 2;
+    static constexpr int MAX_VOICES = 4;
+    static constexpr double SOUND_LENGTH = 1.0;
+
+    SoundManager sounds;
+    SoundHandle handles[NUM_SOUNDS];
+    SoundHandle looping;
+    double elapsed = 0.0;
+    bool checked_playing = false;
+    bool done = false;
+    int num_failed = 0;
+
+    void check(const char* name, bool passed)
+    {
+        if (!passed)
+            ++num_failed;
+        std::cout << "SoundVoiceCheck: " << name << (passed ? " ok" : " FAILED") << std::endl;
+    }
+};
+
+REGISTER_SCRIPT(SoundVoiceCheck)
@@ -20,8 +20,8 @@ public:
         text_node->set_text_color(LColor(1.f, 1.f, 1.f, 1.f)); // Change text color
 
         // === Optional Font ===
-        // You can load a custom font if needed
-        // text_node->set_font(FontPool::load_font("custom.ttf"));
+        // You can load a custom font if needed, glyphs are cached on disk
+        // text_node->set_font(resource_manager.load_font("custom.ttf"));
 
         // === Word Wrapping ===
         text_node->set_wordwrap(15.0f);  // Wrap text at 15 character units
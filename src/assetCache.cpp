@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include <asyncTaskManager.h>
+#include <config_putil.h>
+#include <loader.h>
+#include <nodePath.h>
+#include <pandaSystem.h>
+#include <virtualFileSystem.h>
+
+#include "assetCache.hpp"
+#include "taskUtils.hpp"
+
+// Bump when the cache layout or conversion changes
+static const int ASSET_CACHE_VERSION = 1;
+
+namespace {
+    const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    const uint64_t FNV_PRIME  = 1099511628211ULL;
+
+    uint64_t fnv1a(const unsigned char* data, size_t size, uint64_t hash = FNV_OFFSET) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= data[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    uint64_t fnv1a(const std::string& str, uint64_t hash = FNV_OFFSET) {
+        return fnv1a(reinterpret_cast<const unsigned char*>(str.data()), str.size(), hash);
+    }
+
+    std::string to_hex(uint64_t value) {
+        char buffer[17];
+        std::snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)value);
+        return buffer;
+    }
+
+    std::string get_version_tag() {
+        return PandaSystem::get_version_string() + "/" + std::to_string(ASSET_CACHE_VERSION);
+    }
+}
+
+AssetCache::AssetCache() :
+    _enabled(false),
+    _hits(0),
+    _misses(0),
+    _conversions(0),
+    _failures(0),
+    _invalidations(0) {}
+
+void AssetCache::set_cache_dir(const std::string& cache_dir) {
+    _cache_dir = Filename::from_os_specific(cache_dir);
+    _cache_dir.set_type(Filename::T_general);
+
+    // make_dir creates every directory leading up to the file
+    Filename index_file(_cache_dir, "index.txt");
+    if (!index_file.make_dir()) {
+        std::cerr << "AssetCache: could not create cache dir " << _cache_dir << std::endl;
+        _enabled = false;
+        return;
+    }
+
+    _enabled = true;
+    load_index();
+}
+
+const Filename& AssetCache::get_cache_dir() const {
+    return _cache_dir;
+}
+
+bool AssetCache::is_enabled() const {
+    return _enabled;
+}
+
+void AssetCache::set_enabled(bool enabled) {
+    _enabled = enabled && !_cache_dir.empty();
+}
+
+bool AssetCache::is_cacheable(const std::string& path) {
+    std::string lower_path = path;
+    std::transform(lower_path.begin(), lower_path.end(), lower_path.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    auto ends_with = [&lower_path](const std::string& ext) {
+        return lower_path.size() > ext.size() &&
+            lower_path.compare(lower_path.size() - ext.size(), ext.size(), ext) == 0;
+    };
+
+    return ends_with(".egg") || ends_with(".egg.pz");
+}
+
+Filename AssetCache::lookup(const std::string& source, const LoaderOptions& options, const std::string& extension) {
+    if (!_enabled)
+        return Filename();
+
+    Filename resolved = resolve(source);
+    if (resolved.empty())
+        return Filename();
+
+    Filename cache_file = get_cache_filename(source, options, extension);
+    if (cache_file.empty())
+        return Filename();
+
+    std::string source_key = resolved.get_fullpath() + extension;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _index.find(source_key);
+    if (it != _index.end()) {
+        if (it->second == cache_file.get_basename() && cache_file.exists()) {
+            ++_hits;
+            return cache_file;
+        }
+
+        // Source, options or engine changed since the entry was written
+        invalidate(source_key, cache_file.get_basename());
+    }
+
+    ++_misses;
+    return Filename();
+}
+
+void AssetCache::convert_model_async(const std::string& source, const LoaderOptions& options, const std::string& task_chain) {
+    // Load a private copy, the one handed to the caller may be
+    // modified on the main thread while this one is written out.
+    LoaderOptions convert_options = options;
+    convert_options.set_flags(convert_options.get_flags()
+        | LoaderOptions::LF_no_cache
+        | LoaderOptions::LF_report_errors);
+
+    convert_async(source, options, ".bam", task_chain,
+        [convert_options](const Filename& resolved, const Filename& output) {
+            PT(PandaNode) node = Loader::get_global_ptr()->load_sync(resolved, convert_options);
+            return node != nullptr && NodePath(node).write_bam_file(output);
+        });
+}
+
+void AssetCache::convert_async(
+    const std::string& source,
+    const LoaderOptions& options,
+    const std::string& extension,
+    const std::string& task_chain,
+    ConvertFn convert) {
+
+    if (!_enabled)
+        return;
+
+    Filename resolved = resolve(source);
+    Filename cache_file = get_cache_filename(source, options, extension);
+    if (resolved.empty() || cache_file.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_converting.insert(cache_file.get_fullpath()).second)
+            return;
+    }
+
+    PT(AsyncTask) task = make_task([this, resolved, cache_file, extension, convert](AsyncTask*) -> AsyncTask::DoneStatus {
+        // Write to a temporary file first so a reader never sees a partial
+        // file, the extension is kept since writers pick the format by it.
+        Filename temp_file(_cache_dir, "tmp_" + cache_file.get_basename());
+        bool written = convert(resolved, temp_file);
+        if (written) {
+            cache_file.unlink();
+            written = temp_file.rename_to(cache_file);
+        }
+
+        if (written) {
+            ++_conversions;
+            commit(resolved.get_fullpath() + extension, cache_file);
+        } else {
+            ++_failures;
+            temp_file.unlink();
+            std::lock_guard<std::mutex> lock(_mutex);
+            _converting.erase(cache_file.get_fullpath());
+        }
+
+        return AsyncTask::DS_done;
+    }, "AssetCacheConvert:" + resolved.get_basename());
+
+    task->set_task_chain(task_chain);
+    task->set_priority(-100);
+    AsyncTaskManager::get_global_ptr()->add(task);
+}
+
+Filename AssetCache::get_cache_filename(const std::string& source, const LoaderOptions& options, const std::string& extension) {
+    Filename resolved = resolve(source);
+    if (resolved.empty())
+        return Filename();
+
+    std::string key = make_key(resolved, options, extension);
+    if (key.empty())
+        return Filename();
+
+    // e.g. 'ralph_<key>.bam', the name is only there to help debugging
+    std::string name = resolved.get_basename_wo_extension();
+    size_t dot = name.find('.');
+    if (dot != std::string::npos)
+        name.resize(dot);
+
+    return Filename(_cache_dir, name + "_" + key + extension);
+}
+
+void AssetCache::commit(const std::string& source_key, const Filename& cache_filename) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _index.find(source_key);
+    if (it != _index.end() && it->second != cache_filename.get_basename())
+        invalidate(source_key, cache_filename.get_basename());
+
+    _index[source_key] = cache_filename.get_basename();
+    _converting.erase(cache_filename.get_fullpath());
+    save_index();
+}
+
+AssetCache::Stats AssetCache::get_stats() const {
+    Stats stats;
+    stats.hits          = _hits;
+    stats.misses        = _misses;
+    stats.conversions   = _conversions;
+    stats.failures      = _failures;
+    stats.invalidations = _invalidations;
+    return stats;
+}
+
+void AssetCache::reset_stats() {
+    _hits = 0;
+    _misses = 0;
+    _conversions = 0;
+    _failures = 0;
+    _invalidations = 0;
+}
+
+Filename AssetCache::resolve(const std::string& source) const {
+    Filename filename(source);
+    if (!VirtualFileSystem::get_global_ptr()->resolve_filename(filename, get_model_path()))
+        return Filename();
+
+    return filename;
+}
+
+bool AssetCache::get_content_hash(const Filename& resolved, uint64_t& hash) {
+    VirtualFileSystem* vfs = VirtualFileSystem::get_global_ptr();
+    PT(VirtualFile) file = vfs->get_file(resolved);
+    if (file == nullptr)
+        return false;
+
+    // Hashing is cheap next to parsing but not free, only rehash when
+    // the timestamp or size of the source changes.
+    time_t mtime = file->get_timestamp();
+    std::streamsize size = file->get_file_size();
+
+    // Lookups run on loader threads too, the file is read and hashed
+    // outside the lock so they don't wait on each other's reads
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _source_infos.find(resolved.get_fullpath());
+        if (it != _source_infos.end() && it->second.mtime == mtime && it->second.size == size) {
+            hash = it->second.content_hash;
+            return true;
+        }
+    }
+
+    vector_uchar data;
+    if (!file->read_file(data, false))
+        return false;
+
+    hash = fnv1a(data.data(), data.size());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _source_infos[resolved.get_fullpath()] = { mtime, size, hash };
+    return true;
+}
+
+std::string AssetCache::make_key(const Filename& resolved, const LoaderOptions& options, const std::string& extension) {
+    uint64_t content_hash;
+    if (!get_content_hash(resolved, content_hash))
+        return std::string();
+
+    // Only the flags that change what ends up in the file are part of the key
+    int flags = options.get_flags() & ~(
+        LoaderOptions::LF_search |
+        LoaderOptions::LF_report_errors |
+        LoaderOptions::LF_no_disk_cache |
+        LoaderOptions::LF_no_ram_cache |
+        LoaderOptions::LF_allow_instance);
+
+    std::string options_key = std::to_string(flags) + ":" + std::to_string(options.get_texture_flags()) +
+        ":" + std::to_string(options.get_texture_num_views()) + ":" + extension;
+
+    uint64_t key = fnv1a(to_hex(content_hash));
+    key = fnv1a(options_key, key);
+    key = fnv1a(get_version_tag(), key);
+    return to_hex(key);
+}
+
+void AssetCache::load_index() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _index.clear();
+
+    Filename index_file(_cache_dir, "index.txt");
+    std::ifstream file(index_file.to_os_specific());
+    if (!file.is_open())
+        return;
+
+    std::string version;
+    std::getline(file, version);
+
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos)
+            continue;
+
+        _index[line.substr(0, tab)] = line.substr(tab + 1);
+    }
+    file.close();
+
+    // Entries written by another engine version are all stale
+    if (version != get_version_tag()) {
+        for (const auto& entry : _index) {
+            Filename(_cache_dir, entry.second).unlink();
+            ++_invalidations;
+        }
+        _index.clear();
+        save_index();
+    }
+}
+
+void AssetCache::save_index() {
+    Filename index_file(_cache_dir, "index.txt");
+    std::ofstream file(index_file.to_os_specific(), std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "AssetCache: could not write " << index_file << std::endl;
+        return;
+    }
+
+    file << get_version_tag() << "\n";
+    for (const auto& entry : _index) {
+        file << entry.first << "\t" << entry.second << "\n";
+    }
+}
+
+void AssetCache::invalidate(const std::string& source_key, const std::string& new_cache_file) {
+    auto it = _index.find(source_key);
+    if (it == _index.end())
+        return;
+
+    if (it->second != new_cache_file)
+        Filename(_cache_dir, it->second).unlink();
+
+    _index.erase(it);
+    ++_invalidations;
+    save_index();
+}
@@ -0,0 +1,524 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <filename.h>
+#include <subfileInfo.h>
+#include <zStream.h>
+#include <compress_string.h>
+
+#include "assetPack.hpp"
+
+TypeHandle AssetPackMount::_type_handle;
+
+namespace {
+    // Reads straight out of a block of memory, no copy is made
+    class MemoryStreamBuf : public std::streambuf {
+    public:
+        MemoryStreamBuf(const unsigned char* data, size_t size) {
+            char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+            setg(begin, begin, begin + size);
+        }
+
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+            off_type pos;
+            if (dir == std::ios_base::beg)
+                pos = off;
+            else if (dir == std::ios_base::cur)
+                pos = (gptr() - eback()) + off;
+            else
+                pos = (egptr() - eback()) + off;
+
+            return seekpos(pos_type(pos), which);
+        }
+
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+            if (!(which & std::ios_base::in) || off_type(pos) < 0 || off_type(pos) > egptr() - eback())
+                return pos_type(off_type(-1));
+
+            setg(eback(), eback() + off_type(pos), egptr());
+            return pos;
+        }
+
+        std::streamsize showmanyc() override {
+            return egptr() - gptr();
+        }
+    };
+
+    class MemoryIStream : public std::istream {
+    public:
+        MemoryIStream(const unsigned char* data, size_t size) :
+            std::istream(nullptr),
+            _buf(data, size) {
+            rdbuf(&_buf);
+        }
+
+    private:
+        MemoryStreamBuf _buf;
+    };
+
+    std::string to_pack_path(const Filename& file) {
+        std::string path = file.get_fullpath();
+        while (!path.empty() && path.front() == '/')
+            path.erase(path.begin());
+        while (!path.empty() && path.back() == '/')
+            path.pop_back();
+        return path;
+    }
+
+    bool is_compressed_format(const std::string& path) {
+        static const char* extensions[] = {
+            ".pz", ".gz", ".zip", ".png", ".jpg", ".jpeg", ".dds", ".ktx",
+            ".ogg", ".mp3", ".flac", ".mp4", ".avi", ".webm",
+        };
+
+        std::string lower_path = path;
+        std::transform(lower_path.begin(), lower_path.end(), lower_path.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        for (const char* ext : extensions) {
+            size_t ext_len = std::strlen(ext);
+            if (lower_path.size() > ext_len &&
+                lower_path.compare(lower_path.size() - ext_len, ext_len, ext) == 0)
+                return true;
+        }
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// MappedFile
+
+MappedFile::MappedFile() :
+    _data(nullptr),
+    _size(0),
+#ifdef _WIN32
+    _file(nullptr),
+    _mapping(nullptr) {}
+#else
+    _fd(-1) {}
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& os_path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(os_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    _file = file;
+    _mapping = mapping;
+    _data = static_cast<const unsigned char*>(data);
+    _size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(os_path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    _fd = fd;
+    _data = static_cast<const unsigned char*>(data);
+    _size = static_cast<size_t>(st.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (_data == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+    CloseHandle(_mapping);
+    CloseHandle(_file);
+    _mapping = nullptr;
+    _file = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(_data), _size);
+    ::close(_fd);
+    _fd = -1;
+#endif
+
+    _data = nullptr;
+    _size = 0;
+}
+
+const unsigned char* MappedFile::get_data() const {
+    return _data;
+}
+
+size_t MappedFile::get_size() const {
+    return _size;
+}
+
+bool MappedFile::is_open() const {
+    return _data != nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// AssetPack
+
+bool AssetPack::open(const std::string& os_path) {
+    close();
+
+    if (!_file.open(os_path)) {
+        std::cerr << "AssetPack: could not map " << os_path << std::endl;
+        return false;
+    }
+
+    const unsigned char* data = _file.get_data();
+    size_t size = _file.get_size();
+
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (size < sizeof(Header) || header->magic != MAGIC || header->version != VERSION ||
+        header->index_offset > size || header->index_size > size - header->index_offset ||
+        header->num_entries * sizeof(IndexEntry) > header->index_size) {
+        std::cerr << "AssetPack: " << os_path << " is not a valid pack" << std::endl;
+        _file.close();
+        return false;
+    }
+
+    const IndexEntry* entries = reinterpret_cast<const IndexEntry*>(data + header->index_offset);
+    const char* strings = reinterpret_cast<const char*>(entries + header->num_entries);
+    uint64_t strings_size = header->index_size - header->num_entries * sizeof(IndexEntry);
+
+    // Lookups and reads trust the index from here on, so a truncated or
+    // corrupt pack is rejected as a whole rather than read out of bounds
+    for (uint32_t i = 0; i < header->num_entries; ++i) {
+        const IndexEntry& entry = entries[i];
+        bool valid =
+            entry.path_offset <= strings_size && entry.path_length <= strings_size - entry.path_offset &&
+            entry.data_offset <= size && entry.stored_size <= size - entry.data_offset;
+
+        // find() binary searches, paths must be sorted
+        if (valid && i > 0) {
+            const IndexEntry& previous = entries[i - 1];
+            valid = std::string_view(strings + previous.path_offset, previous.path_length) <
+                std::string_view(strings + entry.path_offset, entry.path_length);
+        }
+
+        if (!valid) {
+            std::cerr << "AssetPack: " << os_path << " has a corrupt index entry " << i << std::endl;
+            _file.close();
+            return false;
+        }
+    }
+
+    _os_path = os_path;
+    _header = header;
+    _entries = entries;
+    _strings = strings;
+
+    // Every directory leading up to an entry lists the next path component
+    _directories.clear();
+    _directories[""];
+    for (uint32_t i = 0; i < header->num_entries; ++i) {
+        std::string path = get_path(_entries[i]);
+
+        size_t start = 0;
+        size_t slash;
+        while ((slash = path.find('/', start)) != std::string::npos) {
+            _directories[path.substr(0, start > 0 ? start - 1 : 0)].push_back(path.substr(start, slash - start));
+            start = slash + 1;
+        }
+        _directories[path.substr(0, start > 0 ? start - 1 : 0)].push_back(path.substr(start));
+    }
+
+    for (auto& pair : _directories) {
+        std::vector<std::string>& names = pair.second;
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+    }
+
+    return true;
+}
+
+void AssetPack::close() {
+    _file.close();
+    _header = nullptr;
+    _entries = nullptr;
+    _strings = nullptr;
+    _directories.clear();
+}
+
+bool AssetPack::is_open() const {
+    return _header != nullptr;
+}
+
+const std::string& AssetPack::get_os_path() const {
+    return _os_path;
+}
+
+const AssetPack::IndexEntry* AssetPack::find(const std::string& path) const {
+    if (_header == nullptr)
+        return nullptr;
+
+    // the index is sorted by path
+    const IndexEntry* begin = _entries;
+    const IndexEntry* end = _entries + _header->num_entries;
+    std::string_view key(path);
+
+    const IndexEntry* it = std::lower_bound(begin, end, key,
+        [this](const IndexEntry& entry, std::string_view key) {
+            return std::string_view(_strings + entry.path_offset, entry.path_length) < key;
+        });
+
+    if (it != end && std::string_view(_strings + it->path_offset, it->path_length) == key)
+        return it;
+    return nullptr;
+}
+
+bool AssetPack::is_directory(const std::string& path) const {
+    return _directories.count(path) != 0;
+}
+
+std::string AssetPack::get_path(const IndexEntry& entry) const {
+    return std::string(_strings + entry.path_offset, entry.path_length);
+}
+
+size_t AssetPack::get_num_entries() const {
+    return _header != nullptr ? _header->num_entries : 0;
+}
+
+const unsigned char* AssetPack::get_stored_data(const IndexEntry& entry) const {
+    return _file.get_data() + entry.data_offset;
+}
+
+void AssetPack::list_directory(const std::string& dir, std::vector<std::string>& names) const {
+    auto it = _directories.find(dir);
+    if (it != _directories.end())
+        names.insert(names.end(), it->second.begin(), it->second.end());
+}
+
+bool AssetPack::write(
+    const std::string& os_path,
+    std::vector<Input> inputs,
+    bool compress,
+    uint32_t alignment) {
+
+    alignment = std::max(alignment, 1u);
+
+    std::sort(inputs.begin(), inputs.end(), [](const Input& a, const Input& b) {
+        return a.path < b.path;
+    });
+    inputs.erase(std::unique(inputs.begin(), inputs.end(), [](const Input& a, const Input& b) {
+        return a.path == b.path;
+    }), inputs.end());
+
+    std::ofstream out(os_path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "AssetPack: could not write " << os_path << std::endl;
+        return false;
+    }
+
+    Header header = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<IndexEntry> entries;
+    std::string strings;
+    uint64_t offset = sizeof(header);
+
+    for (const Input& input : inputs) {
+        std::ifstream in(input.os_path, std::ios::binary);
+        if (!in.is_open()) {
+            std::cerr << "AssetPack: could not read " << input.os_path << std::endl;
+            return false;
+        }
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        IndexEntry entry = {};
+        entry.path_offset = static_cast<uint32_t>(strings.size());
+        entry.path_length = static_cast<uint32_t>(input.path.size());
+        entry.original_size = data.size();
+        entry.timestamp = static_cast<uint32_t>(Filename::from_os_specific(input.os_path).get_timestamp());
+        strings += input.path;
+
+#ifdef HAVE_ZLIB
+        if (compress && !is_compressed_format(input.path) && !data.empty()) {
+            std::string compressed = compress_string(data, 6);
+            if (compressed.size() <= data.size() - data.size() / 8) {
+                data = std::move(compressed);
+                entry.flags |= EF_compressed;
+            }
+        }
+#endif
+
+        // pad so the entry starts aligned in the mapped file
+        uint64_t padding = (alignment - offset % alignment) % alignment;
+        static const char zeros[256] = {};
+        for (uint64_t left = padding; left > 0; left -= std::min<uint64_t>(left, sizeof(zeros)))
+            out.write(zeros, std::min<uint64_t>(left, sizeof(zeros)));
+        offset += padding;
+
+        entry.data_offset = offset;
+        entry.stored_size = data.size();
+        out.write(data.data(), data.size());
+        offset += data.size();
+
+        entries.push_back(entry);
+    }
+
+    uint64_t padding = (8 - offset % 8) % 8;
+    out.write("\0\0\0\0\0\0\0\0", padding);
+    offset += padding;
+
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.num_entries = static_cast<uint32_t>(entries.size());
+    header.alignment = alignment;
+    header.index_offset = offset;
+    header.index_size = entries.size() * sizeof(IndexEntry) + strings.size();
+
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(IndexEntry));
+    out.write(strings.data(), strings.size());
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return out.good();
+}
+
+// ---------------------------------------------------------------------------
+// AssetPackMount
+
+AssetPackMount::AssetPackMount(std::shared_ptr<AssetPack> pack) :
+    _pack(std::move(pack)) {
+    init_type();
+}
+
+bool AssetPackMount::has_file(const Filename& file) const {
+    std::string path = to_pack_path(file);
+    return _pack->find(path) != nullptr || _pack->is_directory(path);
+}
+
+bool AssetPackMount::is_directory(const Filename& file) const {
+    return _pack->is_directory(to_pack_path(file));
+}
+
+bool AssetPackMount::is_regular_file(const Filename& file) const {
+    return _pack->find(to_pack_path(file)) != nullptr;
+}
+
+bool AssetPackMount::read_file(const Filename& file, bool do_uncompress, vector_uchar& result) const {
+    const AssetPack::IndexEntry* entry = _pack->find(to_pack_path(file));
+    if (entry == nullptr)
+        return false;
+
+    // Compressed entries and '.pz' files go through the decompressing stream
+    if ((entry->flags & AssetPack::EF_compressed) || (do_uncompress && file.get_extension() == "pz"))
+        return VirtualFileMount::read_file(file, do_uncompress, result);
+
+    const unsigned char* data = _pack->get_stored_data(*entry);
+    result.assign(data, data + entry->stored_size);
+    return true;
+}
+
+std::istream* AssetPackMount::open_read_file(const Filename& file) const {
+    const AssetPack::IndexEntry* entry = _pack->find(to_pack_path(file));
+    if (entry == nullptr)
+        return nullptr;
+
+    std::istream* stream = new MemoryIStream(_pack->get_stored_data(*entry), entry->stored_size);
+
+#ifdef HAVE_ZLIB
+    if (entry->flags & AssetPack::EF_compressed)
+        stream = new IDecompressStream(stream, true);
+#endif
+
+    return stream;
+}
+
+std::streamsize AssetPackMount::get_file_size(const Filename& file, std::istream*) const {
+    return get_file_size(file);
+}
+
+std::streamsize AssetPackMount::get_file_size(const Filename& file) const {
+    const AssetPack::IndexEntry* entry = _pack->find(to_pack_path(file));
+    return entry != nullptr ? static_cast<std::streamsize>(entry->original_size) : 0;
+}
+
+time_t AssetPackMount::get_timestamp(const Filename& file) const {
+    const AssetPack::IndexEntry* entry = _pack->find(to_pack_path(file));
+    return entry != nullptr ? static_cast<time_t>(entry->timestamp) : 0;
+}
+
+bool AssetPackMount::get_system_info(const Filename& file, SubfileInfo& info) {
+    // Lets code that wants an OS file (e.g. audio, movies) read the
+    // entry's byte range of the pack directly.
+    const AssetPack::IndexEntry* entry = _pack->find(to_pack_path(file));
+    if (entry == nullptr || (entry->flags & AssetPack::EF_compressed))
+        return false;
+
+    info = SubfileInfo(Filename::from_os_specific(_pack->get_os_path()), entry->data_offset, entry->stored_size);
+    return true;
+}
+
+bool AssetPackMount::scan_directory(vector_string& contents, const Filename& dir) const {
+    std::string path = to_pack_path(dir);
+    if (!_pack->is_directory(path))
+        return false;
+
+    std::vector<std::string> names;
+    _pack->list_directory(path, names);
+    contents.insert(contents.end(), names.begin(), names.end());
+    return true;
+}
+
+void AssetPackMount::output(std::ostream& out) const {
+    out << "AssetPackMount(" << _pack->get_os_path() << ")";
+}
+
+const std::shared_ptr<AssetPack>& AssetPackMount::get_pack() const {
+    return _pack;
+}
@@ -0,0 +1,65 @@
+#include "asyncLoad.hpp"
+
+AsyncLoad::AsyncLoad(Type type, const std::string& path, int priority) :
+    _type(type),
+    _path(path),
+    _priority(priority),
+    _cancelled(false),
+    _delivered(false) {}
+
+bool AsyncLoad::is_ready() const {
+    return _cancelled || _task == nullptr || _task->done();
+}
+
+AsyncLoad::Status AsyncLoad::get_status() const {
+    if (_cancelled)
+        return CANCELLED;
+
+    if (!is_ready())
+        return PENDING;
+
+    bool loaded = (_type == MODEL) ? !get_model().is_empty() : get_texture() != nullptr;
+    return loaded ? LOADED : FAILED;
+}
+
+void AsyncLoad::cancel() {
+    if (_cancelled || _delivered)
+        return;
+
+    // The callback is never delivered for a cancelled load, if the loader
+    // thread already started on it the result is simply dropped. Only the
+    // cancel callback of a batch is still delivered.
+    _cancelled = true;
+    _callback = nullptr;
+    if (_task != nullptr && !_task->done())
+        _task->cancel();
+}
+
+NodePath AsyncLoad::get_model() const {
+    if (_cancelled || _type != MODEL)
+        return NodePath();
+
+    if (_model == nullptr || !is_ready())
+        return NodePath();
+
+    return NodePath(_model);
+}
+
+PT(Texture) AsyncLoad::get_texture() const {
+    if (_cancelled || _type != TEXTURE || !is_ready())
+        return nullptr;
+
+    return _texture;
+}
+
+AsyncLoad::Type AsyncLoad::get_type() const {
+    return _type;
+}
+
+const std::string& AsyncLoad::get_path() const {
+    return _path;
+}
+
+int AsyncLoad::get_priority() const {
+    return _priority;
+}
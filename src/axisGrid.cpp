@@ -1,4 +1,11 @@
 #include <geomNode.h>
+#include <geom.h>
+#include <geomTriangles.h>
+#include <geomVertexData.h>
+#include <geomVertexWriter.h>
+#include <omniBoundingVolume.h>
+#include <shader.h>
+#include <transparencyAttrib.h>
 #include "axisGrid.hpp"
 
 
@@ -8,6 +15,8 @@ AxisGrid::AxisGrid(float grid_size, float grid_step, int sub_divisions)
       grid_step(grid_step),
       sub_divisions(sub_divisions),
       show_end_cap_lines(true),
+      shader_grid(false),
+      fade_distance(40),
       x_axis_color(1, 0, 0, 1),
       y_axis_color(0, 1, 0, 1),
       grid_color(0.4, 0.4, 0.4, 1),
@@ -16,7 +25,72 @@ AxisGrid::AxisGrid(float grid_size, float grid_step, int sub_divisions)
       grid_thickness(1),
       sub_div_thickness(1) {}
 
-void AxisGrid::create() {
+void AxisGrid::create(bool use_shader) {
+    shader_grid = use_shader && _create_shader_grid();
+    if (!shader_grid)
+        _create_line_grid();
+}
+
+bool AxisGrid::is_shader_grid() const {
+    return shader_grid;
+}
+
+void AxisGrid::set_fade_distance(float fade_distance) {
+    this->fade_distance = fade_distance;
+    if (shader_grid)
+        find("AxisGridQuad").set_shader_input("fade_distance", LVecBase4(fade_distance, 0, 0, 0));
+}
+
+bool AxisGrid::_create_shader_grid() {
+    PT(Shader) shader = Shader::load(
+        Shader::SL_GLSL,
+        Filename("shaders/axis_grid.vert.glsl"),
+        Filename("shaders/axis_grid.frag.glsl"));
+
+    if (shader == nullptr)
+        return false;
+
+    // Quad in clip space, the vertex shader passes it through
+    PT(GeomVertexData) vdata = new GeomVertexData("AxisGrid", GeomVertexFormat::get_v3(), Geom::UH_static);
+    vdata->unclean_set_num_rows(4);
+    GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+    vertex.set_data3(-1, -1, 0);
+    vertex.set_data3( 1, -1, 0);
+    vertex.set_data3( 1,  1, 0);
+    vertex.set_data3(-1,  1, 0);
+
+    PT(GeomTriangles) triangles = new GeomTriangles(Geom::UH_static);
+    triangles->add_vertices(0, 1, 2);
+    triangles->add_vertices(0, 2, 3);
+
+    PT(Geom) geom = new Geom(vdata);
+    geom->add_primitive(triangles);
+
+    // Covers the screen whatever its vertices say, so it is never culled
+    PT(GeomNode) geom_node = new GeomNode("AxisGridQuad");
+    geom_node->add_geom(geom);
+    geom_node->set_bounds(new OmniBoundingVolume());
+    geom_node->set_final(true);
+
+    NodePath quad = attach_new_node(geom_node);
+    quad.set_shader(shader);
+    quad.set_shader_input("grid_step", LVecBase4(grid_step, 0, 0, 0));
+    quad.set_shader_input("sub_divisions", LVecBase4(float(sub_divisions), 0, 0, 0));
+    quad.set_shader_input("fade_distance", LVecBase4(fade_distance, 0, 0, 0));
+    quad.set_shader_input("x_axis_color", x_axis_color);
+    quad.set_shader_input("y_axis_color", y_axis_color);
+    quad.set_shader_input("grid_color", grid_color);
+    quad.set_shader_input("sub_div_color", sub_div_color);
+
+    // Depth tested against the scene (the shader writes the plane's
+    // depth) but never hides anything itself
+    quad.set_transparency(TransparencyAttrib::M_alpha);
+    quad.set_depth_write(false);
+    quad.set_two_sided(true);
+    return true;
+}
+
+void AxisGrid::_create_line_grid() {
     // Set thickness
     axis_lines.set_thickness(axis_thickness);
     grid_lines.set_thickness(grid_thickness);
@@ -0,0 +1,284 @@
+#include <iostream>
+#include <new>
+#include <clockObject.h>
+
+#include "coTask.hpp"
+
+// ------------------------------------ CoFramePool ------------------------------------ //
+namespace {
+    constexpr std::size_t FRAME_SIZE_CLASSES[] = { 128, 256, 512, 1024, 2048, 4096 };
+    constexpr int NUM_SIZE_CLASSES = sizeof(FRAME_SIZE_CLASSES) / sizeof(FRAME_SIZE_CLASSES[0]);
+    constexpr int BLOCKS_PER_CHUNK = 16;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct PoolState {
+        FreeBlock* free_lists[NUM_SIZE_CLASSES] = {};
+        size_t     num_free[NUM_SIZE_CLASSES] = {};
+    };
+
+    PoolState& get_pool() {
+        static PoolState pool;
+        return pool;
+    }
+
+    int get_size_class(std::size_t size) {
+        for (int i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            if (size <= FRAME_SIZE_CLASSES[i])
+                return i;
+        }
+        return -1;
+    }
+}
+
+void* CoFramePool::allocate(std::size_t size) {
+    int size_class = get_size_class(size);
+    if (size_class < 0)
+        return ::operator new(size);
+
+    PoolState& pool = get_pool();
+    if (pool.free_lists[size_class] == nullptr) {
+        // Refill this size class with a new batch of blocks, each block is
+        // allocated separately so that trim() can give them back one by one.
+        for (int i = 0; i < BLOCKS_PER_CHUNK; ++i) {
+            FreeBlock* block = static_cast<FreeBlock*>(::operator new(FRAME_SIZE_CLASSES[size_class]));
+            block->next = pool.free_lists[size_class];
+            pool.free_lists[size_class] = block;
+        }
+        pool.num_free[size_class] += BLOCKS_PER_CHUNK;
+    }
+
+    FreeBlock* block = pool.free_lists[size_class];
+    pool.free_lists[size_class] = block->next;
+    pool.num_free[size_class]--;
+    return block;
+}
+
+void CoFramePool::deallocate(void* ptr, std::size_t size) {
+    if (ptr == nullptr)
+        return;
+
+    int size_class = get_size_class(size);
+    if (size_class < 0) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    PoolState& pool = get_pool();
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = pool.free_lists[size_class];
+    pool.free_lists[size_class] = block;
+    pool.num_free[size_class]++;
+}
+
+void CoFramePool::trim() {
+    PoolState& pool = get_pool();
+    for (int i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        while (pool.free_lists[i] != nullptr) {
+            FreeBlock* block = pool.free_lists[i];
+            pool.free_lists[i] = block->next;
+            ::operator delete(block);
+        }
+        pool.num_free[i] = 0;
+    }
+}
+
+// ------------------------------------ CoTask ------------------------------------ //
+void CoTask::promise_type::unhandled_exception() {
+    std::cerr << "CoTask: unhandled exception in coroutine, coroutine stopped." << std::endl;
+    state->done = true;
+}
+
+void CoTask::cancel() {
+    if (!state || state->done || state->cancelled)
+        return;
+
+    // A coroutine suspended in the scheduler is destroyed right away,
+    // if it is currently running it will be destroyed at its next co_await.
+    state->cancelled = true;
+    CoScheduler::get_instance().reap_cancelled();
+}
+
+// ------------------------------------ CoScheduler ------------------------------------ //
+CoScheduler& CoScheduler::get_instance() {
+    static CoScheduler instance;
+    return instance;
+}
+
+void CoScheduler::tick() {
+    ++_frame_count;
+    double now = ClockObject::get_global_clock()->get_frame_time();
+
+    _resume_list.clear();
+    _resume_list.swap(_ready);
+
+    // frame waiters
+    for (size_t i = 0; i < _frame_waiters.size(); ) {
+        if (_frame_waiters[i].first <= _frame_count) {
+            _resume_list.push_back(_frame_waiters[i].second);
+            _frame_waiters[i] = _frame_waiters.back();
+            _frame_waiters.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    // timed waiters, ordered by wake up time
+    while (!_timed_waiters.empty() && _timed_waiters.begin()->first <= now) {
+        _resume_list.push_back(_timed_waiters.begin()->second);
+        _timed_waiters.erase(_timed_waiters.begin());
+    }
+
+    // async resource loads
+    for (size_t i = 0; i < _load_waiters.size(); ) {
+        if (_load_waiters[i].first->is_ready()) {
+            _resume_list.push_back(_load_waiters[i].second);
+            _load_waiters[i] = std::move(_load_waiters.back());
+            _load_waiters.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    // Resumed coroutines may suspend again, which only touches the waiter
+    // lists, never _resume_list, so iterating it here is safe.
+    for (CoTask::Handle handle : _resume_list) {
+        resume(handle);
+    }
+    _resume_list.clear();
+}
+
+void CoScheduler::on_event(const std::string& event_name) {
+    auto range = _event_waiters.equal_range(event_name);
+    if (range.first == range.second)
+        return;
+
+    // Don't resume from inside event dispatch, handlers may be modifying
+    // the event tables, wake up on the next tick instead.
+    for (auto it = range.first; it != range.second; ++it) {
+        _ready.push_back(it->second);
+    }
+    _event_waiters.erase(range.first, range.second);
+}
+
+void CoScheduler::clear() {
+    for (auto& waiter : _frame_waiters) waiter.second.destroy();
+    for (auto& waiter : _timed_waiters) waiter.second.destroy();
+    for (auto& waiter : _event_waiters) waiter.second.destroy();
+    for (auto& waiter : _load_waiters)  waiter.second.destroy();
+    for (auto& handle : _ready)         handle.destroy();
+
+    _frame_waiters.clear();
+    _timed_waiters.clear();
+    _event_waiters.clear();
+    _load_waiters.clear();
+    _ready.clear();
+
+    CoFramePool::trim();
+}
+
+void CoScheduler::wait_frames(CoTask::Handle handle, int num_frames) {
+    if (destroy_if_cancelled(handle))
+        return;
+    _frame_waiters.emplace_back(_frame_count + num_frames, handle);
+}
+
+void CoScheduler::wait_seconds(CoTask::Handle handle, double seconds) {
+    if (destroy_if_cancelled(handle))
+        return;
+    double now = ClockObject::get_global_clock()->get_frame_time();
+    _timed_waiters.emplace(now + seconds, handle);
+}
+
+void CoScheduler::wait_event(CoTask::Handle handle, const std::string& event_name) {
+    if (destroy_if_cancelled(handle))
+        return;
+    _event_waiters.emplace(event_name, handle);
+}
+
+void CoScheduler::wait_load(CoTask::Handle handle, const AsyncLoadHandle& load) {
+    if (destroy_if_cancelled(handle))
+        return;
+    _load_waiters.emplace_back(load, handle);
+}
+
+size_t CoScheduler::get_num_waiting() const {
+    return _frame_waiters.size() +
+        _timed_waiters.size() +
+        _event_waiters.size() +
+        _load_waiters.size() +
+        _ready.size();
+}
+
+unsigned long long CoScheduler::get_frame_count() const {
+    return _frame_count;
+}
+
+void CoScheduler::resume(CoTask::Handle handle) {
+    if (destroy_if_cancelled(handle))
+        return;
+    handle.resume();
+}
+
+bool CoScheduler::destroy_if_cancelled(CoTask::Handle handle) {
+    // A coroutine that cancelled itself while running is destroyed
+    // as soon as it suspends again.
+    if (!handle.promise().state->cancelled)
+        return false;
+    handle.destroy();
+    return true;
+}
+
+void CoScheduler::reap_cancelled() {
+    auto is_cancelled = [](CoTask::Handle handle) { return handle.promise().state->cancelled; };
+
+    for (size_t i = 0; i < _frame_waiters.size(); ) {
+        if (is_cancelled(_frame_waiters[i].second)) {
+            _frame_waiters[i].second.destroy();
+            _frame_waiters[i] = _frame_waiters.back();
+            _frame_waiters.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    for (auto it = _timed_waiters.begin(); it != _timed_waiters.end(); ) {
+        if (is_cancelled(it->second)) {
+            it->second.destroy();
+            it = _timed_waiters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = _event_waiters.begin(); it != _event_waiters.end(); ) {
+        if (is_cancelled(it->second)) {
+            it->second.destroy();
+            it = _event_waiters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (size_t i = 0; i < _load_waiters.size(); ) {
+        if (is_cancelled(_load_waiters[i].second)) {
+            _load_waiters[i].second.destroy();
+            _load_waiters[i] = std::move(_load_waiters.back());
+            _load_waiters.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    for (size_t i = 0; i < _ready.size(); ) {
+        if (is_cancelled(_ready[i])) {
+            _ready[i].destroy();
+            _ready[i] = _ready.back();
+            _ready.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
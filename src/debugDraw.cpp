@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <geomLines.h>
+#include <geomNode.h>
+#include <geomVertexArrayDataHandle.h>
+#include <mathNumbers.h>
+#include <omniBoundingVolume.h>
+#include <textNode.h>
+
+#include "debugDraw.hpp"
+
+namespace {
+    const char* BATCH_NAMES[] = { "DebugDrawWorld", "DebugDrawOverlay", "DebugDrawScreen" };
+
+    // Overlays go after everything else, including transparent geometry
+    const int OVERLAY_SORT = 100;
+
+    unsigned char to_byte(PN_stdfloat value) {
+        return static_cast<unsigned char>(std::min(std::max(value, PN_stdfloat(0)), PN_stdfloat(1)) * 255.0f + 0.5f);
+    }
+}
+
+DebugDraw::DebugDraw() :
+    _enabled(true),
+    _num_labels(0),
+    _num_shown_slots(0),
+    _num_lines(0) {}
+
+DebugDraw::~DebugDraw() {
+    shutdown();
+}
+
+void DebugDraw::initialize(NodePath world_root, NodePath screen_root) {
+    shutdown();
+
+    // Vertices are copied into the buffer as they are
+    const GeomVertexFormat* format = GeomVertexFormat::get_v3c4();
+    if (format->get_array(0)->get_stride() != int(sizeof(Vertex))) {
+        std::cerr << "DebugDraw: unexpected vertex format stride" << std::endl;
+        return;
+    }
+
+    // Lines and text are unlit and never get the auto shader
+    _world_root = world_root.attach_new_node("DebugDraw");
+    _world_root.set_light_off(1);
+    _world_root.set_shader_off(1);
+    _world_root.set_depth_write(false);
+
+    _screen_root = screen_root.attach_new_node("DebugDraw2D");
+    _screen_root.set_bin("fixed", OVERLAY_SORT);
+
+    for (int i = 0; i < NUM_BATCHES; ++i) {
+        LineBatch& batch = _batches[i];
+
+        batch.vdata = new GeomVertexData(BATCH_NAMES[i], format, Geom::UH_stream);
+        PT(GeomLines) lines = new GeomLines(Geom::UH_stream);
+        batch.geom = new Geom(batch.vdata);
+        batch.geom->add_primitive(lines);
+
+        // Lines go anywhere, bounds are not worth computing every frame
+        PT(GeomNode) geom_node = new GeomNode(BATCH_NAMES[i]);
+        geom_node->add_geom(batch.geom);
+        geom_node->set_bounds(new OmniBoundingVolume());
+        geom_node->set_final(true);
+
+        // Flat coloured, labels keep their font texture
+        batch.np = (i == SCREEN ? _screen_root : _world_root).attach_new_node(geom_node);
+        batch.np.set_texture_off(1);
+        batch.np.hide();
+    }
+
+    _batches[WORLD_OVERLAY].np.set_depth_test(false);
+    _batches[WORLD_OVERLAY].np.set_bin("fixed", OVERLAY_SORT);
+
+    set_enabled(_enabled);
+}
+
+void DebugDraw::shutdown() {
+    clear();
+
+    for (LineBatch& batch : _batches) {
+        batch.vertices = std::vector<Vertex>();
+        batch.vdata = nullptr;
+        batch.geom = nullptr;
+        batch.np = NodePath();
+    }
+
+    _text_slots.clear();
+    _num_shown_slots = 0;
+    _num_lines = 0;
+
+    if (!_world_root.is_empty())
+        _world_root.remove_node();
+    if (!_screen_root.is_empty())
+        _screen_root.remove_node();
+}
+
+void DebugDraw::set_screen_root(NodePath screen_root) {
+    if (!_screen_root.is_empty())
+        _screen_root.reparent_to(screen_root);
+}
+
+void DebugDraw::set_enabled(bool enabled) {
+    _enabled = enabled;
+    if (!enabled)
+        clear();
+
+    if (!_world_root.is_empty()) {
+        enabled ? _world_root.show() : _world_root.hide();
+        enabled ? _screen_root.show() : _screen_root.hide();
+    }
+}
+
+bool DebugDraw::is_enabled() const {
+    return _enabled;
+}
+
+void DebugDraw::line(const LPoint3& from, const LPoint3& to, const LColor& color, Mode mode) {
+    add_line(world_batch(mode), from, to, color);
+}
+
+void DebugDraw::box(const LPoint3& min_point, const LPoint3& max_point, const LColor& color, Mode mode) {
+    box(LMatrix4::ident_mat(), min_point, max_point, color, mode);
+}
+
+void DebugDraw::box(const LMatrix4& transform, const LPoint3& min_point, const LPoint3& max_point, const LColor& color, Mode mode) {
+    if (!_enabled)
+        return;
+
+    // Corner i has the max of axis n where bit n is set
+    LPoint3 corners[8];
+    for (int i = 0; i < 8; ++i) {
+        LPoint3 corner(
+            (i & 1) ? max_point[0] : min_point[0],
+            (i & 2) ? max_point[1] : min_point[1],
+            (i & 4) ? max_point[2] : min_point[2]);
+        corners[i] = transform.xform_point(corner);
+    }
+
+    static const int EDGES[12][2] = {
+        {0, 1}, {2, 3}, {4, 5}, {6, 7},
+        {0, 2}, {1, 3}, {4, 6}, {5, 7},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}
+    };
+
+    Batch batch = world_batch(mode);
+    for (const int* edge : EDGES)
+        add_line(batch, corners[edge[0]], corners[edge[1]], color);
+}
+
+void DebugDraw::sphere(const LPoint3& center, float radius, const LColor& color, Mode mode, int segments) {
+    if (!_enabled)
+        return;
+
+    segments = std::max(segments, 4);
+    if (int(_circle.size()) != segments + 1) {
+        _circle.resize(segments + 1);
+        for (int i = 0; i <= segments; ++i) {
+            float angle = 2.0f * MathNumbers::pi_f * float(i) / float(segments);
+            _circle[i] = LVecBase2(std::cos(angle), std::sin(angle));
+        }
+    }
+
+    Batch batch = world_batch(mode);
+    for (int i = 0; i < segments; ++i) {
+        LVecBase2 a = _circle[i] * radius;
+        LVecBase2 b = _circle[i + 1] * radius;
+        add_line(batch, center + LVector3(a[0], a[1], 0), center + LVector3(b[0], b[1], 0), color);
+        add_line(batch, center + LVector3(a[0], 0, a[1]), center + LVector3(b[0], 0, b[1]), color);
+        add_line(batch, center + LVector3(0, a[0], a[1]), center + LVector3(0, b[0], b[1]), color);
+    }
+}
+
+void DebugDraw::arrow(const LPoint3& from, const LPoint3& to, const LColor& color, Mode mode, float head_size) {
+    if (!_enabled)
+        return;
+
+    Batch batch = world_batch(mode);
+    add_line(batch, from, to, color);
+
+    LVector3 direction = to - from;
+    PN_stdfloat length = direction.length();
+    if (length <= 0)
+        return;
+    direction /= length;
+
+    // Any two directions across the shaft
+    LVector3 up = std::abs(direction[2]) < 0.9f ? LVector3::up() : LVector3::right();
+    LVector3 side = direction.cross(up).normalized();
+    up = side.cross(direction);
+
+    PN_stdfloat head = length * head_size;
+    LPoint3 base = to - direction * head;
+    side *= head * 0.5f;
+    up *= head * 0.5f;
+
+    add_line(batch, to, base + side, color);
+    add_line(batch, to, base - side, color);
+    add_line(batch, to, base + up, color);
+    add_line(batch, to, base - up, color);
+}
+
+void DebugDraw::axes(const LMatrix4& transform, float size, Mode mode) {
+    if (!_enabled)
+        return;
+
+    Batch batch = world_batch(mode);
+    LPoint3 origin = transform.xform_point(LPoint3(0));
+    add_line(batch, origin, transform.xform_point(LPoint3(size, 0, 0)), LColor(1, 0, 0, 1));
+    add_line(batch, origin, transform.xform_point(LPoint3(0, size, 0)), LColor(0, 1, 0, 1));
+    add_line(batch, origin, transform.xform_point(LPoint3(0, 0, size)), LColor(0, 0, 1, 1));
+}
+
+void DebugDraw::text(const LPoint3& pos, const std::string& text, const LColor& color, Mode mode, float scale) {
+    add_label(world_batch(mode), pos, text, color, scale);
+}
+
+void DebugDraw::line_2d(const LPoint2& from, const LPoint2& to, const LColor& color) {
+    // Pixel roots have y going up
+    add_line(SCREEN, LPoint3(from[0], 0, -from[1]), LPoint3(to[0], 0, -to[1]), color);
+}
+
+void DebugDraw::rect_2d(const LPoint2& min_point, const LPoint2& max_point, const LColor& color) {
+    line_2d(LPoint2(min_point[0], min_point[1]), LPoint2(max_point[0], min_point[1]), color);
+    line_2d(LPoint2(max_point[0], min_point[1]), LPoint2(max_point[0], max_point[1]), color);
+    line_2d(LPoint2(max_point[0], max_point[1]), LPoint2(min_point[0], max_point[1]), color);
+    line_2d(LPoint2(min_point[0], max_point[1]), LPoint2(min_point[0], min_point[1]), color);
+}
+
+void DebugDraw::text_2d(const LPoint2& pos, const std::string& text, const LColor& color, float scale) {
+    // 'pos' is the top left, text is placed by its baseline
+    add_label(SCREEN, LPoint3(pos[0], 0, -pos[1] - scale * 0.8f), text, color, scale);
+}
+
+void DebugDraw::update() {
+    if (_world_root.is_empty())
+        return;
+
+    _num_lines = 0;
+    for (LineBatch& batch : _batches) {
+        upload(batch);
+        _num_lines += int(batch.vertices.size() / 2);
+        batch.vertices.clear();
+    }
+
+    update_labels();
+    _num_labels = 0;
+}
+
+void DebugDraw::clear() {
+    for (LineBatch& batch : _batches)
+        batch.vertices.clear();
+    _num_labels = 0;
+}
+
+int DebugDraw::get_num_lines() const {
+    return _num_lines;
+}
+
+int DebugDraw::get_num_labels() const {
+    return int(_num_shown_slots);
+}
+
+void DebugDraw::add_line(Batch batch, const LPoint3& from, const LPoint3& to, const LColor& color) {
+    if (!_enabled)
+        return;
+
+    Vertex vertex;
+    vertex.color[0] = to_byte(color[0]);
+    vertex.color[1] = to_byte(color[1]);
+    vertex.color[2] = to_byte(color[2]);
+    vertex.color[3] = to_byte(color[3]);
+
+    std::vector<Vertex>& vertices = _batches[batch].vertices;
+    vertex.x = from[0]; vertex.y = from[1]; vertex.z = from[2];
+    vertices.push_back(vertex);
+    vertex.x = to[0]; vertex.y = to[1]; vertex.z = to[2];
+    vertices.push_back(vertex);
+}
+
+void DebugDraw::add_label(Batch batch, const LPoint3& pos, const std::string& text, const LColor& color, float scale) {
+    if (!_enabled || text.empty())
+        return;
+
+    // Strings keep their capacity from earlier frames
+    if (_num_labels == _labels.size())
+        _labels.emplace_back();
+
+    Label& label = _labels[_num_labels++];
+    label.text.assign(text);
+    label.pos = pos;
+    label.color = color;
+    label.scale = scale;
+    label.batch = batch;
+}
+
+void DebugDraw::upload(LineBatch& batch) {
+    int num_vertices = int(batch.vertices.size());
+    if (num_vertices == 0) {
+        batch.np.hide();
+        return;
+    }
+
+    // Same buffer every frame, resized in place and written in one copy
+    batch.vdata->unclean_set_num_rows(num_vertices);
+    {
+        PT(GeomVertexArrayDataHandle) handle = batch.vdata->modify_array_handle(0);
+        std::memcpy(handle->get_write_pointer(), batch.vertices.data(), num_vertices * sizeof(Vertex));
+    }
+
+    batch.geom->modify_primitive(0)->set_nonindexed_vertices(0, num_vertices);
+    batch.np.show();
+}
+
+void DebugDraw::update_labels() {
+    for (size_t i = 0; i < _num_labels; ++i) {
+        const Label& label = _labels[i];
+
+        if (i == _text_slots.size()) {
+            TextSlot slot;
+            slot.np = NodePath(new TextNode("DebugText"));
+            slot.color = LColor(-1);
+            slot.batch = NUM_BATCHES;
+            _text_slots.push_back(slot);
+        }
+
+        TextSlot& slot = _text_slots[i];
+        TextNode* text_node = DCAST(TextNode, slot.np.node());
+
+        // Regenerating the text is the expensive part, only when it changed
+        if (slot.text != label.text) {
+            slot.text = label.text;
+            text_node->set_text(slot.text);
+        }
+
+        if (slot.batch != label.batch) {
+            slot.batch = label.batch;
+            if (label.batch == SCREEN) {
+                slot.np.reparent_to(_screen_root);
+                slot.np.clear_billboard();
+                slot.np.clear_depth_test();
+                slot.np.clear_bin();
+            }
+            else {
+                slot.np.reparent_to(_world_root);
+                slot.np.set_billboard_point_eye();
+                if (label.batch == WORLD_OVERLAY) {
+                    slot.np.set_depth_test(false);
+                    slot.np.set_bin("fixed", OVERLAY_SORT + 1);
+                }
+                else {
+                    slot.np.clear_depth_test();
+                    slot.np.clear_bin();
+                }
+            }
+        }
+
+        if (slot.color != label.color) {
+            slot.color = label.color;
+            slot.np.set_color(label.color);
+        }
+
+        slot.np.set_pos(label.pos);
+        slot.np.set_scale(label.scale);
+        slot.np.show();
+    }
+
+    // Slots past this frame's labels stay around for later frames
+    for (size_t i = _num_labels; i < _num_shown_slots; ++i)
+        _text_slots[i].np.hide();
+    _num_shown_slots = _num_labels;
+}
+
+DebugDraw::Batch DebugDraw::world_batch(Mode mode) {
+    return mode == OVERLAY ? WORLD_OVERLAY : WORLD;
+}
@@ -1,13 +1,20 @@
+#include <algorithm>
+#include <cstdlib>
 #include <asyncTask.h>
 #include <genericAsyncTask.h>
 #include <config_putil.h>
 #include <nodePath.h>
 #include <bitMask.h>
+#include <trueClock.h>
+#include <modelPool.h>
+#include <texturePool.h>
+#include <virtualFileSystem.h>
 
 #include "pathUtils.hpp"
 #include "taskUtils.hpp"
 #include "mathUtils.hpp"
 #include "helperUtils.hpp"
+#include "assetPack.hpp"
 #include "demon.hpp"
 #include "imgui.h"
 
@@ -16,17 +23,63 @@ Demon& Demon::get_instance() {
     return instance;
 }
 
-Demon::Demon() : game(*this) {    
+Demon::Demon() :
+    game(*this),
+    editor_viewport("Editor View"),
+    game_viewport("Game View") {
+
     // Load configuration
     std::string config_file = PathUtils::join_paths(
     PathUtils::get_executable_dir(),
     "game_config.txt");
     load_config(config_file);
     
+	// Frame pacing target for background work
+	if (config.count("target_fps") && std::atof(config["target_fps"].c_str()) > 0)
+		engine.idle_queue.set_target_frame_time(1.0 / std::atof(config["target_fps"].c_str()));
+
+	if (config.count("resource_budget_mb") && std::atoi(config["resource_budget_mb"].c_str()) > 0)
+		engine.resource_manager.get_registry().set_budget(size_t(std::atoi(config["resource_budget_mb"].c_str())) * 1024 * 1024);
+
+	if (config["texture_streaming"] == "on") {
+		engine.resource_manager.set_texture_streaming(true);
+		if (std::atoi(config["texture_budget_mb"].c_str()) > 0)
+			engine.resource_manager.get_texture_streamer().set_budget(
+				size_t(std::atoi(config["texture_budget_mb"].c_str())) * 1024 * 1024);
+	}
+
+	if (config.count("audio_max_voices"))
+		engine.resource_manager.get_sound_manager().set_max_voices(std::atoi(config["audio_max_voices"].c_str()));
+
+	if (config["texture_cook"] == "on") {
+		TextureCooker::Options cook_options;
+		cook_options.compress = config["texture_compress"] == "on";
+		engine.resource_manager.set_texture_cooking(true, cook_options);
+	}
+
+	// Load timings, 'load_telemetry off' stops recording, shift-t shows the panel
+	LoadTelemetry& telemetry = engine.resource_manager.get_telemetry();
+	telemetry.set_enabled(config["load_telemetry"] != "off");
+	LoadTelemetry::Thresholds thresholds;
+	if (std::atof(config["load_slow_ms"].c_str()) > 0)
+		thresholds.slow_ms = std::atof(config["load_slow_ms"].c_str());
+	if (std::atof(config["load_large_mb"].c_str()) > 0)
+		thresholds.large_bytes = size_t(std::atof(config["load_large_mb"].c_str()) * 1024 * 1024);
+	telemetry.set_thresholds(thresholds);
+
+	if (config.count("loader_threads") && std::atoi(config["loader_threads"].c_str()) > 0)
+		engine.resource_manager.set_num_loader_threads(std::atoi(config["loader_threads"].c_str()));
+
 	// Initializations
 	setup_paths();
 	init_imgui(&p3d_imgui, &engine.pixel2D, engine.mouse_watcher, "Editor");
 	game.init();
+	// 2D debug draw goes over the game view, which may cover or replace
+	// the editor's 2D region
+	engine.debug_draw.set_screen_root(game.pixel2D);
+	init_imgui(&game_imgui, &game.pixel2D, game.mouse_watcher, "Game");
+	// Laid out in the game view, like game.pixel2D, not the whole window
+	game_imgui.set_display_region(game.dr2D);
 		
 	// Setup game and editor viewport camera masks
 	BitMask32 ed_mask   = BitMask32::bit(0);
@@ -56,20 +109,66 @@ Demon::Demon() : game(*this) {
 	engine.render2D.find("**/SceneCameraAxes").hide(game_mask);
 	p3d_imgui.get_root().hide(game_mask);
 
+	_docked_views = false;
+	_show_editor_viewport = true;
+	_show_game_viewport = true;
+	if (config["docked_views"] == "on")
+		setup_docked_views();
+
+	// Editor view during game mode: 'editor_view_in_game_mode off' stops
+	// rendering it, a number in Hz lowers its rate (docked views only,
+	// a window region can't keep its last image). shift-h toggles it.
+	_editor_view_panel_shown = true;
+	_hide_editor_view_in_game = config["editor_view_in_game_mode"] == "off";
+	_editor_view_hz = std::atof(config["editor_view_hz"].c_str());
+	_editor_view_game_mode_hz = std::atof(config["editor_view_in_game_mode"].c_str());
+
+	// 'game_scene_in_editor off' keeps the editor camera's cull out of game.render
+	set_game_scene_in_editor(config["game_scene_in_editor"] != "off");
+
+	_editor_ui_time = 0.0;
+
+	// Game view resolution follows the frame time, 'dynamic_resolution on'.
+	// The target is dynres_target_ms, else target_fps, else 60 fps.
+	if (config["dynamic_resolution"] == "on") {
+		DynamicResolution::Settings dynres;
+		if (std::atof(config["dynres_target_ms"].c_str()) > 0)
+			dynres.target_frame_time = std::atof(config["dynres_target_ms"].c_str()) / 1000.0;
+		else if (std::atof(config["target_fps"].c_str()) > 0)
+			dynres.target_frame_time = 1.0 / std::atof(config["target_fps"].c_str());
+		if (std::atof(config["dynres_min_scale"].c_str()) > 0)
+			dynres.min_scale = std::atof(config["dynres_min_scale"].c_str());
+		if (std::atof(config["dynres_max_scale"].c_str()) > 0)
+			dynres.max_scale = std::atof(config["dynres_max_scale"].c_str());
+
+		// Docked, the game view panel is already offscreen and takes the scale
+		game.enable_dynamic_resolution(dynres, !_docked_views);
+	}
+
 	// Create update task
 	PT(AsyncTask) update_task =
         (make_task([this](AsyncTask *task) -> AsyncTask::DoneStatus {
 
+		double frame_start = TrueClock::get_global_ptr()->get_short_time();
+
 		engine.update();
-		engine.dispatch_events(_mouse_over_ui);
-        game.update();
+		engine.dispatch_events(_mouse_over_ui, _keyboard_over_ui);
+		engine.update_coroutines();
+        game.update(_editor_ui_time);
 		imgui_update();
+		update_editor_view();
+		update_docked_views();
+		engine.debug_draw.update();
 		engine.engine->render_frame();
 
+		// Background work only gets what is left of the frame budget
+		engine.idle_queue.run(frame_start);
+
 		_mouse_over_ui = false;
 
 		if(engine.should_repaint) {
 			p3d_imgui.should_repaint = true;
+			game_imgui.should_repaint = true;
 			
 			if(_num_frames_since_last_repait > 2) {
 				
@@ -111,24 +210,23 @@ Demon::Demon() : game(*this) {
 	_cleaned_up        = false;
 	_game_mode_enabled = false;
 	_mouse_over_ui     = false;
+	_mouse_over_game_ui = false;
+	_keyboard_over_ui  = false;
     _is_started        = false;
+	_show_load_telemetry = config["load_telemetry_panel"] == "on";
 }
 
 Demon::~Demon() { 
     if (_game_mode_enabled) {
         exit_game_mode();
 
-        PT(AsyncTask) exit_task =
-            (make_task([this](AsyncTask *task) -> AsyncTask::DoneStatus {
+        // Exit game mode schedules scripts unloading for the next frame,
+        // timers due on the same frame fire in the order they were
+        // scheduled, so exit runs right after scripts are unloaded.
+        engine.timers.after_frames(1, [this]() {
             unbind_events();
-            exit(); 
-            return AsyncTask::DS_done;
-        }, "ScriptsUnloadTask"));
-        
-        // Exit game mode also creates a task to unload scripts with delay = 0,
-        // we set delay = 1 for exit task so it executes after scripts unload task.
-        exit_task->set_delay(1);
-        AsyncTaskManager::get_global_ptr()->add(exit_task);
+            exit();
+        });
         
     } else {
         unbind_events();
@@ -157,6 +255,9 @@ void Demon::exit() {
 	if(_cleaned_up)
 		return;
     
+    editor_viewport.destroy();
+    game_viewport.destroy();
+    game_imgui.clean_up();
     p3d_imgui.clean_up();
 	engine.clean_up();
 
@@ -203,6 +304,37 @@ void Demon::setup_paths() {
         config["working_dir"],
         "assets");
     get_model_path().prepend_directory(Filename::from_os_specific(dev_assets));
+
+    // An 'assets.pack' next to an assets dir is mounted over it,
+    // files in the pack are then read from it instead of the dir.
+    for (const std::string& assets_dir : { shared_assets, project_assets, dev_assets }) {
+        Filename pack_file = Filename::from_os_specific(assets_dir + ".pack");
+        if (assets_dir.empty() || !pack_file.exists())
+            continue;
+
+        auto pack = std::make_shared<AssetPack>();
+        if (pack->open(pack_file.to_os_specific())) {
+            VirtualFileSystem::get_global_ptr()->mount(
+                new AssetPackMount(pack), Filename::from_os_specific(assets_dir), 0);
+            std::cout << "Mounted asset pack " << pack_file << "\n";
+        }
+    }
+
+    // Converted assets cache, set 'asset_cache off' in config to disable
+    if (!config["project_dir"].empty() && config["asset_cache"] != "off") {
+        std::string cache_dir = PathUtils::join_paths(config["project_dir"], ".cache");
+        engine.resource_manager.get_asset_cache().set_cache_dir(PathUtils::join_paths(cache_dir, "bam"));
+    }
+
+    // Assets the last game session loaded, prefetched on startup
+    if (!config["project_dir"].empty()) {
+        std::string cache_dir = PathUtils::join_paths(config["project_dir"], ".cache");
+        engine.resource_manager.get_prefetch_manifest().set_filename(
+            PathUtils::join_paths(cache_dir, "prefetch_manifest.txt"));
+        engine.resource_manager.prefetch();
+        engine.resource_manager.get_telemetry().set_export_filename(
+            PathUtils::join_paths(cache_dir, "load_telemetry.json"));
+    }
 }
 
 void Demon::bind_events() {
@@ -215,6 +347,13 @@ void Demon::bind_events() {
 	engine.accept("shift-d", [this]() { decrease_game_view_size();                     });
 	
     engine.accept("shift-e", [this]() { exit(); });
+    engine.accept("shift-t", [this]() { _show_load_telemetry = !_show_load_telemetry; });
+    engine.accept("shift-h", [this]() { _hide_editor_view_in_game = !_hide_editor_view_in_game; });
+    engine.accept("shift-v", [this]() {
+        // Brings closed viewport panels back
+        _show_editor_viewport = true;
+        _show_game_viewport = true;
+    });
 
     if (!engine.has_event("ENGINE", "shift-g")) {
         engine.accept("shift-g",   [this]() {
@@ -246,6 +385,11 @@ void Demon::enable_game_mode() {
 
     engine.ignore("ENGINE", "shift-e");
     
+    // Start loading what the last session used before scripts ask for it,
+    // then record this session's loads for the next one.
+    engine.resource_manager.prefetch();
+    engine.resource_manager.get_prefetch_manifest().begin_recording();
+
     // load dlls
     dllLoader.load_script_dll(
         UserScriptsReg::get_instance().get_scripts(),
@@ -253,6 +397,13 @@ void Demon::enable_game_mode() {
         *this);
 
     // Enable game mode
+	// stream textures for what the game camera sees
+	engine.resource_manager.get_texture_streamer().set_camera(game.main_cam, game.render);
+	engine.resource_manager.get_sound_manager().set_listener(game.main_cam);
+
+	// Editor frames say nothing of what the game needs
+	game.dynamic_resolution.reset();
+
 	engine.trigger("game_mode_enabled");
 	std::cout << "Game mode enabled\n";
     _game_mode_enabled = true;
@@ -263,27 +414,33 @@ void Demon::exit_game_mode() {
 		return;
 
 	engine.trigger("game_mode_disabled");
+	engine.resource_manager.get_prefetch_manifest().end_recording();
+	engine.resource_manager.get_texture_streamer().set_camera(engine.scene_cam, engine.render);
+	engine.resource_manager.get_sound_manager().set_listener(engine.scene_cam);
 
     // 'exit_game_mode' sends "game_mode_disabled" event signaling
     // user-scripts to stop and clean_up, which may take a frame, so
     // we defer scripts unloading to next epoch.
-    // Create task to unload scripts
-    PT(AsyncTask) scripts_unload_task =
-        (make_task([this](AsyncTask *task) -> AsyncTask::DoneStatus {
-        dllLoader.unload_all_scripts();
-        return AsyncTask::DS_done;
-    }, "ScriptsUnloadTask"));
-
-    scripts_unload_task->set_delay(0);
-    AsyncTaskManager::get_global_ptr()->add(scripts_unload_task);
+    engine.timers.after_frames(1, [this]() { dllLoader.unload_all_scripts(); });
     engine.accept("shift-e", [this]() { exit(); });
     
     // Clear the scene graphs, except for cameras
     remove_children_except(game.render,   { game.main_cam });
     remove_children_except(game.render2D, { game.cam2D, game.aspect2D, game.pixel2D });
     remove_children_except(game.aspect2D, { game.cam2D });
-    remove_children_except(game.pixel2D,  { game.cam2D });
+    remove_children_except(game.pixel2D,  { game.cam2D, game_imgui.get_root() });
     // --------------------------------------------------------------------------------
+
+    // Release models and textures the game no longer uses, in the background
+    engine.idle_queue.add("PoolGarbageCollect", [this, step = 0](double) mutable -> bool {
+        if (step == 0)
+            ModelPool::garbage_collect();
+        else if (step == 1)
+            TexturePool::garbage_collect();
+        else
+            engine.resource_manager.get_registry().drop_expired();
+        return ++step > 2;
+    }, -10);
     
     std::cout << "Game mode disabled\n";
 	_game_mode_enabled = false;
@@ -380,6 +537,114 @@ bool Demon::is_game_mode() {
 	return _game_mode_enabled == true;
 }
 
+bool Demon::is_mouse_over_game_ui() const {
+	return _mouse_over_game_ui;
+}
+
+bool Demon::is_docked_views() const {
+	return _docked_views;
+}
+
+void Demon::setup_docked_views() {
+	if (!editor_viewport.create(engine.win) || !game_viewport.create(engine.win)) {
+		editor_viewport.destroy();
+		game_viewport.destroy();
+		return;
+	}
+
+	// Same cameras and clear colors as the window's display regions,
+	// which stop rendering. The editor 2D region stays for the UI.
+	editor_viewport.add_camera(engine.scene_cam, 0, true, engine.dr->get_clear_color());
+	game_viewport.add_camera(game.main_cam, 0, true, game.dr3D->get_clear_color());
+	game_viewport.add_camera(game.cam2D, 10, false);
+
+	engine.dr->set_active(false);
+	game.dr3D->set_active(false);
+	game.dr2D->set_active(false);
+
+	// The editor view sets the scene camera's aspect from the panel
+	engine.set_scene_cam_follows_window(false);
+
+	// Per view cost, e.g. 'editor_view_hz: 30' and 'game_view_scale: 0.75'
+	if (std::atof(config["editor_view_scale"].c_str()) > 0)
+		editor_viewport.set_render_scale(std::atof(config["editor_view_scale"].c_str()));
+	if (std::atof(config["game_view_scale"].c_str()) > 0)
+		game_viewport.set_render_scale(std::atof(config["game_view_scale"].c_str()));
+	editor_viewport.set_refresh_rate(std::atof(config["editor_view_hz"].c_str()));
+	game_viewport.set_refresh_rate(std::atof(config["game_view_hz"].c_str()));
+
+	// With the docking branch of ImGui the panels dock into each other,
+	// otherwise they are regular windows
+#ifdef IMGUI_HAS_DOCK
+	ImGui::SetCurrentContext(p3d_imgui.context_);
+	ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+#endif
+
+	_docked_views = true;
+}
+
+void Demon::set_game_scene_in_editor(bool show) {
+	// A node hidden from a camera's mask is pruned from its cull traversal
+	if (show)
+		game.render.show(BitMask32::bit(0));
+	else
+		game.render.hide(BitMask32::bit(0));
+}
+
+void Demon::update_editor_view() {
+	bool hidden = _game_mode_enabled && _hide_editor_view_in_game;
+
+	if (_docked_views) {
+		// Panels are textures, they can render less often as well
+		bool reduced = _game_mode_enabled && _editor_view_game_mode_hz > 0;
+		editor_viewport.set_refresh_rate(reduced ? _editor_view_game_mode_hz : _editor_view_hz);
+		editor_viewport.set_visible(_editor_view_panel_shown && !hidden);
+		return;
+	}
+
+	// The game regions are drawn after the editor ones, at full size
+	// nothing of the editor is seen, its UI included.
+	LVecBase4 dims = game.dr3D->get_dimensions();
+	bool covered = dims[0] <= 0.0f && dims[1] >= 1.0f && dims[2] <= 0.0f && dims[3] >= 1.0f;
+
+	bool render = !covered && !hidden;
+	if (engine.dr->is_active() != render) {
+		engine.dr->set_active(render);
+
+		// Something has to fill the window where the editor view was
+		engine.win->set_clear_color(engine.dr->get_clear_color());
+		engine.win->set_clear_color_active(!render);
+	}
+
+	if (engine.dr2D->is_active() == covered) {
+		engine.dr2D->set_active(!covered);
+		if (covered)
+			p3d_imgui.get_root().hide();
+		else
+			p3d_imgui.get_root().show();
+	}
+}
+
+void Demon::update_docked_views() {
+	if (!_docked_views)
+		return;
+
+	// The game mouse watcher and its region follow the panel's image, its
+	// display region is inactive but still maps the mouse for the game.
+	LVecBase4 rect = game_viewport.get_image_rect();
+	game.dr2D->set_dimensions(rect[0], rect[1], rect[2], rect[3]);
+	game_mw_region->set_frame(2 * rect[0] - 1, 2 * rect[1] - 1, 2 * rect[2] - 1, 2 * rect[3] - 1);
+
+	if (game.is_dynamic_resolution())
+		game_viewport.set_render_scale(game.get_render_scale());
+
+	// The scene camera and editor scripts read the mouse over the editor panel
+	engine.mouse.set_view(editor_viewport.is_hovered(), editor_viewport.get_mouse());
+
+	editor_viewport.update();
+	game_viewport.update();
+}
+
 const DllLoader& Demon::get_dll_loader() const {
     return dllLoader;
 }
@@ -396,34 +661,124 @@ void Demon::init_imgui(
 	panda3d_imgui->setup_style();
     panda3d_imgui->setup_geom();
     panda3d_imgui->setup_shader(Filename("shaders"));
-    panda3d_imgui->setup_font();
+
+    // Per instance config is prefixed with the lower case name, e.g. 'editor_font'
+    std::string prefix = name;
+    std::transform(prefix.begin(), prefix.end(), prefix.begin(), ::tolower);
+
+    // Font from the project, read through the font cache so it
+    // can come from an asset pack as well
+    const std::vector<unsigned char>* font_data = nullptr;
+    if (!config[prefix + "_font"].empty())
+        font_data = engine.resource_manager.get_font_cache().get_font_data(config[prefix + "_font"]);
+
+    if (font_data) {
+        float font_size = std::atof(config[prefix + "_font_size"].c_str());
+        panda3d_imgui->setup_font(font_data, font_size > 0.0f ? font_size : 15.0f);
+    } else {
+        panda3d_imgui->setup_font();
+    }
+    // Raw button and keystroke events for the ImGui event hooks
+    if (engine.button_thrower) {
+        engine.button_thrower->set_button_down_event(Panda3DImGui::BUTTON_DOWN_EVENT_NAME);
+        engine.button_thrower->set_button_up_event(Panda3DImGui::BUTTON_UP_EVENT_NAME);
+        engine.button_thrower->set_keystroke_event(Panda3DImGui::KEYSTROKE_EVENT_NAME);
+    }
     panda3d_imgui->setup_event();
-    panda3d_imgui->enable_file_drop();
+    if (panda3d_imgui == &p3d_imgui)
+        panda3d_imgui->enable_file_drop();
+
+    // Idle frame skipping, imgui_idle_frames 0 runs ImGui every frame
+    if (!config["imgui_idle_frames"].empty() || !config["imgui_idle_interval"].empty()) {
+        int idle_frames = config["imgui_idle_frames"].empty() ? 30 : std::atoi(config["imgui_idle_frames"].c_str());
+        double idle_interval = config["imgui_idle_interval"].empty() ? 0.25 : std::atof(config["imgui_idle_interval"].c_str());
+        panda3d_imgui->set_idle_mode(idle_frames, idle_interval);
+    }
+
+    // e.g. 'imgui_editor_fps: 30' keeps a heavy editor UI from costing every game frame
+    if (std::atof(config["imgui_" + prefix + "_fps"].c_str()) > 0)
+        panda3d_imgui->set_frame_rate(std::atof(config["imgui_" + prefix + "_fps"].c_str()));
 }
 
 void Demon::imgui_update() {
-	ImGui::SetCurrentContext(this->p3d_imgui.context_);
-	if (this->p3d_imgui.should_repaint) {
-		this->p3d_imgui.on_window_resized();
-		this->p3d_imgui.should_repaint = false;
+	// Input goes to whatever is on top under the mouse. The game view's
+	// regions draw after the editor's (higher sort), so over the game view
+	// the game UI gets the mouse and the editor UI under it none. Docked,
+	// the game view is an image in an editor panel and the editor is on
+	// top, the game UI only gets the mouse while that image is hovered.
+	bool over_game_view = !_docked_views && game.dr3D->is_active() && game.mouse_watcher->has_mouse();
+	bool over_editor_ui = false;
+
+	// The editor UI's time is left out of the game's frame time
+	TrueClock* clock = TrueClock::get_global_ptr();
+	double editor_start;
+
+	if (over_game_view) {
+		_mouse_over_game_ui = update_imgui(game_imgui, "render_game_imgui", true);
+		editor_start = clock->get_short_time();
+		update_imgui(p3d_imgui, "render_imgui", false);
+		_editor_ui_time = clock->get_short_time() - editor_start;
 	}
-    
-	this->p3d_imgui.new_frame_imgui();
-    
-    // Handle mouse
-    MouseWatcher* mw = this->engine.mouse_watcher;
-    if(mw->has_mouse()) {
-        for (const ButtonHandle& button: this->p3d_imgui.btn_handles) {
-            if(mw->is_button_down(button))
-                this->p3d_imgui.on_button_down_or_up(button, true);
+	else {
+		editor_start = clock->get_short_time();
+		over_editor_ui = update_imgui(p3d_imgui, "render_imgui", true);
+		_editor_ui_time = clock->get_short_time() - editor_start;
+		bool game_input = _docked_views ? game_viewport.is_hovered() : !over_editor_ui;
+		_mouse_over_game_ui = update_imgui(game_imgui, "render_game_imgui", game_input);
+	}
+
+	if (over_editor_ui || _mouse_over_game_ui) { _mouse_over_ui = true; }
+
+	// Docked, the editor view is itself editor UI, its mouse events only
+	// go to the editor while its image is hovered
+	if (_docked_views)
+		_mouse_over_ui = !editor_viewport.is_hovered();
+
+	// While a text field has focus, typing must not trigger shortcuts
+	_keyboard_over_ui = false;
+	for (Panda3DImGui* imgui : { &p3d_imgui, &game_imgui }) {
+		if (imgui->get_root().is_hidden())
+			continue;
+		ImGui::SetCurrentContext(imgui->context_);
+		_keyboard_over_ui = _keyboard_over_ui || ImGui::GetIO().WantCaptureKeyboard;
+	}
+}
+
+bool Demon::update_imgui(Panda3DImGui& imgui, const char* event_name, bool input_enabled) {
+	// Hidden while covered, see update_editor_view
+	if (imgui.get_root().is_hidden())
+		return false;
+
+	ImGui::SetCurrentContext(imgui.context_);
+
+	// The game view changes size without the window resizing
+	LVecBase2 display_size = imgui.get_display_size();
+	const ImVec2& io_display_size = ImGui::GetIO().DisplaySize;
+	if (imgui.should_repaint || display_size[0] != io_display_size.x || display_size[1] != io_display_size.y) {
+		imgui.on_window_resized();
+		imgui.should_repaint = false;
+	}
+
+    // Buttons and keystrokes arrive through the event hooks, see setup_event
+    imgui.set_input_enabled(input_enabled);
+
+    // Without input and with nothing changing on screen the last
+    // frame's geometry is kept, see Panda3DImGui::needs_frame.
+    if (imgui.needs_frame()) {
+        imgui.new_frame_imgui();
+        engine.trigger(event_name);
+        if (&imgui == &p3d_imgui && _docked_views) {
+            _editor_view_panel_shown = _show_editor_viewport && editor_viewport.draw_panel(&_show_editor_viewport);
+
+            if (_show_game_viewport)
+                game_viewport.draw_panel(&_show_game_viewport);
             else
-                this->p3d_imgui.on_button_down_or_up(button, false);
+                game_viewport.set_visible(false);
         }
+        if (&imgui == &p3d_imgui && _show_load_telemetry)
+            engine.resource_manager.get_telemetry().draw_panel(&_show_load_telemetry);
+        imgui.render_imgui();
     }
-    
-    // 
-    ImGui::SetCurrentContext(p3d_imgui.context_);
-	engine.trigger("render_imgui");
-	this->p3d_imgui.render_imgui();
-	if(ImGui::GetIO().WantCaptureMouse) { _mouse_over_ui = true; }
-}
\ No newline at end of file
+
+	return ImGui::GetIO().WantCaptureMouse;
+}
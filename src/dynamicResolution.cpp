@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+
+#include "dynamicResolution.hpp"
+
+namespace {
+    // Weight of the newest frame in the average
+    const double SMOOTHING = 0.1;
+
+    // Probe interval never grows past this
+    const double MAX_PROBE_INTERVAL = 30.0;
+}
+
+DynamicResolution::DynamicResolution() {
+    reset();
+}
+
+void DynamicResolution::set_settings(const Settings& settings) {
+    _settings = settings;
+    _settings.min_scale = std::max(_settings.min_scale, 0.1f);
+    _settings.max_scale = std::max(_settings.max_scale, _settings.min_scale);
+    reset();
+}
+
+const DynamicResolution::Settings& DynamicResolution::get_settings() const {
+    return _settings;
+}
+
+void DynamicResolution::reset() {
+    _scale = _settings.max_scale;
+    _average = 0.0;
+    _frames_since_change = 0;
+    _time_at_target = 0.0;
+    _probe_interval = _settings.probe_interval;
+    _probing = false;
+}
+
+float DynamicResolution::update(double frame_time) {
+    if (frame_time <= 0.0)
+        return _scale;
+
+    _average = _average > 0.0 ? _average + (frame_time - _average) * SMOOTHING : frame_time;
+
+    if (++_frames_since_change < _settings.cooldown_frames)
+        return _scale;
+
+    const double target = _settings.target_frame_time;
+
+    if (_average > target * _settings.tolerance) {
+        // Pixel cost goes with the area, so the scale with the square root
+        float scale = _scale * static_cast<float>(std::sqrt(target / _average));
+        set_scale(std::min(scale, _scale - _settings.step));
+
+        // A failed probe waits longer before the next one
+        if (_probing)
+            _probe_interval = std::min(_probe_interval * 2.0, MAX_PROBE_INTERVAL);
+        _probing = false;
+        _time_at_target = 0.0;
+    }
+    else if (_average < target * _settings.headroom) {
+        set_scale(_scale + _settings.step);
+        _probing = false;
+        _time_at_target = 0.0;
+    }
+    else {
+        _time_at_target += frame_time;
+        if (_time_at_target >= _probe_interval && _scale < _settings.max_scale) {
+            set_scale(_scale + _settings.step);
+            _probing = true;
+            _time_at_target = 0.0;
+        }
+        else if (_probing && _frames_since_change > 2 * _settings.cooldown_frames) {
+            // The probe held, next ones start from the base interval again
+            _probing = false;
+            _probe_interval = _settings.probe_interval;
+        }
+    }
+
+    return _scale;
+}
+
+float DynamicResolution::get_scale() const {
+    return _scale;
+}
+
+double DynamicResolution::get_average_frame_time() const {
+    return _average;
+}
+
+void DynamicResolution::set_scale(float scale) {
+    scale = std::min(std::max(scale, _settings.min_scale), _settings.max_scale);
+    if (scale != _scale) {
+        _scale = scale;
+        _frames_since_change = 0;
+    }
+}
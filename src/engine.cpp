@@ -1,10 +1,45 @@
 #include <cstring>
+#include <buttonRegistry.h>
+#include <graphicsStateGuardian.h>
+#include <mouseButton.h>
 #include "engine.hpp"
+#include "p3d_imgui.hpp"
 #include "taskUtils.hpp"
 #include "constants.hpp"
 
+namespace {
+    // Button events of the keyboard, e.g. 'e', 'shift-e', 'enter-up' or 'a-repeat'
+    bool is_keyboard_event(const std::string& name) {
+        size_t start = 0;
+        bool stripped = true;
+        while (stripped) {
+            stripped = false;
+            for (const char* modifier : { "shift-", "control-", "alt-", "meta-" }) {
+                size_t length = std::strlen(modifier);
+                if (name.size() > start + length && name.compare(start, length, modifier) == 0) {
+                    start += length;
+                    stripped = true;
+                }
+            }
+        }
+
+        size_t end = name.size();
+        for (const char* suffix : { "-up", "-repeat" }) {
+            size_t length = std::strlen(suffix);
+            if (end > start + length && name.compare(end - length, length, suffix) == 0) {
+                end -= length;
+                break;
+            }
+        }
+
+        ButtonHandle button = ButtonRegistry::ptr()->find_button(name.substr(start, end - start));
+        return button != ButtonHandle::none() && !MouseButton::is_mouse_button(button);
+    }
+}
+
 Engine::Engine() : scene_cam(*this) {
     data_root = NodePath("DataRoot");
+    scene_cam_follows_window = true;
 
     // get global event queueand handler
     event_queue   = EventQueue::get_global_event_queue();
@@ -18,10 +53,17 @@ Engine::Engine() : scene_cam(*this) {
     create_2d_render();
     create_axis_grid();
     create_default_scene();
+    debug_draw.initialize(render, pixel2D);
+
+    // Start worker threads
+    job_system.start();
+    resource_manager.set_job_system(&job_system);
 
     // Initialize helper mouse class and scene camera
     mouse.initialize(win, mouse_watcher);
     scene_cam.initialize();
+    resource_manager.get_texture_streamer().set_camera(scene_cam, render);
+    resource_manager.get_sound_manager().set_listener(scene_cam);
 
     // reset everything,
     scene_cam.reset();
@@ -107,8 +149,16 @@ void Engine::create_2d_render() {
 void Engine::create_default_scene() {}
 
 void Engine::create_axis_grid() {
+    // Shader grid when the GSG runs GLSL, it needs an open window to tell
+    GraphicsStateGuardian* gsg = win->get_gsg();
+    if (gsg == nullptr || !gsg->is_valid()) {
+        engine->open_windows();
+        gsg = win->get_gsg();
+    }
+    bool use_shader = gsg != nullptr && gsg->get_supports_basic_shaders() && gsg->get_supports_glsl();
+
     axis_grid = AxisGrid(100, 10, 2);
-    axis_grid.create();
+    axis_grid.create(use_shader);
     axis_grid.set_light_off();
     axis_grid.reparent_to(render);
 }
@@ -153,41 +203,24 @@ void Engine::setup_mouse_keyboard(PT(MouseWatcher)& mw) {
 
     // Assign the reference-counted MouseWatcher to mw
     mw = mouse_watcher;
+    this->button_thrower = button_thrower;
 }
 
 void Engine::process_events(CPT_Event event) {
     if (!event->get_name().empty()) {
 		// std::cout << "EventGenerated: " << event->get_name() << std::endl;
-        std::vector<void*> param_list;
-        for (int i = 0; i < event->get_num_parameters(); ++i) {
-
-            const EventParameter& event_parameter = event->get_parameter(i);
-
-            if (event_parameter.is_int()) {
-                param_list.push_back(new int(event_parameter.get_int_value()));
-            }
-            else if (event_parameter.is_double()) {
-                param_list.push_back(new double(event_parameter.get_double_value()));
-            }
-            else if (event_parameter.is_string()) {
-                param_list.push_back(new std::string(event_parameter.get_string_value()));
-            }
-            else if (event_parameter.is_wstring()) {
-                param_list.push_back(new std::wstring(event_parameter.get_wstring_value()));
-            }
-            else if (event_parameter.is_typed_ref_count()) {
-                param_list.push_back(event_parameter.get_typed_ref_count_value());
-            }
-            else {
-                param_list.push_back(event_parameter.get_ptr());
-            }
-        }
-
         if (event_handler) {
             event_handler->dispatch_event(event);
         }
-		
-		panda_events.emplace_back(event, param_list);
+
+        // The ImGui button thrower's input is consumed by its hooks above
+        const std::string& name = event->get_name();
+        if (name == Panda3DImGui::BUTTON_DOWN_EVENT_NAME ||
+            name == Panda3DImGui::BUTTON_UP_EVENT_NAME ||
+            name == Panda3DImGui::KEYSTROKE_EVENT_NAME)
+            return;
+
+		panda_events.push_back(event);
     }
 }
 
@@ -198,8 +231,11 @@ void Engine::reset_clock() {
 }
 
 void Engine::clean_up() {
-    // Remove all tasks
+    // Remove all tasks, timers and suspended coroutines
     AsyncTaskManager::get_global_ptr()->cleanup();
+    CoScheduler::get_instance().clear();
+    timers.clear();
+    idle_queue.clear();
     
     // Empty event queue and remove event hooks
 	event_queue->clear();
@@ -210,11 +246,17 @@ void Engine::clean_up() {
     clear_event_listeners();
     
 	//Remove render and render 2D
+	debug_draw.shutdown();
 	render.remove_node();
 	render2D.remove_node();
 
-	// Stop loader
+	// Stop loader and job system threads
+	resource_manager.cancel_all_async();
+	resource_manager.get_registry().clear();
+	resource_manager.get_texture_streamer().clear();
+	resource_manager.get_sound_manager().shutdown();
 	Loader::get_global_ptr()->stop_threads();
+	job_system.stop();
 
 	// Clear render textures
 	GraphicsOutput *output = DCAST(GraphicsOutput, win);
@@ -235,11 +277,22 @@ void Engine::update() {
         process_events(event_queue->dequeue_event());
     }
 
+    // fire frame and time based timers that are due
+    timers.update(ClockObject::get_global_clock()->get_frame_time());
+
+    // deliver finished async resource loads
+    resource_manager.update();
+
     // update mouse and camera
     mouse.update();
     scene_cam.update();
 }
 
+void Engine::update_coroutines() {
+    // resume coroutines whose awaited frame, time, event or load is ready
+    CoScheduler::get_instance().tick();
+}
+
 void Engine::accept(const std::string& event_name, std::function<void()> callback) {
     accept("ENGINE", event_name, std::move(callback));
 }
@@ -280,6 +333,9 @@ void Engine::dispatch_event(const char* evt_name) {
 }
 
 void Engine::trigger(const char* event_name) {
+    // Wake up coroutines waiting on this event
+    CoScheduler::get_instance().on_event(event_name);
+
     for (const auto& pair : event_handlers) {
         if (pair.first.name == event_name) {
             /*
@@ -316,10 +372,9 @@ void Engine::clear_event_listeners() {
    event_listeners.clear();
 }
 
-void Engine::dispatch_events(bool ignore_mouse) {
-    for (const auto& event_pair : panda_events) {
-        const CPT_Event& event = event_pair.first;
-        std::string name = event->get_name();
+void Engine::dispatch_events(bool ignore_mouse, bool ignore_keyboard) {
+    for (const CPT_Event& event : panda_events) {
+        const std::string& name = event->get_name();
 
         // Notify listeners
         for (const auto& listener_pair : event_listeners) {
@@ -332,6 +387,10 @@ void Engine::dispatch_events(bool ignore_mouse) {
         if (ignore_mouse && name.find("mouse") == 0)
             continue;
 
+        // and key events, e.g. while typing into a text field
+        if (ignore_keyboard && is_keyboard_event(name))
+            continue;
+
         trigger(name.c_str());
     }
 
@@ -353,8 +412,12 @@ void Engine::on_evt_size() {
 
     aspect2D.set_scale(1.0f / aspect_ratio, 1.0f, 1.0f);
     
-    if(scene_cam)
-        scene_cam.on_resize_event(aspect_ratio);
+    if(scene_cam) {
+        if (scene_cam_follows_window)
+            scene_cam.on_resize_event(aspect_ratio);
+        else
+            scene_cam.update_axes();
+    }
     
     if (window_size.get_x() > 0 && window_size.get_y() > 0) {
         pixel2D.set_scale(2.0f / window_size.get_x(), 1.0f, 2.0f / window_size.get_y());
@@ -375,6 +438,10 @@ LVecBase2i Engine::get_size() {
     return window_size;
 }
 
+void Engine::set_scene_cam_follows_window(bool follows) {
+    scene_cam_follows_window = follows;
+}
+
 void Engine::set_mouse_mode(int requested_mouse_mode) {
     WindowProperties wp = win->get_properties();
 
@@ -393,19 +460,13 @@ void Engine::set_mouse_mode(int requested_mouse_mode) {
 
     win->request_properties(wp);
 
-    // Resolve mouse mode asynchronously (safer capture with weak ref if Engine uses shared_ptr)
-    PT(AsyncTask) current_mouse_mode_resolve_update = 
-        (make_task([this, requested_mouse_mode](AsyncTask *task) -> AsyncTask::DoneStatus {
-            WindowProperties wp = win->get_properties();
-            current_mouse_mode = wp.get_mouse_mode();
+    // Resolve mouse mode on the next frame, once the window has processed the request
+    timers.after_frames(1, [this, requested_mouse_mode]() {
+        WindowProperties wp = win->get_properties();
+        current_mouse_mode = wp.get_mouse_mode();
 
-            if (requested_mouse_mode != current_mouse_mode) {
-                std::cout << "ACTUAL MOUSE MODE: " << current_mouse_mode << std::endl;
-            }
-
-            return AsyncTask::DS_done;
-        }, "MouseModeResolveUpdate"));
-
-    current_mouse_mode_resolve_update->set_delay(0);
-    AsyncTaskManager::get_global_ptr()->add(current_mouse_mode_resolve_update);
+        if (requested_mouse_mode != current_mouse_mode) {
+            std::cout << "ACTUAL MOUSE MODE: " << current_mouse_mode << std::endl;
+        }
+    });
 }
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <config_putil.h>
+#include <dynamicTextFont.h>
+#include <dynamicTextPage.h>
+#include <loaderOptions.h>
+#include <renderState.h>
+#include <textEncoder.h>
+#include <textureAttrib.h>
+#include <texturePool.h>
+#include <transparencyAttrib.h>
+#include <virtualFileSystem.h>
+
+#include "assetCache.hpp"
+#include "fontCache.hpp"
+
+TypeHandle AtlasTextFont::_type_handle;
+
+namespace {
+    std::string get_page_filename(const Filename& metrics_file, int page) {
+        return metrics_file.get_fullpath() + ".page" + std::to_string(page) + ".png";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AtlasTextFont
+
+AtlasTextFont::AtlasTextFont() {
+    init_type();
+}
+
+bool AtlasTextFont::read(const Filename& metrics_file) {
+    std::ifstream file(metrics_file.to_os_specific());
+    if (!file.is_open())
+        return false;
+
+    _pages.clear();
+    _glyphs.clear();
+
+    std::vector<CPT(RenderState)> page_states;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string tag;
+        in >> tag;
+
+        if (tag == "line_height") {
+            PN_stdfloat line_height;
+            in >> line_height;
+            set_line_height(line_height);
+        }
+        else if (tag == "space_advance") {
+            PN_stdfloat space_advance;
+            in >> space_advance;
+            set_space_advance(space_advance);
+        }
+        else if (tag == "pages") {
+            int num_pages = 0;
+            in >> num_pages;
+
+            for (int i = 0; i < num_pages; ++i) {
+                PT(Texture) page = TexturePool::load_texture(get_page_filename(metrics_file, i));
+                if (page == nullptr)
+                    return false;
+
+                // saved as grayscale, the glyph coverage goes in alpha
+                page->set_format(Texture::F_alpha);
+                page->set_minfilter(SamplerState::FT_linear);
+                page->set_magfilter(SamplerState::FT_linear);
+
+                _pages.push_back(page);
+                page_states.push_back(RenderState::make(
+                    TextureAttrib::make(page),
+                    TransparencyAttrib::make(TransparencyAttrib::M_alpha)));
+            }
+        }
+        else if (tag == "glyph") {
+            int character, page;
+            LVecBase4 dimensions, texcoords;
+            PN_stdfloat advance;
+            in >> character >> page
+               >> dimensions[0] >> dimensions[1] >> dimensions[2] >> dimensions[3]
+               >> texcoords[0] >> texcoords[1] >> texcoords[2] >> texcoords[3]
+               >> advance;
+            if (in.fail())
+                return false;
+
+            PT(TextGlyph) glyph = new TextGlyph(character, advance);
+            if (page >= 0 && page < (int)page_states.size())
+                glyph->set_quad(dimensions, texcoords, page_states[page]);
+
+            _glyphs[character] = glyph;
+        }
+    }
+
+    _is_valid = !_glyphs.empty();
+    return _is_valid;
+}
+
+void AtlasTextFont::set_fallback(TextFont* font) {
+    _fallback = font;
+}
+
+PT(TextFont) AtlasTextFont::make_copy() const {
+    return new AtlasTextFont(*this);
+}
+
+bool AtlasTextFont::get_glyph(int character, CPT(TextGlyph)& glyph) {
+    auto it = _glyphs.find(character);
+    if (it != _glyphs.end()) {
+        glyph = it->second;
+        return true;
+    }
+
+    // Rasterised on demand, like any other dynamic font
+    if (_fallback != nullptr && _fallback->get_glyph(character, glyph)) {
+        _glyphs[character] = glyph;
+        return true;
+    }
+
+    glyph = nullptr;
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// FontCache
+
+FontCache::FontCache(AssetCache& asset_cache) : _asset_cache(asset_cache) {}
+
+PT(TextFont) FontCache::load(
+    const std::string& path,
+    int pixel_size,
+    bool sdf,
+    const std::string& charset) {
+
+    Filename resolved(path);
+    if (!VirtualFileSystem::get_global_ptr()->resolve_filename(resolved, get_model_path())) {
+        std::cerr << "FontCache: could not find " << path << std::endl;
+        return nullptr;
+    }
+
+    // e.g. '.s32.sdf.c1a2b3c4.font', the charset is part of the key too
+    std::ostringstream extension;
+    extension << ".s" << pixel_size << (sdf ? ".sdf" : "")
+              << ".c" << std::hex << (std::hash<std::string>{}(charset) & 0xffffffff) << ".font";
+
+    std::string key = resolved.get_fullpath() + extension.str();
+    auto it = _fonts.find(key);
+    if (it != _fonts.end())
+        return it->second;
+
+    // Only parses the font file, nothing is rasterised until asked for
+    PT(DynamicTextFont) dynamic_font = new DynamicTextFont(resolved);
+    if (!dynamic_font->is_valid()) {
+        std::cerr << "FontCache: could not load " << resolved << std::endl;
+        return nullptr;
+    }
+    dynamic_font->set_pixels_per_unit(pixel_size);
+    if (sdf)
+        dynamic_font->set_render_mode(TextFont::RM_distance_field);
+
+    LoaderOptions options;
+    if (_asset_cache.is_enabled()) {
+        Filename cached = _asset_cache.lookup(resolved.get_fullpath(), options, extension.str());
+        if (!cached.empty()) {
+            PT(AtlasTextFont) atlas_font = new AtlasTextFont;
+            if (atlas_font->read(cached)) {
+                atlas_font->set_fallback(dynamic_font);
+                _fonts[key] = atlas_font;
+                return atlas_font;
+            }
+        }
+    }
+
+    // Pre-warm the character set, then save the pages for the next run
+    std::wstring characters = TextEncoder::decode_text(charset, TextEncoder::E_utf8);
+    for (wchar_t character : characters) {
+        CPT(TextGlyph) glyph;
+        dynamic_font->get_glyph(character, glyph);
+    }
+
+    if (_asset_cache.is_enabled()) {
+        Filename metrics_file = _asset_cache.get_cache_filename(resolved.get_fullpath(), options, extension.str());
+        if (!metrics_file.empty() && write_atlas(dynamic_font, characters, metrics_file))
+            _asset_cache.commit(resolved.get_fullpath() + extension.str(), metrics_file);
+    }
+
+    _fonts[key] = dynamic_font;
+    return dynamic_font;
+}
+
+const std::vector<unsigned char>* FontCache::get_font_data(const std::string& path) {
+    Filename resolved(path);
+    if (!VirtualFileSystem::get_global_ptr()->resolve_filename(resolved, get_model_path()))
+        return nullptr;
+
+    auto it = _font_data.find(resolved.get_fullpath());
+    if (it != _font_data.end())
+        return &it->second;
+
+    vector_uchar data;
+    if (!VirtualFileSystem::get_global_ptr()->read_file(resolved, data, true))
+        return nullptr;
+
+    std::vector<unsigned char>& font_data = _font_data[resolved.get_fullpath()];
+    font_data.assign(data.begin(), data.end());
+    return &font_data;
+}
+
+void FontCache::clear() {
+    _fonts.clear();
+    _font_data.clear();
+}
+
+const std::string& FontCache::get_default_charset() {
+    static const std::string charset = [] {
+        std::string result;
+        for (int c = 0x20; c < 0x7f; ++c) {
+            result += static_cast<char>(c);
+        }
+        // Latin-1 supplement, encoded as UTF-8
+        for (int c = 0xa0; c <= 0xff; ++c) {
+            result += static_cast<char>(0xc0 | (c >> 6));
+            result += static_cast<char>(0x80 | (c & 0x3f));
+        }
+        return result;
+    }();
+    return charset;
+}
+
+bool FontCache::write_atlas(TextFont* font, const std::wstring& characters, const Filename& metrics_file) {
+    DynamicTextFont* dynamic_font = DCAST(DynamicTextFont, font);
+
+    std::ofstream file(metrics_file.to_os_specific(), std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    file.precision(9);
+    file << "line_height " << dynamic_font->get_line_height() << "\n";
+    file << "space_advance " << dynamic_font->get_space_advance() << "\n";
+
+    int num_pages = dynamic_font->get_num_pages();
+    file << "pages " << num_pages << "\n";
+
+    std::unordered_map<const Texture*, int> page_indices;
+    for (int i = 0; i < num_pages; ++i) {
+        DynamicTextPage* page = dynamic_font->get_page(i);
+        page_indices[page] = i;
+
+        if (!page->write(get_page_filename(metrics_file, i)))
+            return false;
+    }
+
+    for (wchar_t character : characters) {
+        CPT(TextGlyph) glyph;
+        if (!dynamic_font->get_glyph(character, glyph) || glyph == nullptr)
+            continue;
+
+        LVecBase4 dimensions(0), texcoords(0);
+        int page = -1;
+
+        const TextureAttrib* texture_attrib;
+        if (glyph->get_quad(dimensions, texcoords) &&
+            glyph->get_state()->get_attrib(texture_attrib)) {
+            auto it = page_indices.find(texture_attrib->get_texture());
+            if (it != page_indices.end())
+                page = it->second;
+        }
+
+        file << "glyph " << (int)character << " " << page << " "
+             << dimensions[0] << " " << dimensions[1] << " " << dimensions[2] << " " << dimensions[3] << " "
+             << texcoords[0] << " " << texcoords[1] << " " << texcoords[2] << " " << texcoords[3] << " "
+             << glyph->get_advance() << "\n";
+    }
+
+    return file.good();
+}
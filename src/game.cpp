@@ -9,13 +9,17 @@
 #include <orthographicLens.h>
 #include <keyboardButton.h>
 #include <nodePath.h>
+#include <cardMaker.h>
+#include <clockObject.h>
+#include <textureStage.h>
+#include <algorithm>
 
 #include "demon.hpp"
 #include "game.hpp"
 #include "mouse.hpp"
 
 // Constructor
-Game::Game(Demon& demon) : demon(demon) {}
+Game::Game(Demon& demon) : demon(demon), _scaled_view("GameScaledView"), _pixel2D_size(0, 0) {}
 
 // Initialize the game
 void Game::init() {
@@ -82,23 +86,122 @@ void Game::init() {
 	std::cout << "-- Game initialized successfully" << std::endl;
 }
 
-void Game::update() {
+void Game::update(double editor_time) {
     mouse.update();
+    update_pixel2D();
+    update_dynamic_resolution(editor_time);
 }
 
-void Game::on_evt_size() {
-    auto size = demon.engine.get_size();
+void Game::enable_dynamic_resolution(const DynamicResolution::Settings& settings, bool render_offscreen) {
+    disable_dynamic_resolution();
+    dynamic_resolution.set_settings(settings);
+    _dynamic_resolution = true;
+
+    if (!render_offscreen || !_scaled_view.create(demon.engine.win))
+        return;
+
+    _scaled_view.add_camera(main_cam, 0, true, dr3D->get_clear_color());
+    _scaled_view.set_display_size(dr3D->get_pixel_width(), dr3D->get_pixel_height());
+
+    // dr3D now only draws the scaled image over the whole region,
+    // bilinear filtering does the upsampling.
+    _upsample_root = NodePath("GameUpsample");
+    _upsample_root.set_depth_test(false);
+    _upsample_root.set_depth_write(false);
+    _upsample_root.set_light_off(1);
+
+    CardMaker card_maker("GameUpsampleCard");
+    card_maker.set_frame(-1, 1, -1, 1);
+    _upsample_card = _upsample_root.attach_new_node(card_maker.generate());
+    _upsample_card.set_texture(_scaled_view.get_texture());
+    _upsample_tex_scale = LVecBase2(1, 1);
+
+    _upsample_cam = NodePath(new Camera("GameUpsampleCamera"));
+    _upsample_cam.reparent_to(_upsample_root);
+
+    auto ortho_lens = new OrthographicLens();
+    ortho_lens->set_film_size(2, 2);
+    ortho_lens->set_near_far(-1000, 1000);
+    DCAST(Camera, _upsample_cam.node())->set_lens(ortho_lens);
+
+    dr3D->set_camera(_upsample_cam);
+}
+
+void Game::disable_dynamic_resolution() {
+    if (!_dynamic_resolution)
+        return;
+
+    if (_scaled_view.is_created()) {
+        dr3D->set_camera(main_cam);
+        _scaled_view.destroy();
+        _upsample_root.remove_node();
+        _upsample_card = NodePath();
+        _upsample_cam = NodePath();
 
-    if (size.get_x() > 0 && size.get_y() > 0) {
-        pixel2D.set_scale(2.0 / size.get_x(), 1.0, 2.0 / size.get_y());
+        // The buffer had the lens follow its shape, give it back to the region
+        float aspect_ratio = float(dr3D->get_pixel_width()) / float(std::max(dr3D->get_pixel_height(), 1));
+        DCAST(Camera, main_cam.node())->get_lens()->set_aspect_ratio(aspect_ratio);
     }
-    
+
+    dynamic_resolution.reset();
+    _dynamic_resolution = false;
+}
+
+bool Game::is_dynamic_resolution() const {
+    return _dynamic_resolution;
+}
+
+float Game::get_render_scale() const {
+    return _dynamic_resolution ? dynamic_resolution.get_scale() : 1.0f;
+}
+
+void Game::update_dynamic_resolution(double editor_time) {
+    if (!_dynamic_resolution)
+        return;
+
+    // Only game mode frames count, without the editor's part of them.
+    // The scale applies from the next frame.
+    float scale = dynamic_resolution.get_scale();
+    if (demon.is_game_mode()) {
+        double frame_time = std::max(ClockObject::get_global_clock()->get_dt() - editor_time, 0.0);
+        scale = dynamic_resolution.update(frame_time);
+    }
+
+    if (!_scaled_view.is_created())
+        return;
+
+    _scaled_view.set_render_scale(scale);
+    _scaled_view.set_display_size(dr3D->get_pixel_width(), dr3D->get_pixel_height());
+    _scaled_view.set_visible(dr3D->is_active());
+    _scaled_view.update();
+
+    // The texture may be padded to a power of two, only show the rendered part
+    LVecBase2 tex_scale = _scaled_view.get_texture()->get_tex_scale();
+    if (tex_scale != _upsample_tex_scale) {
+        _upsample_card.set_tex_scale(TextureStage::get_default(), tex_scale[0], tex_scale[1]);
+        _upsample_tex_scale = tex_scale;
+    }
+}
+
+void Game::on_evt_size() {
+    update_pixel2D();
+
     float aspect_ratio = demon.engine.get_aspect_ratio();
     if (aspect_ratio != 0) {
         aspect2D.set_scale(1.0f / aspect_ratio, 1.0f, 1.0f);
     }
 }
 
+void Game::update_pixel2D() {
+    // In pixels of the game view, which moves and resizes within the window
+    LVecBase2i size(dr2D->get_pixel_width(), dr2D->get_pixel_height());
+    if (size == _pixel2D_size || size[0] <= 0 || size[1] <= 0)
+        return;
+
+    _pixel2D_size = size;
+    pixel2D.set_scale(2.0 / size[0], 1.0, 2.0 / size[1]);
+}
+
 // Handle events
 void Game::on_evt(const std::string& event_name) {
     if (event_name == "window-event") on_evt_size();
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <trueClock.h>
+
+#include "idleQueue.hpp"
+
+IdleQueue::IdleQueue() :
+    _next_sequence(0),
+    _target_frame_time(1.0 / 60.0),
+    _safety_margin(0.001),
+    _last_idle_time(0.0),
+    _max_starved_frames(30),
+    _num_starved_frames(0) {}
+
+void IdleQueue::add(const std::string& name, WorkFn work, int priority) {
+    remove(name);
+
+    WorkItem item = { name, std::move(work), priority, _next_sequence++ };
+
+    // keep items sorted, highest priority first then oldest first
+    auto it = std::upper_bound(_items.begin(), _items.end(), item,
+        [](const WorkItem& a, const WorkItem& b) {
+            if (a.priority != b.priority)
+                return a.priority > b.priority;
+            return a.sequence < b.sequence;
+        });
+    _items.insert(it, std::move(item));
+}
+
+void IdleQueue::remove(const std::string& name) {
+    _items.erase(
+        std::remove_if(_items.begin(), _items.end(),
+            [&name](const WorkItem& item) { return item.name == name; }),
+        _items.end());
+}
+
+bool IdleQueue::has(const std::string& name) const {
+    return std::any_of(_items.begin(), _items.end(),
+        [&name](const WorkItem& item) { return item.name == name; });
+}
+
+void IdleQueue::clear() {
+    _items.clear();
+}
+
+void IdleQueue::run(double frame_start_time) {
+    _last_idle_time = 0.0;
+    if (_items.empty())
+        return;
+
+    TrueClock* clock = TrueClock::get_global_ptr();
+    double start = clock->get_short_time();
+    double deadline = frame_start_time + _target_frame_time - _safety_margin;
+
+    if (start >= deadline) {
+        // No time left this frame
+        if (++_num_starved_frames < _max_starved_frames)
+            return;
+
+        // Starved for too long, allow a single chunk
+        deadline = start;
+    }
+    _num_starved_frames = 0;
+
+    double now = start;
+    do {
+        // Work may add or remove items, so the function is moved out while
+        // it runs (keeping the state of mutable lambdas) and the item is
+        // found again by its sequence, not its name, which work may reuse
+        unsigned long long sequence = _items.front().sequence;
+        WorkFn work = std::move(_items.front().work);
+
+        bool done = work(deadline);
+
+        auto it = std::find_if(_items.begin(), _items.end(),
+            [sequence](const WorkItem& item) { return item.sequence == sequence; });
+        if (it != _items.end()) {
+            if (done)
+                _items.erase(it);
+            else
+                it->work = std::move(work);
+        }
+
+        now = clock->get_short_time();
+    } while (!_items.empty() && now < deadline);
+
+    _last_idle_time = now - start;
+}
+
+void IdleQueue::set_target_frame_time(double seconds) {
+    _target_frame_time = std::max(seconds, 0.0);
+}
+
+void IdleQueue::set_safety_margin(double seconds) {
+    _safety_margin = std::max(seconds, 0.0);
+}
+
+void IdleQueue::set_max_starved_frames(int num_frames) {
+    _max_starved_frames = std::max(num_frames, 1);
+}
+
+double IdleQueue::get_target_frame_time() const {
+    return _target_frame_time;
+}
+
+double IdleQueue::get_last_idle_time() const {
+    return _last_idle_time;
+}
+
+size_t IdleQueue::get_num_pending() const {
+    return _items.size();
+}
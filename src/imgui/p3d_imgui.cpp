@@ -23,6 +23,8 @@
 */
 
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 #include <throw_event.h>
@@ -31,6 +33,8 @@
 #include <graphicsWindow.h>
 #include <mouseWatcher.h>
 #include <mouseButton.h>
+#include <buttonRegistry.h>
+#include <eventHandler.h>
 #include <colorAttrib.h>
 #include <colorBlendAttrib.h>
 #include <depthTestAttrib.h>
@@ -38,11 +42,16 @@
 #include <scissorAttrib.h>
 #include <nodePath.h>
 #include <nodePathCollection.h>
+#include <textureAttrib.h>
+#include <trueClock.h>
+#include <asyncTaskManager.h>
+#include <asyncTaskChain.h>
 
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "p3d_imgui.hpp"
 #include "mathUtils.hpp"
+#include "taskUtils.hpp"
 
 #if defined(_WIN32) || defined(_WIN32)
 #include <WinUser.h>
@@ -111,26 +120,9 @@ void Panda3DImGui::init(GraphicsWindow* window, MouseWatcher* mw, NodePath *pare
 	this->mouse_watcher = mw;
 	root_ = parent->attach_new_node("ImGUIRoot", 1000);
 	
-	// 2. Set mouse and modifier buttons
-	// mouse buttons
-	btn_handles.push_back(MouseButton::one());
-	btn_handles.push_back(MouseButton::two());   
-	btn_handles.push_back(MouseButton::three());
-	btn_handles.push_back(MouseButton::four()); 
-	btn_handles.push_back(MouseButton::five());     
-	btn_handles.push_back(MouseButton::wheel_up());
-	btn_handles.push_back(MouseButton::wheel_down()); 
-	btn_handles.push_back(MouseButton::wheel_left());
-	btn_handles.push_back(MouseButton::wheel_right()); 
-	
-	// keyboard buttons
-	btn_handles.push_back(KeyboardButton::control());
-	btn_handles.push_back(KeyboardButton::shift());
-	btn_handles.push_back(KeyboardButton::alt());
-	btn_handles.push_back(KeyboardButton::meta());
-	
-	// 3. Init ImGUI
-	context_ = ImGui::CreateContext();
+	// Init ImGUI, with an atlas of our own so atlases can be swapped (see setup_font)
+	initial_font_atlas_ = std::make_unique<ImFontAtlas>();
+	context_ = ImGui::CreateContext(initial_font_atlas_.get());
 	ImGui::SetCurrentContext(context_);
 	
     ImGuiIO& io = ImGui::GetIO();
@@ -139,14 +131,15 @@ void Panda3DImGui::init(GraphicsWindow* window, MouseWatcher* mw, NodePath *pare
     io.BackendFlags |= ImGuiBackendFlags_HasSetMousePos;
 	
 	// 
-	last_resolution_x = 800;
-	last_resolution_y = 600;
+	last_resolution_x = static_cast<int>(REFERENCE_WIDTH);
+	last_resolution_y = static_cast<int>(REFERENCE_HEIGHT);
 	
 	should_repaint = false;
 }
 
 void Panda3DImGui::setup_style(Style style)
 {
+    ImGui::SetCurrentContext(context_);
     switch (style)
     {
     case Style::dark:
@@ -196,20 +189,35 @@ void Panda3DImGui::setup_shader(Shader* shader)
 
 void Panda3DImGui::setup_font()
 {
-    ImGuiIO& io = ImGui::GetIO();
-    io.Fonts->AddFontDefault();
-    setup_font_texture();
+    font_source_ = FontSource();
+    rebuild_font_atlases();
 }
 
 void Panda3DImGui::setup_font(const char* font_filename, float font_size)
 {
-    ImGuiIO& io = ImGui::GetIO();
-    io.Fonts->AddFontFromFileTTF(font_filename, font_size);
-    setup_font_texture();
+    font_source_ = FontSource();
+    font_source_.filename = font_filename;
+    font_source_.size = font_size;
+    rebuild_font_atlases();
+}
+
+void Panda3DImGui::setup_font(const std::vector<unsigned char>* font_data, float font_size)
+{
+    if (!font_data || font_data->empty())
+    {
+        setup_font();
+        return;
+    }
+
+    font_source_ = FontSource();
+    font_source_.data = font_data;
+    font_source_.size = font_size;
+    rebuild_font_atlases();
 }
 
 void Panda3DImGui::setup_event()
 {
+    ImGui::SetCurrentContext(context_);
     ImGuiIO& io = ImGui::GetIO();
 
     // for button holder although the variable is not used.
@@ -236,6 +244,48 @@ void Panda3DImGui::setup_event()
     io.KeyMap[ImGuiKey_X]          = KeyboardButton::ascii_key('x').get_index();
     io.KeyMap[ImGuiKey_Y]          = KeyboardButton::ascii_key('y').get_index();
     io.KeyMap[ImGuiKey_Z]          = KeyboardButton::ascii_key('z').get_index();
+
+    // Lookup table by button index for the button events, everything
+    // else (unmapped keys, joystick buttons, ...) is ignored.
+    auto set_action = [this](const ButtonHandle& button, ButtonAction::Type type, int8_t value)
+    {
+        const int index = button.get_index();
+        if (index < 0 || index >= MAX_KEYS)
+            return;
+        if (index >= static_cast<int>(button_actions_.size()))
+            button_actions_.resize(index + 1);
+        button_actions_[index] = { type, value };
+    };
+
+    for (int k = 0; k < ImGuiKey_COUNT; ++k)
+    {
+        if (io.KeyMap[k] >= 0)
+            set_action(ButtonRegistry::ptr()->get_button(io.KeyMap[k]), ButtonAction::Type::key, 0);
+    }
+
+    set_action(MouseButton::one(),   ButtonAction::Type::mouse, 0);
+    set_action(MouseButton::three(), ButtonAction::Type::mouse, 1);
+    set_action(MouseButton::two(),   ButtonAction::Type::mouse, 2);
+    set_action(MouseButton::four(),  ButtonAction::Type::mouse, 3);
+    set_action(MouseButton::five(),  ButtonAction::Type::mouse, 4);
+
+    set_action(MouseButton::wheel_up(),    ButtonAction::Type::wheel, 0);
+    set_action(MouseButton::wheel_down(),  ButtonAction::Type::wheel, 1);
+    set_action(MouseButton::wheel_left(),  ButtonAction::Type::wheel, 2);
+    set_action(MouseButton::wheel_right(), ButtonAction::Type::wheel, 3);
+
+    set_action(KeyboardButton::control(), ButtonAction::Type::modifier, 0);
+    set_action(KeyboardButton::shift(),   ButtonAction::Type::modifier, 1);
+    set_action(KeyboardButton::alt(),     ButtonAction::Type::modifier, 2);
+    set_action(KeyboardButton::meta(),    ButtonAction::Type::modifier, 3);
+
+    // Called from the event handler as the ButtonThrower's events are
+    // dispatched, nothing runs on frames without input.
+    EventHandler* event_handler = EventHandler::get_global_event_handler();
+    event_handler->remove_hooks_with(this);
+    event_handler->add_hook(BUTTON_DOWN_EVENT_NAME, &Panda3DImGui::on_button_down_event, this);
+    event_handler->add_hook(BUTTON_UP_EVENT_NAME, &Panda3DImGui::on_button_up_event, this);
+    event_handler->add_hook(KEYSTROKE_EVENT_NAME, &Panda3DImGui::on_keystroke_event, this);
 }
 
 void Panda3DImGui::enable_file_drop()
@@ -255,12 +305,35 @@ void Panda3DImGui::enable_file_drop()
 void Panda3DImGui::on_window_resized()
 {
     if (window_.is_valid_pointer())
-        on_window_resized(LVecBase2(static_cast<float>(window_->get_x_size()), static_cast<float>(window_->get_y_size())));
+        on_window_resized(get_display_size());
+}
+
+void Panda3DImGui::set_display_region(DisplayRegion* display_region)
+{
+    display_region_ = display_region;
+    on_window_resized();
+}
+
+LVecBase2 Panda3DImGui::get_display_size() const
+{
+    if (display_region_ != nullptr)
+        return LVecBase2(static_cast<float>(display_region_->get_pixel_width()), static_cast<float>(display_region_->get_pixel_height()));
+
+    if (window_.is_valid_pointer())
+        return LVecBase2(static_cast<float>(window_->get_x_size()), static_cast<float>(window_->get_y_size()));
+
+    return LVecBase2(0.0f, 0.0f);
 }
 
 void Panda3DImGui::on_window_resized(const LVecBase2& size)
 {
+    // Minimised, or a region with no area, keep the layout for when it comes back
+    if (size[0] < 1.0f || size[1] < 1.0f)
+        return;
+
+    ImGui::SetCurrentContext(context_);
     ImGuiIO& io = ImGui::GetIO();
+    input_received_ = true;
     io.DisplaySize = ImVec2(size[0], size[1]);
 		
 	float scale_factor_x = static_cast<float>(size[0]) / last_resolution_x;
@@ -276,14 +349,19 @@ void Panda3DImGui::on_window_resized(const LVecBase2& size)
     }
 
 	// ------------------------------------------------------------------------------
-    // Optional: Update font scaling uniformly or independently
-    float font_scale_factor = (scale_factor_x + scale_factor_y) / 2.0f; // Average
-    ImGui::GetIO().FontGlobalScale = font_scale_factor;
-
-    // Rebuild font atlas
-    ImFontAtlas* font_atlas = io.Fonts;
-    font_atlas->Clear();
-    setup_font();
+    // Fonts follow the average scale against the reference size, computed from
+    // the size itself so it doesn't drift over many resizes. The atlas of the
+    // nearest bucket is used if there is one, otherwise it is built in the
+    // background and the current one is stretched by FontGlobalScale until it is ready.
+    display_scale_ = (size[0] / REFERENCE_WIDTH + size[1] / REFERENCE_HEIGHT) / 2.0f; // Average
+
+    wanted_font_bucket_ = get_scale_bucket(display_scale_);
+    if (font_atlases_.count(wanted_font_bucket_))
+        use_font_atlas(wanted_font_bucket_);
+    else
+        request_font_atlas(wanted_font_bucket_);
+
+    io.FontGlobalScale = display_scale_ * 100.0f / font_bucket_;
 	// ------------------------------------------------------------------------------
 
     // Save the new resolution as the last resolution for future reference
@@ -314,67 +392,200 @@ void Panda3DImGui::on_window_resized(const LVecBase2& size)
 
 void Panda3DImGui::on_button_down_or_up(const ButtonHandle& button, bool down)
 {
-    if (button == ButtonHandle::none())
+    const int index = button.get_index();
+    if (index < 0 || index >= static_cast<int>(button_actions_.size()))
         return;
-	
+
+    const ButtonAction action = button_actions_[index];
+    if (action.type == ButtonAction::Type::none)
+        return;
+
+    ImGui::SetCurrentContext(context_);
     ImGuiIO& io = ImGui::GetIO();
-		
-    if (MouseButton::is_mouse_button(button))
+
+    // Mouse presses go to the context under the mouse and keys only to one
+    // using the keyboard, releases always so nothing stays held.
+    if (down)
     {
-        if (button == MouseButton::one())
-        {
-			io.MouseDown[0] = down;
-        }
-        else if (button == MouseButton::three())
-        {
-            io.MouseDown[1] = down;
-        }
-        else if (button == MouseButton::two())
-        {
-            io.MouseDown[2] = down;
-        }
-        else if (button == MouseButton::four())
-        {
-            io.MouseDown[3] = down;
-        }
-        else if (button == MouseButton::five())
-        {
-            io.MouseDown[4] = down;
-        }
-        else if (down)
-        {
-            if (button == MouseButton::wheel_up())
-                io.MouseWheel += 1;
-            else if (button == MouseButton::wheel_down())
-                io.MouseWheel -= 1;
-            else if (button == MouseButton::wheel_right())
-                io.MouseWheelH += 1;
-            else if (button == MouseButton::wheel_left())
-                io.MouseWheelH -= 1;
-        }
+        if (!input_enabled_)
+            return;
+        if (action.type == ButtonAction::Type::key && !io.WantCaptureKeyboard)
+            return;
+        if ((action.type == ButtonAction::Type::mouse || action.type == ButtonAction::Type::wheel) && !mouse_watcher->has_mouse())
+            return;
     }
-    else
+
+    input_received_ = true;
+
+    switch (action.type)
     {
-        io.KeysDown[button.get_index()] = down;
+    case ButtonAction::Type::mouse:
+        set_button_state(io.MouseDown[action.value], MOUSE_STATE_OFFSET + action.value, down);
+        break;
+
+    case ButtonAction::Type::wheel:
+        if (down)
+        {
+            // up, down, left, right
+            static const float wheel_steps[4][2] = { { 1, 0 }, { -1, 0 }, { 0, -1 }, { 0, 1 } };
+            io.MouseWheel += wheel_steps[action.value][0];
+            io.MouseWheelH += wheel_steps[action.value][1];
+        }
+        break;
+
+    case ButtonAction::Type::key:
+        set_button_state(io.KeysDown[index], index, down);
+        break;
 
-        if (button == KeyboardButton::control())
+    case ButtonAction::Type::modifier:
+        io.KeysDown[index] = down;
+        if (action.value == 0)
             io.KeyCtrl = down;
-        else if (button == KeyboardButton::shift())
+        else if (action.value == 1)
             io.KeyShift = down;
-        else if (button == KeyboardButton::alt())
+        else if (action.value == 2)
             io.KeyAlt = down;
-        else if (button == KeyboardButton::meta())
+        else
             io.KeySuper = down;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void Panda3DImGui::set_button_state(bool& state, size_t bit, bool down)
+{
+    // A release in the same frame as its press waits for the next frame,
+    // ImGui only sees states at NewFrame and would miss the click.
+    if (down)
+    {
+        state = true;
+        pressed_buttons_.set(bit);
+        deferred_releases_.reset(bit);
+    }
+    else if (pressed_buttons_.test(bit))
+    {
+        deferred_releases_.set(bit);
+    }
+    else
+    {
+        state = false;
     }
 }
 
 void Panda3DImGui::on_keystroke(wchar_t keycode)
 {
-    if (keycode < 0 || keycode >= (std::numeric_limits<ImWchar>::max)())
+    if (keycode < 0 || keycode >= (std::numeric_limits<ImWchar>::max)() || !input_enabled_)
         return;
 
+    ImGui::SetCurrentContext(context_);
     ImGuiIO& io = ImGui::GetIO();
+    if (!io.WantTextInput)
+        return;
+
     io.AddInputCharacter(keycode);
+    input_received_ = true;
+}
+
+void Panda3DImGui::on_button_down_event(const Event* event, void* data)
+{
+    if (event->get_num_parameters() > 0)
+    {
+        ButtonHandle button = ButtonRegistry::ptr()->find_button(event->get_parameter(0).get_string_value());
+        static_cast<Panda3DImGui*>(data)->on_button_down_or_up(button, true);
+    }
+}
+
+void Panda3DImGui::on_button_up_event(const Event* event, void* data)
+{
+    if (event->get_num_parameters() > 0)
+    {
+        ButtonHandle button = ButtonRegistry::ptr()->find_button(event->get_parameter(0).get_string_value());
+        static_cast<Panda3DImGui*>(data)->on_button_down_or_up(button, false);
+    }
+}
+
+void Panda3DImGui::on_keystroke_event(const Event* event, void* data)
+{
+    if (event->get_num_parameters() > 0)
+    {
+        const std::wstring keycode = event->get_parameter(0).get_wstring_value();
+        if (!keycode.empty())
+            static_cast<Panda3DImGui*>(data)->on_keystroke(keycode[0]);
+    }
+}
+
+bool Panda3DImGui::needs_frame()
+{
+    if (root_.is_hidden())
+        return false;
+
+    if (mouse_watcher->has_mouse() != last_has_mouse_ ||
+        (mouse_watcher->has_mouse() && mouse_watcher->get_mouse() != last_mouse_))
+    {
+        last_has_mouse_ = mouse_watcher->has_mouse();
+        last_mouse_ = last_has_mouse_ ? mouse_watcher->get_mouse() : LPoint2(0);
+        input_received_ = true;
+    }
+
+    if (input_received_)
+    {
+        frames_without_input_ = 0;
+        input_received_ = false;
+    }
+    else
+    {
+        ++frames_without_input_;
+    }
+
+    // Half an engine frame of slack, or a cap of half the engine rate drops to a third
+    ClockObject* clock = ClockObject::get_global_clock();
+    const double elapsed = clock->get_frame_time() - last_frame_time_;
+    if (elapsed + 0.5 * clock->get_dt() < min_frame_interval_)
+        return false;
+
+    if (!is_idle())
+        return true;
+
+    // Still run now and then, for anything changing without input
+    return elapsed >= idle_interval_;
+}
+
+bool Panda3DImGui::is_idle() const
+{
+    return idle_frames_ > 0 &&
+        frames_without_input_ >= idle_frames_ &&
+        unchanged_frames_ >= idle_frames_;
+}
+
+void Panda3DImGui::set_idle_mode(int idle_frames, double idle_interval)
+{
+    idle_frames_ = idle_frames;
+    idle_interval_ = idle_interval;
+}
+
+void Panda3DImGui::set_frame_rate(double frame_rate)
+{
+    min_frame_interval_ = frame_rate > 0.0 ? 1.0 / frame_rate : 0.0;
+}
+
+void Panda3DImGui::set_input_enabled(bool enabled)
+{
+    if (input_enabled_ == enabled)
+        return;
+
+    input_enabled_ = enabled;
+    input_received_ = true;
+
+    // Releases still arrive, but a drag must not go on under another context
+    if (!enabled)
+    {
+        ImGui::SetCurrentContext(context_);
+        ImGuiIO& io = ImGui::GetIO();
+        for (bool& mouse_down : io.MouseDown)
+            mouse_down = false;
+    }
 }
 
 bool Panda3DImGui::new_frame_imgui()
@@ -384,13 +595,22 @@ bool Panda3DImGui::new_frame_imgui()
 
     static const int MOUSE_DEVICE_INDEX = 0;
 
+    frame_start_time_ = TrueClock::get_global_ptr()->get_short_time();
+
+    ImGui::SetCurrentContext(context_);
     ImGuiIO& io = ImGui::GetIO();
-    io.DeltaTime = static_cast<float>(ClockObject::get_global_clock()->get_dt());
+
+    // Time since the last ImGui frame, which may be several engine frames in idle mode
+    const double now = ClockObject::get_global_clock()->get_frame_time();
+    io.DeltaTime = last_frame_time_ > 0.0 ?
+        std::max(static_cast<float>(now - last_frame_time_), 1e-4f) :
+        static_cast<float>(ClockObject::get_global_clock()->get_dt());
+    last_frame_time_ = now;
 
     if (window_.is_valid_pointer() && window_->is_of_type(GraphicsWindow::get_class_type()))
     {
         // const auto& mouse = window_->get_pointer(MOUSE_DEVICE_INDEX);
-        if (mouse_watcher->has_mouse())
+        if (mouse_watcher->has_mouse() && input_enabled_)
         {
 			// float x = convert_to_range(mouse_watcher->get_mouse_x(), -1.0f, 1.0f, 0.0f, static_cast<float>(window_->get_x_size()));
 			// float y = convert_to_range(mouse_watcher->get_mouse_y(), 1.0f, -1.0f, 0.0f, static_cast<float>(window_->get_x_size()));
@@ -400,14 +620,24 @@ bool Panda3DImGui::new_frame_imgui()
 			// std::cout << "mouse pos X: " << mouse.get_x() << " mouse pos Y: " << mouse.get_y() << std::endl;
 			// std::cout << static_cast<float>(mouse_watcher->get_display_region()->get_pixel_width()) << std::endl;
 			
+            // The mouse watcher's -1..1 spans the display region, or the window without one
+            const LVecBase2 display_size = get_display_size();
+
             if (io.WantSetMousePos)
             {
-                window_->move_pointer(MOUSE_DEVICE_INDEX, io.MousePos.x, io.MousePos.y);
+                int left = 0, top = 0;
+                if (display_region_ != nullptr)
+                {
+                    int right, bottom, region_top;
+                    display_region_->get_pixels(left, right, bottom, region_top);
+                    top = window_->get_y_size() - region_top;
+                }
+                window_->move_pointer(MOUSE_DEVICE_INDEX, left + static_cast<int>(io.MousePos.x), top + static_cast<int>(io.MousePos.y));
             }
             else
             {
-                io.MousePos.x = convert_to_range(mouse_watcher->get_mouse_x(), -1.0f, 1.0f, 0.0f, static_cast<float>(window_->get_x_size()));
-                io.MousePos.y = convert_to_range(mouse_watcher->get_mouse_y(), 1.0f, -1.0f, 0.0f, static_cast<float>(window_->get_y_size()));
+                io.MousePos.x = convert_to_range(mouse_watcher->get_mouse_x(), -1.0f, 1.0f, 0.0f, display_size[0]);
+                io.MousePos.y = convert_to_range(mouse_watcher->get_mouse_y(), 1.0f, -1.0f, 0.0f, display_size[1]);
             }
         }
         else
@@ -417,7 +647,29 @@ bool Panda3DImGui::new_frame_imgui()
         }
     }
 
+    // Swap in a finished background atlas, never in the middle of a frame
+    update_font_atlas();
+
     ImGui::NewFrame();
+
+    // ImGui has seen the presses now, apply releases held back for it
+    if (deferred_releases_.any())
+    {
+        for (int k = 0; k < 5; ++k)
+        {
+            if (deferred_releases_.test(MOUSE_STATE_OFFSET + k))
+                io.MouseDown[k] = false;
+        }
+        for (int k = 0; k < MAX_KEYS; ++k)
+        {
+            if (deferred_releases_.test(k))
+                io.KeysDown[k] = false;
+        }
+        input_received_ = true;
+    }
+    pressed_buttons_.reset();
+    deferred_releases_.reset();
+
     throw_event_directly(*EventHandler::get_global_event_handler(), NEW_FRAME_EVENT_NAME);
     return true;
 }
@@ -427,20 +679,56 @@ bool Panda3DImGui::render_imgui()
     if (root_.is_hidden())
         return false;
 
+    ImGui::SetCurrentContext(context_);
     ImGui::Render();
 
+    const double start_time = TrueClock::get_global_ptr()->get_short_time();
+    render_stats_ = RenderStats();
+
     ImGuiIO& io = ImGui::GetIO();
     const float fb_width =  io.DisplaySize.x * io.DisplayFramebufferScale.x;
     const float fb_height = io.DisplaySize.y * io.DisplayFramebufferScale.y;
 	
-	// std::cout << "DisplaySize: " << io.DisplayFramebufferScale.x << "  FrameSize: " << io.DisplayFramebufferScale.y << std::endl;
-	
     auto draw_data = ImGui::GetDrawData();
     //draw_data->ScaleClipRects(io.DisplayFramebufferScale);
 
-    auto npc = root_.get_children();
-    for (int k = 0, k_end = npc.get_num_paths(); k < k_end; ++k)
-        npc.get_path(k).detach_node();
+    // Same draw data as last frame, the uploaded geometry is still right
+    const uint64_t draw_data_hash = hash_draw_data(draw_data, fb_width, fb_height);
+    if (draw_data_hash == draw_data_hash_)
+    {
+        ++unchanged_frames_;
+        if (retained_)
+        {
+            render_stats_.num_draw_lists = draw_data->CmdListsCount;
+            render_stats_.reused = true;
+            render_stats_.cpu_time = TrueClock::get_global_ptr()->get_short_time() - start_time;
+            render_stats_.frame_time = TrueClock::get_global_ptr()->get_short_time() - frame_start_time_;
+            return true;
+        }
+    }
+    else
+    {
+        unchanged_frames_ = 0;
+        draw_data_hash_ = draw_data_hash;
+    }
+
+    // Cached scissor rects are relative to the framebuffer size
+    if (!retained_ || state_cache_fb_size_ != LVecBase2(fb_width, fb_height))
+    {
+        state_cache_.clear();
+        state_cache_fb_size_ = LVecBase2(fb_width, fb_height);
+    }
+
+    if (!retained_)
+    {
+        for (auto& geom_list : geom_data_)
+        {
+            for (int cmd_i = 0; cmd_i < geom_list.num_attached; ++cmd_i)
+                geom_list.commands[cmd_i].nodepath.detach_node();
+            geom_list.num_attached = 0;
+            geom_list.root.detach_node();
+        }
+    }
 
     for (int k = 0; k < draw_data->CmdListsCount; ++k)
     {
@@ -448,116 +736,366 @@ bool Panda3DImGui::render_imgui()
 
         if (!(k < static_cast<int>(geom_data_.size())))
         {
-            geom_data_.push_back({
-                new GeomVertexData("imgui-vertex-" + std::to_string(k), vformat_, GeomEnums::UsageHint::UH_stream),
-                {}
-            });
+            GeomList geom_list;
+            geom_list.vdata = new GeomVertexData("imgui-vertex-" + std::to_string(k), vformat_, GeomEnums::UsageHint::UH_stream);
+            geom_list.root = NodePath("imgui-list-" + std::to_string(k));
+            geom_data_.push_back(std::move(geom_list));
         }
 
         auto& geom_list = geom_data_[k];
 
-        auto vertex_handle = geom_list.vdata->modify_array_handle(0);
-        if (vertex_handle->get_num_rows() < cmd_list->VtxBuffer.Size)
+        // Only trailing lists are ever detached, so reattaching
+        // at the end keeps the lists in draw order.
+        if (!geom_list.root.has_parent())
+        {
+            geom_list.root.reparent_to(root_);
+            ++render_stats_.num_reparents;
+        }
+
+        // Unchanged vertices are not written, which would upload them again
+        const size_t vertex_bytes = cmd_list->VtxBuffer.Size * sizeof(decltype(cmd_list->VtxBuffer)::value_type);
+        CPT(GeomVertexArrayDataHandle) vertex_reader = geom_list.vdata->get_array(0)->get_handle();
+        bool vertices_changed = !retained_ ||
+            vertex_reader->get_num_rows() != cmd_list->VtxBuffer.Size ||
+            std::memcmp(vertex_reader->get_read_pointer(true), cmd_list->VtxBuffer.Data, vertex_bytes) != 0;
+        vertex_reader = nullptr;
+
+        if (vertices_changed)
+        {
+            auto vertex_handle = geom_list.vdata->modify_array_handle(0);
             vertex_handle->unclean_set_num_rows(cmd_list->VtxBuffer.Size);
 
-        std::memcpy(
-            vertex_handle->get_write_pointer(),
-            reinterpret_cast<const unsigned char*>(cmd_list->VtxBuffer.Data),
-            cmd_list->VtxBuffer.Size * sizeof(decltype(cmd_list->VtxBuffer)::value_type));
+            std::memcpy(
+                vertex_handle->get_write_pointer(),
+                reinterpret_cast<const unsigned char*>(cmd_list->VtxBuffer.Data),
+                vertex_bytes);
+            render_stats_.vertex_bytes += vertex_bytes;
+        }
 
+        // Panda primitives can't draw a sub-range of a shared index buffer, so
+        // each command keeps its own indices, also only written when changed.
         auto idx_buffer_data = cmd_list->IdxBuffer.Data;
-        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; ++cmd_i)
+        const int num_commands = cmd_list->CmdBuffer.Size;
+        for (int cmd_i = 0; cmd_i < num_commands; ++cmd_i)
         {
             const ImDrawCmd* draw_cmd = &cmd_list->CmdBuffer[cmd_i];
             auto elem_count = static_cast<int>(draw_cmd->ElemCount);
 
-            if (!(cmd_i < static_cast<int>(geom_list.nodepaths.size())))
-                geom_list.nodepaths.push_back(create_geomnode(geom_list.vdata));
+            if (!(cmd_i < static_cast<int>(geom_list.commands.size())))
+                geom_list.commands.push_back({ create_geomnode(geom_list.vdata), nullptr });
 
-            NodePath np = geom_list.nodepaths[cmd_i];
-            np.reparent_to(root_);
+            DrawCommand& command = geom_list.commands[cmd_i];
+            if (cmd_i >= geom_list.num_attached)
+            {
+                command.nodepath.reparent_to(geom_list.root);
+                ++render_stats_.num_reparents;
+            }
 
-            auto gn = DCAST(GeomNode, np.node());
+            auto gn = DCAST(GeomNode, command.nodepath.node());
 
-            auto index_handle = gn->modify_geom(0)->modify_primitive(0)->modify_vertices(elem_count)->modify_handle();
-            if (index_handle->get_num_rows() < elem_count)
+            const size_t index_bytes = elem_count * sizeof(decltype(cmd_list->IdxBuffer)::value_type);
+            CPT(GeomVertexArrayData) indices = gn->get_geom(0)->get_primitive(0)->get_vertices();
+            bool indices_changed = !retained_ || indices == nullptr ||
+                indices->get_num_rows() != elem_count ||
+                std::memcmp(indices->get_handle()->get_read_pointer(true), idx_buffer_data, index_bytes) != 0;
+            indices = nullptr;
+
+            if (indices_changed)
+            {
+                auto index_handle = gn->modify_geom(0)->modify_primitive(0)->modify_vertices(elem_count)->modify_handle();
                 index_handle->unclean_set_num_rows(elem_count);
 
-            std::memcpy(
-                index_handle->get_write_pointer(),
-                reinterpret_cast<const unsigned char*>(idx_buffer_data),
-                elem_count * sizeof(decltype(cmd_list->IdxBuffer)::value_type));
+                std::memcpy(
+                    index_handle->get_write_pointer(),
+                    reinterpret_cast<const unsigned char*>(idx_buffer_data),
+                    index_bytes);
+                render_stats_.index_bytes += index_bytes;
+            }
             idx_buffer_data += elem_count;
 
-            CPT(RenderState) state = RenderState::make(ScissorAttrib::make(
-                draw_cmd->ClipRect.x / fb_width,
-                draw_cmd->ClipRect.z / fb_width,
-                1 - draw_cmd->ClipRect.w / fb_height,
-                1 - draw_cmd->ClipRect.y / fb_height));
+            CPT(RenderState) state = get_draw_state(
+                LVecBase4(draw_cmd->ClipRect.x, draw_cmd->ClipRect.y, draw_cmd->ClipRect.z, draw_cmd->ClipRect.w),
+                draw_cmd->TextureId, fb_width, fb_height);
 
-            if (draw_cmd->TextureId)
-                state = state->add_attrib(TextureAttrib::make(static_cast<Texture*>(draw_cmd->TextureId)));
+            if (state != command.state)
+            {
+                gn->set_geom_state(0, state);
+                command.state = state;
+            }
+        }
 
-            gn->set_geom_state(0, state);
+        // Commands this list no longer has
+        for (int cmd_i = num_commands; cmd_i < geom_list.num_attached; ++cmd_i)
+        {
+            geom_list.commands[cmd_i].nodepath.detach_node();
+            ++render_stats_.num_reparents;
         }
+        geom_list.num_attached = num_commands;
+
+        render_stats_.num_draw_commands += num_commands;
     }
 
+    // Lists ImGui no longer draws, e.g. closed windows
+    for (int k = draw_data->CmdListsCount; k < static_cast<int>(geom_data_.size()); ++k)
+    {
+        if (geom_data_[k].root.has_parent())
+        {
+            geom_data_[k].root.detach_node();
+            ++render_stats_.num_reparents;
+        }
+    }
+
+    render_stats_.num_draw_lists = draw_data->CmdListsCount;
+    render_stats_.cpu_time = TrueClock::get_global_ptr()->get_short_time() - start_time;
+    render_stats_.frame_time = TrueClock::get_global_ptr()->get_short_time() - frame_start_time_;
     return true;
 }
 
-void Panda3DImGui::setup_font_texture()
+void Panda3DImGui::set_retained(bool retained)
 {
-    ImGuiIO& io = ImGui::GetIO();
+    retained_ = retained;
+}
+
+uint64_t Panda3DImGui::hash_draw_data(const ImDrawData* draw_data, float fb_width, float fb_height)
+{
+    // FNV-1a over 64 bit words, the draw data is a few hundred KB at most
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        size_t num_words = size / sizeof(uint64_t);
+        for (size_t i = 0; i < num_words; ++i)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+            hash = (hash ^ word) * 1099511628211ull;
+        }
+        for (size_t i = num_words * sizeof(uint64_t); i < size; ++i)
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+    };
+
+    add(&fb_width, sizeof(fb_width));
+    add(&fb_height, sizeof(fb_height));
+    add(&draw_data->CmdListsCount, sizeof(draw_data->CmdListsCount));
+
+    for (int k = 0; k < draw_data->CmdListsCount; ++k)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[k];
+        add(cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        add(cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+
+        for (const ImDrawCmd& draw_cmd : cmd_list->CmdBuffer)
+        {
+            add(&draw_cmd.ClipRect, sizeof(draw_cmd.ClipRect));
+            add(&draw_cmd.TextureId, sizeof(draw_cmd.TextureId));
+            add(&draw_cmd.ElemCount, sizeof(draw_cmd.ElemCount));
+        }
+    }
+
+    return hash;
+}
+
+size_t Panda3DImGui::StateKeyHash::operator()(const StateKey& key) const
+{
+    size_t hash = std::hash<void*>()(key.texture_id);
+    for (int i = 0; i < 4; ++i)
+        hash = hash * 31 + std::hash<float>()(key.clip_rect[i]);
+    return hash;
+}
 
-    // Retrieve font texture data from ImGui
+CPT(RenderState) Panda3DImGui::get_draw_state(const LVecBase4& clip_rect, void* texture_id, float fb_width, float fb_height)
+{
+    // Keeps the cache (and the textures it holds) from growing without bound
+    static const size_t MAX_CACHED_STATES = 512;
+
+    StateKey key = { clip_rect, texture_id };
+    auto it = state_cache_.find(key);
+    if (it != state_cache_.end())
+        return it->second;
+
+    ++render_stats_.num_state_misses;
+
+    CPT(RenderState) state = RenderState::make(ScissorAttrib::make(
+        clip_rect[0] / fb_width,
+        clip_rect[2] / fb_width,
+        1 - clip_rect[3] / fb_height,
+        1 - clip_rect[1] / fb_height));
+
+    if (texture_id)
+        state = state->add_attrib(TextureAttrib::make(static_cast<Texture*>(texture_id)));
+
+    if (retained_)
+    {
+        if (state_cache_.size() >= MAX_CACHED_STATES)
+            state_cache_.clear();
+        state_cache_[key] = state;
+    }
+
+    return state;
+}
+
+Panda3DImGui::FontAtlas Panda3DImGui::build_font_atlas(const FontSource& source, int scale_bucket)
+{
+    const float scale = scale_bucket / 100.0f;
+
+    FontAtlas result;
+    result.atlas = std::make_unique<ImFontAtlas>();
+    ImFontAtlas* atlas = result.atlas.get();
+
+    if (source.data)
+    {
+        // data stays owned by the font cache
+        ImFontConfig config;
+        config.FontDataOwnedByAtlas = false;
+        atlas->AddFontFromMemoryTTF(
+            const_cast<unsigned char*>(source.data->data()), static_cast<int>(source.data->size()),
+            source.size * scale, &config);
+    }
+    else if (!source.filename.empty())
+    {
+        atlas->AddFontFromFileTTF(source.filename.c_str(), source.size * scale);
+    }
+    else
+    {
+        ImFontConfig config;
+        config.SizePixels = source.size * scale;
+        atlas->AddFontDefault(&config);
+    }
+
+    // Retrieve font texture data from ImGui, rasterises the glyphs
     unsigned char* pixels;
     int width, height;
-    io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+    atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
 
     // Create a new texture for the font
-    font_texture_ = Texture::make_texture();
-    font_texture_->set_name("imgui-font-texture");
+    result.texture = Texture::make_texture();
+    result.texture->set_name("imgui-font-texture-" + std::to_string(scale_bucket));
 
     // Set up a 2D texture with single-channel format for the alpha-only texture
-    font_texture_->setup_2d_texture(
+    result.texture->setup_2d_texture(
         width, height,
         Texture::ComponentType::T_unsigned_byte,
         Texture::Format::F_red // Single-channel texture
     );
 
     // Use nearest filtering for sharp fonts
-    font_texture_->set_minfilter(SamplerState::FilterType::FT_nearest);
-    font_texture_->set_magfilter(SamplerState::FilterType::FT_nearest);
+    result.texture->set_minfilter(SamplerState::FilterType::FT_nearest);
+    result.texture->set_magfilter(SamplerState::FilterType::FT_nearest);
 
     // Copy the font data into the texture's RAM image
-    PTA_uchar ram_image = font_texture_->make_ram_image();
+    PTA_uchar ram_image = result.texture->make_ram_image();
     std::memcpy(ram_image.p(), pixels, width * height * sizeof(unsigned char));
 
     // Assign the texture ID to ImGui for rendering
-    io.Fonts->TexID = font_texture_.p();
+    atlas->TexID = result.texture.p();
+    return result;
+}
+
+int Panda3DImGui::get_scale_bucket(float scale)
+{
+    // A few sizes only, FontGlobalScale covers the difference
+    static const int buckets[] = { 50, 75, 100, 125, 150, 200, 250, 300 };
+
+    int best = buckets[0];
+    for (int bucket : buckets)
+    {
+        if (std::abs(bucket - scale * 100.0f) < std::abs(best - scale * 100.0f))
+            best = bucket;
+    }
+    return best;
 }
 
-/*
-void Panda3DImGui::setup_font_texture()
+void Panda3DImGui::rebuild_font_atlases()
 {
+    ImGui::SetCurrentContext(context_);
+
+    // A build of the previous font is dropped when it finishes
+    if (font_build_task_)
+    {
+        font_build_task_->wait();
+        font_build_task_ = nullptr;
+        font_build_result_ = nullptr;
+    }
+
+    // The font changed, only the current scale is built now, on this thread
+    const int scale_bucket = get_scale_bucket(display_scale_);
+    FontAtlas font_atlas = build_font_atlas(font_source_, scale_bucket);
+
+    ImGui::GetIO().Fonts = font_atlas.atlas.get();
+    font_atlases_.clear();
+    font_atlases_[scale_bucket] = std::move(font_atlas);
+    font_bucket_ = scale_bucket;
+    wanted_font_bucket_ = scale_bucket;
+    ImGui::GetIO().FontGlobalScale = display_scale_ * 100.0f / font_bucket_;
+
+    // Drop states holding on to the previous font textures
+    state_cache_.clear();
+}
+
+void Panda3DImGui::request_font_atlas(int scale_bucket)
+{
+    // One build at a time, update_font_atlas starts the next one
+    if (font_build_task_)
+        return;
+
+    auto result = std::make_shared<FontAtlas>();
+    FontSource source = font_source_;
+
+    font_build_task_ = make_task([result, source, scale_bucket](AsyncTask*) -> AsyncTask::DoneStatus {
+        *result = build_font_atlas(source, scale_bucket);
+        return AsyncTask::DS_done;
+    }, "ImGuiFontAtlas:" + std::to_string(scale_bucket));
+
+    AsyncTaskManager* task_mgr = AsyncTaskManager::get_global_ptr();
+    AsyncTaskChain* chain = task_mgr->find_task_chain("ImGuiFontAtlas");
+    if (chain == nullptr)
+    {
+        chain = task_mgr->make_task_chain("ImGuiFontAtlas");
+        chain->set_num_threads(1);
+        chain->set_thread_priority(TP_low);
+    }
+    font_build_task_->set_task_chain("ImGuiFontAtlas");
+    task_mgr->add(font_build_task_);
+
+    font_build_result_ = result;
+    font_build_bucket_ = scale_bucket;
+}
+
+void Panda3DImGui::use_font_atlas(int scale_bucket)
+{
+    if (scale_bucket == font_bucket_)
+        return;
+
+    auto it = font_atlases_.find(scale_bucket);
+    if (it == font_atlases_.end())
+        return;
+
     ImGuiIO& io = ImGui::GetIO();
+    io.Fonts = it->second.atlas.get();
+    font_bucket_ = scale_bucket;
+    io.FontGlobalScale = display_scale_ * 100.0f / font_bucket_;
+}
 
-    unsigned char* pixels;
-    int width, height;
-    io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+void Panda3DImGui::update_font_atlas()
+{
+    if (font_build_task_ && font_build_task_->done())
+    {
+        if (font_build_result_->atlas)
+            font_atlases_[font_build_bucket_] = std::move(*font_build_result_);
 
-    font_texture_ = Texture::make_texture();
-    font_texture_->set_name("imgui-font-texture");
-    font_texture_->setup_2d_texture(width, height, Texture::ComponentType::T_unsigned_byte, Texture::Format::F_red);
-    font_texture_->set_minfilter(SamplerState::FilterType::FT_linear);
-    font_texture_->set_magfilter(SamplerState::FilterType::FT_linear);
+        font_build_task_ = nullptr;
+        font_build_result_ = nullptr;
+    }
 
-    PTA_uchar ram_image = font_texture_->make_ram_image();
-    std::memcpy(ram_image.p(), pixels, width * height * sizeof(decltype(*pixels)));
+    if (wanted_font_bucket_ == font_bucket_)
+        return;
 
-    io.Fonts->TexID = font_texture_.p();
+    // The scale may have moved on while building
+    if (font_atlases_.count(wanted_font_bucket_))
+        use_font_atlas(wanted_font_bucket_);
+    else
+        request_font_atlas(wanted_font_bucket_);
 }
-*/
 
 NodePath Panda3DImGui::create_geomnode(const GeomVertexData* vdata)
 {
@@ -585,6 +1123,12 @@ NodePath Panda3DImGui::create_geomnode(const GeomVertexData* vdata)
 }
 
 void Panda3DImGui::clean_up() {
+    if (!context_)
+        return;
+
+    EventHandler::get_global_event_handler()->remove_hooks_with(this);
+    ImGui::SetCurrentContext(context_);
+    display_region_ = nullptr;
 
 #if defined(_WIN32) || defined(_WIN32)
     if (enable_file_drop_) {
@@ -604,6 +1148,12 @@ void Panda3DImGui::clean_up() {
         ImGuiBackendFlags_HasSetMousePos | 
         ImGuiBackendFlags_HasGamepad);
 
-    ImGui::DestroyContext();
+    if (font_build_task_)
+    {
+        font_build_task_->wait();
+        font_build_task_ = nullptr;
+    }
+
+    ImGui::DestroyContext(context_);
     context_ = nullptr;
 }
@@ -24,6 +24,12 @@
 
 #pragma once
 
+#include <bitset>
+#include <unordered_map>
+
+#include <renderState.h>
+#include <displayRegion.h>
+
 class GraphicsWindow;
 class ButtonHandle;
 class MouseWatcher;
@@ -32,6 +38,10 @@ class Texture;
 class NodePath;
 
 struct ImGuiContext;
+struct ImFontAtlas;
+struct ImDrawData;
+class AsyncTask;
+class Event;
 
 class Panda3DImGui
 {
@@ -40,6 +50,11 @@ public:
     static constexpr const char* SETUP_CONTEXT_EVENT_NAME = "imgui-setup-context";
     static constexpr const char* DROPFILES_EVENT_NAME     = "imgui-dropfiles";
 
+    /** Set these on the window's ButtonThrower, setup_event hooks them. */
+    static constexpr const char* BUTTON_DOWN_EVENT_NAME   = "imgui-button-down";
+    static constexpr const char* BUTTON_UP_EVENT_NAME     = "imgui-button-up";
+    static constexpr const char* KEYSTROKE_EVENT_NAME     = "imgui-keystroke";
+
     enum class Style
     {
         dark = 0,
@@ -47,6 +62,20 @@ public:
         light,
     };
 
+    /** Backend work of the last render_imgui. */
+    struct RenderStats
+    {
+        int num_draw_lists = 0;
+        int num_draw_commands = 0;
+        int num_reparents = 0;          // nodes attached or detached
+        int num_state_misses = 0;       // RenderStates made instead of reused
+        size_t vertex_bytes = 0;        // written, uploaded again on render
+        size_t index_bytes = 0;
+        double cpu_time = 0.0;          // seconds, not counting ImGui::Render
+        double frame_time = 0.0;        // seconds from new_frame_imgui to the end of render_imgui, UI code included
+        bool reused = false;            // draw data unchanged, nothing written
+    };
+
 public:
     Panda3DImGui();
     ~Panda3DImGui();
@@ -58,17 +87,62 @@ public:
     void setup_shader(Shader* shader);
     void setup_font();
     void setup_font(const char* font_filename, float font_size);
+    /** Font file contents owned by the caller, e.g. from FontCache::get_font_data. */
+    void setup_font(const std::vector<unsigned char>* font_data, float font_size);
     void setup_event();
     void enable_file_drop();
 
     void on_window_resized();
     void on_window_resized(const LVecBase2& size);
+
+    /**
+     * Lays the UI out in a region of the window instead of the whole window,
+     * e.g. the game view. The mouse watcher must be on the same region.
+     */
+    void set_display_region(DisplayRegion* display_region);
+    /** Pixel size of the display region, or of the window without one. */
+    LVecBase2 get_display_size() const;
+
+    /** Scale of the UI relative to the initial resolution, fonts are rasterised at a bucket near it. */
+    float get_display_scale() const;
     void on_button_down_or_up(const ButtonHandle& button, bool down);
     void on_keystroke(wchar_t keycode);
 
+    /**
+     * Idle mode: after 'idle_frames' frames without input and with unchanged
+     * draw data, ImGui only runs every 'idle_interval' seconds and the last
+     * uploaded geometry stays on screen in between. Feed input first, then
+     * skip new_frame_imgui and render_imgui when this returns false.
+     * idle_frames = 0 runs every frame.
+     */
+    bool needs_frame();
+    bool is_idle() const;
+    void set_idle_mode(int idle_frames, double idle_interval);
+
+    /** Caps how often this context runs, input in between is kept for the next frame. 0 runs every frame. */
+    void set_frame_rate(double frame_rate);
+    double get_frame_rate() const;
+
+    /**
+     * With several contexts on one window, the one on top disables input of
+     * the others while it wants the mouse. Disabled contexts see no mouse and
+     * all buttons released.
+     */
+    void set_input_enabled(bool enabled);
+    bool is_input_enabled() const;
+
     bool new_frame_imgui();
     bool render_imgui();
 
+    /**
+     * Retained mode (default) keeps the nodes attached, reuses RenderStates and
+     * only writes buffers whose contents changed. Off rebuilds everything each
+     * frame, for comparison.
+     */
+    void set_retained(bool retained);
+    bool is_retained() const;
+    const RenderStats& get_render_stats() const;
+
     ImGuiContext* get_context() const;
     NodePath get_root() const;
 
@@ -83,7 +157,6 @@ public:
 	
 	ImGuiContext* context_ = nullptr;
     MouseWatcher* mouse_watcher = nullptr;
-	std::vector<ButtonHandle> btn_handles;
 	
 	int last_resolution_x;
 	int last_resolution_y;
@@ -91,22 +164,121 @@ public:
 	bool should_repaint;
 
 private:
-    void setup_font_texture();
+    struct FontSource
+    {
+        std::string filename;
+        const std::vector<unsigned char>* data = nullptr;
+        float size = 13.0f;
+    };
+
+    struct FontAtlas
+    {
+        std::unique_ptr<ImFontAtlas> atlas;
+        PT(Texture) texture;
+    };
+
+    static FontAtlas build_font_atlas(const FontSource& source, int scale_bucket);
+    static int get_scale_bucket(float scale);
+    void rebuild_font_atlases();
+    void request_font_atlas(int scale_bucket);
+    void use_font_atlas(int scale_bucket);
+    void update_font_atlas();
     NodePath create_geomnode(const GeomVertexData* vdata);
+    static void on_button_down_event(const Event* event, void* data);
+    static void on_button_up_event(const Event* event, void* data);
+    static void on_keystroke_event(const Event* event, void* data);
+    void set_button_state(bool& state, size_t bit, bool down);
+    static uint64_t hash_draw_data(const ImDrawData* draw_data, float fb_width, float fb_height);
+    CPT(RenderState) get_draw_state(const LVecBase4& clip_rect, void* texture_id, float fb_width, float fb_height);
 
     WPT(GraphicsWindow) window_;
+    PT(DisplayRegion) display_region_;
 	CPT(GeomVertexFormat) vformat_;
     NodePath root_;
-    PT(Texture) font_texture_;
+
+    // Atlases by scale bucket (in percent), built on the "ImGuiFontAtlas"
+    // task chain when the display scale moves to a new bucket.
+    FontSource font_source_;
+    std::unordered_map<int, FontAtlas> font_atlases_;
+    std::unique_ptr<ImFontAtlas> initial_font_atlas_;
+    int font_bucket_ = 100;
+    int wanted_font_bucket_ = 100;
+    // Window size the UI is laid out for at a display scale of 1
+    static constexpr float REFERENCE_WIDTH  = 800.0f;
+    static constexpr float REFERENCE_HEIGHT = 600.0f;
+    float display_scale_ = 1.0f;
+    PT(AsyncTask) font_build_task_;
+    std::shared_ptr<FontAtlas> font_build_result_;
+    int font_build_bucket_ = 0;
     PT(ButtonMap) button_map_;
+
+    // What a button does to ImGui, by ButtonHandle index
+    struct ButtonAction
+    {
+        enum class Type : uint8_t { none = 0, mouse, wheel, key, modifier };
+        Type type = Type::none;
+        int8_t value = 0;   // mouse button, wheel direction or modifier
+    };
+    std::vector<ButtonAction> button_actions_;
+
+    // Buttons pressed since the last NewFrame and their releases waiting for
+    // the next one, keys by index (io.KeysDown) then the mouse buttons.
+    static constexpr int MAX_KEYS = 512;
+    static constexpr int MOUSE_STATE_OFFSET = MAX_KEYS;
+    std::bitset<MAX_KEYS + 5> pressed_buttons_;
+    std::bitset<MAX_KEYS + 5> deferred_releases_;
 	
+    struct DrawCommand
+    {
+        NodePath nodepath;
+        CPT(RenderState) state;
+    };
+
     struct GeomList
     {
         PT(GeomVertexData) vdata; // vertex data shared among the below GeomNodes
-        std::vector<NodePath> nodepaths;
+        NodePath root;            // parent of the command nodes, keeps lists in draw order
+        std::vector<DrawCommand> commands;
+        int num_attached = 0;     // commands under root, always the first ones
     };
     std::vector<GeomList> geom_data_;
 
+    // Scissor and texture states by value, ImGui repeats the same few every frame
+    struct StateKey
+    {
+        LVecBase4 clip_rect;
+        void* texture_id;
+
+        bool operator==(const StateKey& other) const
+        {
+            return clip_rect == other.clip_rect && texture_id == other.texture_id;
+        }
+    };
+    struct StateKeyHash
+    {
+        size_t operator()(const StateKey& key) const;
+    };
+    std::unordered_map<StateKey, CPT(RenderState), StateKeyHash> state_cache_;
+    LVecBase2 state_cache_fb_size_;
+
+    bool retained_ = true;
+    RenderStats render_stats_;
+
+    // Idle mode
+    int idle_frames_ = 30;
+    double idle_interval_ = 0.25;
+    bool input_received_ = true;
+    int frames_without_input_ = 0;
+    int unchanged_frames_ = 0;
+    uint64_t draw_data_hash_ = 0;
+    double last_frame_time_ = 0.0;
+    bool last_has_mouse_ = false;
+    LPoint2 last_mouse_;
+
+    double min_frame_interval_ = 0.0;
+    double frame_start_time_ = 0.0;
+    bool input_enabled_ = true;
+
     class WindowProc;
     std::unique_ptr<WindowProc> window_proc_;
 	
@@ -127,6 +299,31 @@ inline NodePath Panda3DImGui::get_root() const
     return root_;
 }
 
+inline float Panda3DImGui::get_display_scale() const
+{
+    return display_scale_;
+}
+
+inline double Panda3DImGui::get_frame_rate() const
+{
+    return min_frame_interval_ > 0.0 ? 1.0 / min_frame_interval_ : 0.0;
+}
+
+inline bool Panda3DImGui::is_input_enabled() const
+{
+    return input_enabled_;
+}
+
+inline bool Panda3DImGui::is_retained() const
+{
+    return retained_;
+}
+
+inline const Panda3DImGui::RenderStats& Panda3DImGui::get_render_stats() const
+{
+    return render_stats_;
+}
+
 inline const std::vector<Filename>& Panda3DImGui::get_dropped_files() const
 {
     return dropped_files_;
@@ -0,0 +1,101 @@
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <filename.h>
+#include <loaderOptions.h>
+
+#include "exportMacros.hpp"
+
+// Project local cache of binary converted assets, e.g. '.egg' and '.egg.pz'
+// models are converted to '.bam' the first time they are loaded and later
+// loads read the '.bam' instead. Entries are keyed by the content hash of
+// the source, the loader options and the engine version, so changing any
+// of them makes the old entry stale, stale entries are removed.
+class ENGINE_API AssetCache {
+public:
+    struct Stats {
+        unsigned int hits          = 0;
+        unsigned int misses        = 0;
+        unsigned int conversions   = 0;
+        unsigned int failures      = 0;
+        unsigned int invalidations = 0;
+    };
+
+    AssetCache();
+
+    void set_cache_dir(const std::string& cache_dir);
+    const Filename& get_cache_dir() const;
+    bool is_enabled() const;
+    void set_enabled(bool enabled);
+
+    // Source assets that benefit from a binary conversion
+    static bool is_cacheable(const std::string& path);
+
+    // Returns the cached file for 'source' if there is a valid one,
+    // otherwise an empty Filename. Counts a hit or a miss.
+    Filename lookup(const std::string& source, const LoaderOptions& options, const std::string& extension = ".bam");
+
+    // Writes the converted 'source' (resolved) to 'output', runs on a loader thread
+    using ConvertFn = std::function<bool(const Filename& source, const Filename& output)>;
+
+    // Converts 'source' to '.bam' on the resource loader threads
+    void convert_model_async(const std::string& source, const LoaderOptions& options, const std::string& task_chain);
+
+    // Converts 'source' with 'convert' on the resource loader threads, the
+    // result is found by lookup with the same options and extension.
+    void convert_async(
+        const std::string& source,
+        const LoaderOptions& options,
+        const std::string& extension,
+        const std::string& task_chain,
+        ConvertFn convert);
+
+    // Path in the cache the converted 'source' is written to (whether it exists or not)
+    Filename get_cache_filename(const std::string& source, const LoaderOptions& options, const std::string& extension);
+
+    // Marks a background written entry as valid, thread safe. 'source_key'
+    // is the resolved source path followed by the cache file extension.
+    void commit(const std::string& source_key, const Filename& cache_filename);
+
+    Stats get_stats() const;
+    void reset_stats();
+
+private:
+    struct SourceInfo {
+        time_t mtime;
+        std::streamsize size;
+        uint64_t content_hash;
+    };
+
+    Filename resolve(const std::string& source) const;
+    bool get_content_hash(const Filename& resolved, uint64_t& hash);
+    std::string make_key(const Filename& resolved, const LoaderOptions& options, const std::string& extension);
+    void load_index();
+    void save_index();
+    void invalidate(const std::string& source_key, const std::string& new_cache_file);
+
+    Filename _cache_dir;
+    bool _enabled;
+
+    // source fullpath (+ extension) -> cache file basename, persisted in 'index.txt'
+    std::unordered_map<std::string, std::string> _index;
+    std::unordered_map<std::string, SourceInfo> _source_infos;
+    std::unordered_set<std::string> _converting;
+    mutable std::mutex _mutex;
+
+    std::atomic<unsigned int> _hits;
+    std::atomic<unsigned int> _misses;
+    std::atomic<unsigned int> _conversions;
+    std::atomic<unsigned int> _failures;
+    std::atomic<unsigned int> _invalidations;
+};
+
+#endif // ASSET_CACHE_H
@@ -0,0 +1,159 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <virtualFileMount.h>
+
+#include "exportMacros.hpp"
+
+// Read only view of a whole file mapped into memory
+class ENGINE_API MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& os_path);
+    void close();
+
+    const unsigned char* get_data() const;
+    size_t get_size() const;
+    bool is_open() const;
+
+private:
+    const unsigned char* _data;
+    size_t _size;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#else
+    int _fd;
+#endif
+};
+
+// Single file asset pack. Layout:
+//
+//   Header     magic, version, entry count, index offset
+//   Data       entries, each aligned to the pack alignment
+//   Index      entries sorted by path, followed by the path strings
+//
+// Entries are stored as is or zlib compressed, uncompressed entries are
+// read straight from the mapped file.
+class ENGINE_API AssetPack {
+public:
+    static const uint32_t MAGIC   = 0x4b504450; // "PDPK"
+    static const uint32_t VERSION = 1;
+
+    enum EntryFlags {
+        EF_compressed = 0x01,
+    };
+
+#pragma pack(push, 1)
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t num_entries;
+        uint32_t alignment;
+        uint64_t index_offset;
+        uint64_t index_size;
+    };
+
+    struct IndexEntry {
+        uint32_t path_offset;
+        uint32_t path_length;
+        uint64_t data_offset;
+        uint64_t stored_size;
+        uint64_t original_size;
+        uint32_t flags;
+        uint32_t timestamp;
+    };
+#pragma pack(pop)
+
+    struct Input {
+        std::string path;       // path inside the pack, '/' separated
+        std::string os_path;    // file to read it from
+    };
+
+    bool open(const std::string& os_path);
+    void close();
+    bool is_open() const;
+    const std::string& get_os_path() const;
+
+    // Returns nullptr if there is no entry with that path
+    const IndexEntry* find(const std::string& path) const;
+    bool is_directory(const std::string& path) const;
+    std::string get_path(const IndexEntry& entry) const;
+    size_t get_num_entries() const;
+
+    // Stored bytes of an entry, inside the mapped file
+    const unsigned char* get_stored_data(const IndexEntry& entry) const;
+
+    // Names of the entries and sub directories directly inside 'dir'
+    void list_directory(const std::string& dir, std::vector<std::string>& names) const;
+
+    // Writes a pack, returns false on error. Entries are only kept
+    // compressed if that saves at least an eighth of their size.
+    static bool write(
+        const std::string& os_path,
+        std::vector<Input> inputs,
+        bool compress = false,
+        uint32_t alignment = 64);
+
+private:
+    MappedFile _file;
+    std::string _os_path;
+    const Header* _header = nullptr;
+    const IndexEntry* _entries = nullptr;
+    const char* _strings = nullptr;
+
+    // directory -> names inside it, built once on open
+    std::map<std::string, std::vector<std::string>> _directories;
+};
+
+// Mounts an asset pack into Panda's VirtualFileSystem, e.g.
+//
+//   VirtualFileSystem::get_global_ptr()->mount(new AssetPackMount(pack), "/assets", 0);
+class ENGINE_API AssetPackMount : public VirtualFileMount {
+public:
+    explicit AssetPackMount(std::shared_ptr<AssetPack> pack);
+
+    virtual bool has_file(const Filename& file) const;
+    virtual bool is_directory(const Filename& file) const;
+    virtual bool is_regular_file(const Filename& file) const;
+
+    virtual bool read_file(const Filename& file, bool do_uncompress, vector_uchar& result) const;
+    virtual std::istream* open_read_file(const Filename& file) const;
+    virtual std::streamsize get_file_size(const Filename& file, std::istream* stream) const;
+    virtual std::streamsize get_file_size(const Filename& file) const;
+    virtual time_t get_timestamp(const Filename& file) const;
+    virtual bool get_system_info(const Filename& file, SubfileInfo& info);
+    virtual bool scan_directory(vector_string& contents, const Filename& dir) const;
+
+    virtual void output(std::ostream& out) const;
+
+    const std::shared_ptr<AssetPack>& get_pack() const;
+
+private:
+    std::shared_ptr<AssetPack> _pack;
+
+public:
+    static TypeHandle get_class_type() { return _type_handle; }
+    static void init_type() {
+        VirtualFileMount::init_type();
+        register_type(_type_handle, "AssetPackMount", VirtualFileMount::get_class_type());
+    }
+    virtual TypeHandle get_type() const { return get_class_type(); }
+    virtual TypeHandle force_init_type() { init_type(); return get_class_type(); }
+
+private:
+    static TypeHandle _type_handle;
+};
+
+#endif // ASSET_PACK_H
@@ -0,0 +1,68 @@
+#ifndef ASYNC_LOAD_H
+#define ASYNC_LOAD_H
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <asyncTask.h>
+#include <nodePath.h>
+#include <texture.h>
+
+#include "exportMacros.hpp"
+
+class AsyncLoad;
+using AsyncLoadHandle = std::shared_ptr<AsyncLoad>;
+using AsyncLoadCallback = std::function<void(const AsyncLoadHandle&)>;
+
+// A model or texture being loaded on the resource loader threads, see
+// ResourceManager::load_model_async and ResourceManager::load_texture_async.
+// Completion callbacks are always delivered on the main thread.
+class ENGINE_API AsyncLoad {
+public:
+    enum Type {
+        MODEL,
+        TEXTURE,
+    };
+
+    enum Status {
+        PENDING,
+        LOADED,
+        FAILED,
+        CANCELLED,
+    };
+
+    AsyncLoad(Type type, const std::string& path, int priority);
+
+    // Finished loading (successfully or not) or cancelled
+    bool is_ready() const;
+    Status get_status() const;
+    void cancel();
+
+    // Valid once the load is ready
+    NodePath get_model() const;
+    PT(Texture) get_texture() const;
+
+    Type get_type() const;
+    const std::string& get_path() const;
+    int get_priority() const;
+
+private:
+    friend class ResourceManager;
+
+    Type _type;
+    std::string _path;
+    int _priority;
+    bool _cancelled;
+    bool _delivered;
+
+    PT(AsyncTask) _task;
+    PT(PandaNode) _model;
+    PT(Texture) _texture;
+    AsyncLoadCallback _callback;
+    // Delivered from update() instead of the callback once cancelled,
+    // lets a batch count its cancelled loads
+    AsyncLoadCallback _cancel_callback;
+};
+
+#endif // ASYNC_LOAD_H
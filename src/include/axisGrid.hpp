@@ -9,13 +9,25 @@
 // Forward declarations
 class GeomNode;
 
+// Ground grid on the XY plane with the X and Y axes.
+//
+// By default a single full screen quad, the axis_grid shaders find the
+// plane under each pixel and draw the lines there, so the cost doesn't
+// depend on the extent. The cell size follows the camera height in
+// powers of 'sub_divisions' and lines fade out with distance. Without
+// shader support it falls back to LineSegs lines over +-grid_size.
 class AxisGrid : public NodePath {
 public:
     AxisGrid(float grid_size = 100, float grid_step = 10, int sub_divisions = 10);
 	
-    void create();
+    void create(bool use_shader = true);
+    bool is_shader_grid() const;
+    // Shader grid only, in camera heights
+    void set_fade_distance(float fade_distance);
     
 private:
+    bool _create_shader_grid();
+    void _create_line_grid();
     void _draw_grid_lines(float step, LineSegs& line_seg);
     void _draw_axis(const std::string& axis, LineSegs& line_seg);
     void _attach_lines(LineSegs& line_seg);
@@ -26,6 +38,8 @@ private:
     int sub_divisions;
 
     bool show_end_cap_lines;
+    bool shader_grid;
+    float fade_distance;
 
     LVecBase4 x_axis_color;
     LVecBase4 y_axis_color;
@@ -0,0 +1,159 @@
+#ifndef CO_TASK_H
+#define CO_TASK_H
+
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+#include <nodePath.h>
+#include <texture.h>
+
+#include "exportMacros.hpp"
+#include "asyncLoad.hpp"
+
+// Fixed size-class free lists for coroutine frames, so that short lived
+// coroutines don't hit the general purpose heap on every call.
+// Coroutines are created and resumed on the main thread only.
+class ENGINE_API CoFramePool {
+public:
+    static void* allocate(std::size_t size);
+    static void  deallocate(void* ptr, std::size_t size);
+
+    // Releases all unused blocks back to the heap
+    static void trim();
+};
+
+// Return type of a coroutine driven by the engine loop, a coroutine starts
+// executing immediately when called and runs until its first co_await.
+class ENGINE_API CoTask {
+public:
+    struct State {
+        bool done      = false;
+        bool cancelled = false;
+    };
+
+    struct promise_type {
+        std::shared_ptr<State> state = std::make_shared<State>();
+
+        CoTask get_return_object() { return CoTask(state); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() { state->done = true; }
+        void unhandled_exception();
+
+        static void* operator new(std::size_t size) { return CoFramePool::allocate(size); }
+        static void  operator delete(void* ptr, std::size_t size) { CoFramePool::deallocate(ptr, size); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    CoTask() = default;
+
+    bool is_done() const { return !state || state->done; }
+    bool is_cancelled() const { return state && state->cancelled; }
+    void cancel();
+
+private:
+    explicit CoTask(std::shared_ptr<State> state) : state(std::move(state)) {}
+    std::shared_ptr<State> state;
+};
+
+// Owns every suspended coroutine and resumes them from the engine loop.
+class ENGINE_API CoScheduler {
+public:
+    static CoScheduler& get_instance();
+
+    // Called once per frame by the engine loop, after events are dispatched.
+    void tick();
+    void on_event(const std::string& event_name);
+    void clear();
+
+    void wait_frames(CoTask::Handle handle, int num_frames);
+    void wait_seconds(CoTask::Handle handle, double seconds);
+    void wait_event(CoTask::Handle handle, const std::string& event_name);
+    void wait_load(CoTask::Handle handle, const AsyncLoadHandle& load);
+
+    size_t get_num_waiting() const;
+    unsigned long long get_frame_count() const;
+
+private:
+    friend class CoTask;
+
+    CoScheduler() = default;
+
+    void resume(CoTask::Handle handle);
+    bool destroy_if_cancelled(CoTask::Handle handle);
+    void reap_cancelled();
+
+    unsigned long long _frame_count = 0;
+
+    std::vector<std::pair<unsigned long long, CoTask::Handle>> _frame_waiters;
+    std::multimap<double, CoTask::Handle> _timed_waiters;
+    std::unordered_multimap<std::string, CoTask::Handle> _event_waiters;
+    std::vector<std::pair<AsyncLoadHandle, CoTask::Handle>> _load_waiters;
+
+    // handles woken up by events, resumed on the next tick
+    std::vector<CoTask::Handle> _ready;
+    // scratch buffer, kept around to avoid per frame allocations
+    std::vector<CoTask::Handle> _resume_list;
+};
+
+// ------------------------------------ awaitables ------------------------------------ //
+struct CoWaitFrames {
+    int num_frames;
+    bool await_ready() const noexcept { return num_frames <= 0; }
+    void await_suspend(CoTask::Handle handle) { CoScheduler::get_instance().wait_frames(handle, num_frames); }
+    void await_resume() const noexcept {}
+};
+
+struct CoWaitSeconds {
+    double seconds;
+    bool await_ready() const noexcept { return seconds <= 0.0; }
+    void await_suspend(CoTask::Handle handle) { CoScheduler::get_instance().wait_seconds(handle, seconds); }
+    void await_resume() const noexcept {}
+};
+
+struct CoWaitEvent {
+    std::string event_name;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(CoTask::Handle handle) { CoScheduler::get_instance().wait_event(handle, event_name); }
+    void await_resume() const noexcept {}
+};
+
+struct CoWaitModel {
+    AsyncLoadHandle load;
+    bool await_ready() const { return load == nullptr || load->is_ready(); }
+    void await_suspend(CoTask::Handle handle) { CoScheduler::get_instance().wait_load(handle, load); }
+    NodePath await_resume() const { return load ? load->get_model() : NodePath(); }
+};
+
+struct CoWaitTexture {
+    AsyncLoadHandle load;
+    bool await_ready() const { return load == nullptr || load->is_ready(); }
+    void await_suspend(CoTask::Handle handle) { CoScheduler::get_instance().wait_load(handle, load); }
+    PT(Texture) await_resume() const { return load ? load->get_texture() : nullptr; }
+};
+
+// Suspend until the next frame
+inline CoWaitFrames next_frame() { return CoWaitFrames{ 1 }; }
+
+// Suspend for the given number of frames
+inline CoWaitFrames wait_frames(int num_frames) { return CoWaitFrames{ num_frames }; }
+
+// Suspend for the given number of seconds of frame time
+inline CoWaitSeconds wait_seconds(double seconds) { return CoWaitSeconds{ seconds }; }
+
+// Suspend until an engine event with the given name is triggered
+inline CoWaitEvent wait_event(const std::string& event_name) { return CoWaitEvent{ event_name }; }
+
+// Suspend until an async model load completes, see ResourceManager::load_model_async
+inline CoWaitModel wait_model(const AsyncLoadHandle& load) { return CoWaitModel{ load }; }
+
+// Suspend until an async texture load completes, see ResourceManager::load_texture_async
+inline CoWaitTexture wait_texture(const AsyncLoadHandle& load) { return CoWaitTexture{ load }; }
+
+#endif // CO_TASK_H
@@ -0,0 +1,125 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include <string>
+#include <vector>
+
+#include <geom.h>
+#include <geomVertexData.h>
+#include <nodePath.h>
+
+#include "exportMacros.hpp"
+
+// Immediate mode debug lines and text. Anything drawn lasts until the
+// next update, so scripts draw again every frame what they want to see.
+//
+// Lines go to one streaming vertex buffer per category (world, world on
+// top of everything, screen) that is rewritten in place each update and
+// drawn in a single call, so thousands of lines cost about three draw
+// calls. Text labels come from a pool of TextNodes that only regenerate
+// when their text changes, one draw call each.
+class ENGINE_API DebugDraw {
+public:
+    enum Mode {
+        DEPTH_TESTED,   // hidden behind the scene
+        OVERLAY         // always on top
+    };
+
+    DebugDraw();
+    ~DebugDraw();
+
+    // World space under 'world_root', screen space under a pixel root
+    // (PGTop scaled to pixels, origin at the top left)
+    void initialize(NodePath world_root, NodePath screen_root);
+    void shutdown();
+
+    // Moves screen space drawing under another pixel root, e.g. the game's
+    void set_screen_root(NodePath screen_root);
+
+    void set_enabled(bool enabled);
+    bool is_enabled() const;
+
+    // World space
+    void line(const LPoint3& from, const LPoint3& to, const LColor& color, Mode mode = DEPTH_TESTED);
+    void box(const LPoint3& min_point, const LPoint3& max_point, const LColor& color, Mode mode = DEPTH_TESTED);
+    // Box given in the space of 'transform', e.g. a node's net transform
+    void box(const LMatrix4& transform, const LPoint3& min_point, const LPoint3& max_point, const LColor& color, Mode mode = DEPTH_TESTED);
+    // Three circles around the axes
+    void sphere(const LPoint3& center, float radius, const LColor& color, Mode mode = DEPTH_TESTED, int segments = 24);
+    // 'head_size' is a fraction of the length
+    void arrow(const LPoint3& from, const LPoint3& to, const LColor& color, Mode mode = DEPTH_TESTED, float head_size = 0.2f);
+    // X, Y and Z of 'transform' in red, green and blue
+    void axes(const LMatrix4& transform, float size = 1.0f, Mode mode = DEPTH_TESTED);
+    // Billboarded, 'scale' in world units
+    void text(const LPoint3& pos, const std::string& text, const LColor& color, Mode mode = OVERLAY, float scale = 0.5f);
+
+    // Screen space in pixels from the top left of the screen root
+    void line_2d(const LPoint2& from, const LPoint2& to, const LColor& color);
+    void rect_2d(const LPoint2& min_point, const LPoint2& max_point, const LColor& color);
+    void text_2d(const LPoint2& pos, const std::string& text, const LColor& color, float scale = 16.0f);
+
+    // Once a frame before rendering: uploads what was drawn since the
+    // last call and starts over
+    void update();
+    void clear();
+
+    // Of the last update
+    int get_num_lines() const;
+    int get_num_labels() const;
+
+private:
+    enum Batch { WORLD, WORLD_OVERLAY, SCREEN, NUM_BATCHES };
+
+    // Matches the vertex format, written to the buffer as is
+    struct Vertex {
+        float x, y, z;
+        unsigned char color[4];
+    };
+
+    struct LineBatch {
+        std::vector<Vertex> vertices;
+        PT(GeomVertexData) vdata;
+        PT(Geom) geom;
+        NodePath np;
+    };
+
+    struct Label {
+        std::string text;
+        LPoint3 pos;
+        LColor color;
+        float scale;
+        Batch batch;
+    };
+
+    struct TextSlot {
+        NodePath np;
+        std::string text;
+        LColor color;
+        Batch batch;
+    };
+
+    void add_line(Batch batch, const LPoint3& from, const LPoint3& to, const LColor& color);
+    void add_label(Batch batch, const LPoint3& pos, const std::string& text, const LColor& color, float scale);
+    void upload(LineBatch& batch);
+    void update_labels();
+
+    static Batch world_batch(Mode mode);
+
+    bool _enabled;
+    NodePath _world_root;
+    NodePath _screen_root;
+    LineBatch _batches[NUM_BATCHES];
+
+    // Labels are reused, only the first _num_labels are current
+    std::vector<Label> _labels;
+    size_t _num_labels;
+    std::vector<TextSlot> _text_slots;
+    size_t _num_shown_slots;
+
+    // Unit circle for spheres, rebuilt when the segment count changes
+    std::vector<LVecBase2> _circle;
+
+    int _num_lines;
+};
+
+#endif // DEBUG_DRAW_H
@@ -11,6 +11,7 @@
 #include "engine.hpp"
 #include "game.hpp"
 #include "p3d_Imgui.hpp"
+#include "offscreenView.hpp"
 #include "dllLoader.hpp"
 
 class ENGINE_API Demon {
@@ -48,6 +49,8 @@ public:
 	void update_game_view(GameViewStyle style);
 	void update_game_view(GameViewStyle style, float width,  float height);
     bool is_game_mode();
+    // The game's ImGui wants the mouse, game mouse events are not dispatched
+    bool is_mouse_over_game_ui() const;
     
     const DllLoader& get_dll_loader() const;
     
@@ -58,8 +61,19 @@ public:
 	GameViewSettings game_view_default = {GameViewStyle::BOTTOM_LEFT, 0.3f};
     PT(MouseWatcherRegion) game_mw_region;
     
-    // ImGUI instance
+    // ImGUI instances, editor UI over the whole window and game UI in the
+    // game view's pixel2D, each with its own input, frame rate and timings
     Panda3DImGui p3d_imgui;
+    Panda3DImGui game_imgui;
+
+    // Editor and game viewports rendered to textures and shown as ImGui
+    // panels, with 'docked_views on' in config
+    OffscreenView editor_viewport;
+    OffscreenView game_viewport;
+    bool is_docked_views() const;
+
+    // Off prunes game.render from the editor camera's cull traversal
+    void set_game_scene_in_editor(bool show);
     
 private:
     Demon();
@@ -71,16 +85,31 @@ private:
 	// Methods
     void load_config(const std::string& filepath);
 	void setup_paths();
+	void setup_docked_views();
+	void update_docked_views();
+	void update_editor_view();
 	
 	// ImGui fields and methods
 	void init_imgui(Panda3DImGui *panda3d_imgui, NodePath *parent, MouseWatcher* mw, std::string name);
 	void imgui_update();
+	bool update_imgui(Panda3DImGui& imgui, const char* event_name, bool input_enabled);
 	
 	// Fields    
     bool _is_started;
 	bool _cleaned_up;
 	bool _game_mode_enabled;
 	bool _mouse_over_ui;
+	bool _mouse_over_game_ui;
+	bool _keyboard_over_ui;
+	bool _show_load_telemetry;
+	bool _docked_views;
+	bool _show_editor_viewport;
+	bool _show_game_viewport;
+	bool _editor_view_panel_shown;
+	double _editor_ui_time;
+	bool _hide_editor_view_in_game;
+	double _editor_view_hz;
+	double _editor_view_game_mode_hz;
 	int  _num_frames_since_last_repait;
     
 	// Delete the 'delete' operator to prevent manual deletion
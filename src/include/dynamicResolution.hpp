@@ -0,0 +1,51 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include "exportMacros.hpp"
+
+// Render scale controller for a frame time target. Fed the frame time
+// once a frame, it lowers the scale when the smoothed frame time is over
+// the target and raises it when there is headroom, with a cooldown
+// between changes so it doesn't oscillate.
+//
+// With vsync frames never come in under the target, so after holding
+// the target for 'probe_interval' it tries one step up, and if that
+// misses it goes back and waits twice as long before the next try.
+class ENGINE_API DynamicResolution {
+public:
+    struct Settings {
+        double target_frame_time = 1.0 / 60.0;
+        float min_scale          = 0.5f;
+        float max_scale          = 1.0f;
+        float step               = 0.05f;
+        double tolerance         = 1.1;   // scale down over target * tolerance
+        double headroom          = 0.85;  // scale up under target * headroom
+        int cooldown_frames      = 30;
+        double probe_interval    = 2.0;   // seconds
+    };
+
+    DynamicResolution();
+
+    void set_settings(const Settings& settings);
+    const Settings& get_settings() const;
+
+    // Returns the scale to render the next frame at
+    float update(double frame_time);
+    void reset();
+
+    float get_scale() const;
+    double get_average_frame_time() const;
+
+private:
+    void set_scale(float scale);
+
+    Settings _settings;
+    float _scale;
+    double _average;
+    int _frames_since_change;
+    double _time_at_target;
+    double _probe_interval;
+    bool _probing;
+};
+
+#endif // DYNAMIC_RESOLUTION_H
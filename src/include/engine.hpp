@@ -35,8 +35,12 @@
 #include "exportMacros.hpp"
 #include "sceneCam.hpp"
 #include "axisGrid.hpp"
+#include "debugDraw.hpp"
 #include "resourceManager.hpp"
 #include "mouse.hpp"
+#include "jobSystem.hpp"
+#include "timerWheel.hpp"
+#include "idleQueue.hpp"
 
 class ENGINE_API Engine {
 public:
@@ -69,6 +73,7 @@ public:
     PT(DisplayRegion)     dr2D;
 
     PT(MouseWatcher)      mouse_watcher;
+    PT(ButtonThrower)     button_thrower;
 	
     NodePath              data_root;
     DataGraphTraverser    data_graph_trav;
@@ -86,6 +91,10 @@ public:
     Mouse                 mouse;
     ResourceManager       resource_manager;
     AxisGrid              axis_grid;
+    DebugDraw             debug_draw;
+    JobSystem             job_system;
+    TimerService          timers;
+    IdleQueue             idle_queue;
 	
     std::unordered_map<EventKey, std::function<void()>, EventKey::Hash> event_handlers;
     std::unordered_map<std::string, std::function<void(const std::string&)>> event_listeners;
@@ -95,6 +104,7 @@ public:
     // methods
     void clean_up();
     void update();
+    void update_coroutines();
     
     void accept(const std::string& event_name, std::function<void()> callback);
     void accept(
@@ -113,12 +123,15 @@ public:
     void remove_event_listener(const std::string&);
     void clear_event_listeners();
  
-	void dispatch_events(bool ignore_mouse = false);
+	void dispatch_events(bool ignore_mouse = false, bool ignore_keyboard = false);
     void on_evt_size();
     void show_axis_grid(bool show = false);
 
 	float get_aspect_ratio();
     LVecBase2i get_size();
+
+    // Off while the scene camera renders into a view of its own shape
+    void set_scene_cam_follows_window(bool follows);
     
 	void set_mouse_mode(int mouse_mode_idx);
  
@@ -135,9 +148,10 @@ private:
 	int current_mouse_mode;
         
 	// cache
-	std::vector<std::pair<CPT_Event, std::vector<void*>>> panda_events;
+	std::vector<CPT_Event> panda_events;
     LVecBase2i window_size;
     float aspect_ratio;
+    bool scene_cam_follows_window;
 };
 
 #endif
\ No newline at end of file
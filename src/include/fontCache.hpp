@@ -0,0 +1,79 @@
+#ifndef FONT_CACHE_H
+#define FONT_CACHE_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <textFont.h>
+#include <textGlyph.h>
+#include <texture.h>
+
+#include "exportMacros.hpp"
+
+class AssetCache;
+
+// A font whose glyphs were rasterised earlier and saved as atlas pages,
+// see FontCache. Glyphs missing from the atlas come from a fallback font.
+class ENGINE_API AtlasTextFont : public TextFont {
+public:
+    AtlasTextFont();
+
+    // Reads the metrics file and its pages, written by FontCache
+    bool read(const Filename& metrics_file);
+    void set_fallback(TextFont* font);
+
+    virtual PT(TextFont) make_copy() const;
+    virtual bool get_glyph(int character, CPT(TextGlyph)& glyph);
+
+private:
+    std::vector<PT(Texture)> _pages;
+    std::unordered_map<int, CPT(TextGlyph)> _glyphs;
+    PT(TextFont) _fallback;
+
+public:
+    static TypeHandle get_class_type() { return _type_handle; }
+    static void init_type() {
+        TextFont::init_type();
+        register_type(_type_handle, "AtlasTextFont", TextFont::get_class_type());
+    }
+    virtual TypeHandle get_type() const { return get_class_type(); }
+    virtual TypeHandle force_init_type() { init_type(); return get_class_type(); }
+
+private:
+    static TypeHandle _type_handle;
+};
+
+// Shared fonts keyed by font file, pixel size and signed distance field
+// mode. The first load rasterises a character set and saves the glyph
+// pages and metrics to the asset cache, later loads (and later runs)
+// read the saved atlas instead of rasterising again.
+class ENGINE_API FontCache {
+public:
+    explicit FontCache(AssetCache& asset_cache);
+
+    PT(TextFont) load(
+        const std::string& path,
+        int pixel_size = 32,
+        bool sdf = false,
+        const std::string& charset = get_default_charset());
+
+    // Raw font file contents read through the VirtualFileSystem (so packed
+    // fonts work too), e.g. for ImGui's AddFontFromMemoryTTF. Stays valid
+    // until clear().
+    const std::vector<unsigned char>* get_font_data(const std::string& path);
+
+    void clear();
+
+    // Printable ASCII and Latin-1, as UTF-8
+    static const std::string& get_default_charset();
+
+private:
+    bool write_atlas(TextFont* font, const std::wstring& characters, const Filename& metrics_file);
+
+    AssetCache& _asset_cache;
+    std::unordered_map<std::string, PT(TextFont)> _fonts;
+    std::unordered_map<std::string, std::vector<unsigned char>> _font_data;
+};
+
+#endif // FONT_CACHE_H
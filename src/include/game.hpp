@@ -2,6 +2,8 @@
 #define GAME_H
 
 #include "p3d_Imgui.hpp"
+#include "offscreenView.hpp"
+#include "dynamicResolution.hpp"
 
 class Demon;
 
@@ -9,10 +11,20 @@ class Game {
 public:
     explicit Game(Demon& demon);
     void init();
-    void update();
+    // 'editor_time' is what the editor took of the last frame
+    void update(double editor_time = 0.0);
     void on_evt_size();
     void on_evt(const std::string& event_name); // Pass string by const reference
 
+    // Scales the game view's resolution to hold the frame time target. With
+    // 'render_offscreen' the 3D view renders to a buffer at that scale and
+    // dr3D shows it upsampled, otherwise only the scale is computed, for
+    // views already rendering offscreen (docked views).
+    void enable_dynamic_resolution(const DynamicResolution::Settings& settings, bool render_offscreen = true);
+    void disable_dynamic_resolution();
+    bool is_dynamic_resolution() const;
+    float get_render_scale() const;
+
     NodePath          game_render;
     NodePath          render;
     
@@ -28,6 +40,7 @@ public:
     PT(MouseWatcher)  mouse_watcher;
     
     Mouse             mouse;
+    DynamicResolution dynamic_resolution;
 
 private:
     Demon& demon;
@@ -35,6 +48,16 @@ private:
     void create_dr2D();
     void create_dr3D();
     void create_mouse_watcher_3D();
+    void update_dynamic_resolution(double editor_time);
+    void update_pixel2D();
+
+    bool              _dynamic_resolution = false;
+    OffscreenView     _scaled_view;
+    NodePath          _upsample_root;
+    NodePath          _upsample_card;
+    NodePath          _upsample_cam;
+    LVecBase2         _upsample_tex_scale;
+    LVecBase2i        _pixel2D_size;
 };
 
 #endif // GAME_H
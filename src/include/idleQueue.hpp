@@ -0,0 +1,60 @@
+#ifndef IDLE_QUEUE_H
+#define IDLE_QUEUE_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "exportMacros.hpp"
+
+// Low priority background work that only runs in the time left over
+// after a frame is rendered. Work is split into resumable chunks, a work
+// function does one chunk per call and returns true once it is finished,
+// unfinished work carries over to the next frame.
+class ENGINE_API IdleQueue {
+public:
+    // Receives the deadline (TrueClock time) the chunk should finish by
+    using WorkFn = std::function<bool(double deadline)>;
+
+    IdleQueue();
+
+    // Higher priority work runs first, equal priorities run in FIFO order.
+    // Adding work with a name that is already queued replaces it.
+    void add(const std::string& name, WorkFn work, int priority = 0);
+    void remove(const std::string& name);
+    bool has(const std::string& name) const;
+    void clear();
+
+    // Called after render_frame, with the TrueClock time the frame started at
+    void run(double frame_start_time);
+
+    void set_target_frame_time(double seconds);
+    void set_safety_margin(double seconds);
+    void set_max_starved_frames(int num_frames);
+
+    double get_target_frame_time() const;
+    double get_last_idle_time() const;
+    size_t get_num_pending() const;
+
+private:
+    struct WorkItem {
+        std::string name;
+        WorkFn work;
+        int priority;
+        unsigned long long sequence;
+    };
+
+    std::vector<WorkItem> _items;
+    unsigned long long _next_sequence;
+
+    double _target_frame_time;
+    double _safety_margin;
+    double _last_idle_time;
+
+    // Run one chunk anyway after this many frames with no time to spare,
+    // so maintenance still completes on machines that never hit the target.
+    int _max_starved_frames;
+    int _num_starved_frames;
+};
+
+#endif // IDLE_QUEUE_H
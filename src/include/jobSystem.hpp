@@ -0,0 +1,101 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "exportMacros.hpp"
+
+class JobCounter;
+
+struct Job {
+    std::function<void()> fn;
+    JobCounter* counter = nullptr;
+};
+
+// Counts the unfinished jobs of a group, jobs can be made to
+// wait on a counter with JobSystem::run_after.
+class ENGINE_API JobCounter {
+public:
+    JobCounter() : _value(0) {}
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    int get_value() const { return _value.load(std::memory_order_acquire); }
+    bool is_done() const { return get_value() == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int> _value;
+    std::mutex _mutex;
+    std::vector<Job> _continuations;
+};
+
+// Engine owned pool of worker threads, each worker has its own deque, it
+// pops its own jobs LIFO and steals the oldest jobs of other workers when
+// it runs dry. Threads that wait on a counter help executing jobs.
+class ENGINE_API JobSystem {
+public:
+    JobSystem();
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // num_workers < 0 uses one worker per hardware thread, minus the main thread
+    void start(int num_workers = -1);
+    void stop();
+
+    bool is_running() const;
+    int get_num_workers() const;
+
+    // Schedules a job, if a counter is given it is incremented now and
+    // decremented when the job finishes.
+    void run(std::function<void()> fn, JobCounter* counter = nullptr);
+
+    // Schedules a job once all jobs counted by 'dependency' have finished.
+    void run_after(JobCounter& dependency, std::function<void()> fn, JobCounter* counter = nullptr);
+
+    // Blocks until the counter reaches zero, executing pending jobs meanwhile.
+    void wait(JobCounter& counter);
+
+    // Calls fn(range_begin, range_end) for sub-ranges of [begin, end) on all
+    // workers and returns when all of them are done. grain = 0 picks a size
+    // that gives every worker a few ranges to balance the load.
+    void parallel_for(
+        size_t begin,
+        size_t end,
+        const std::function<void(size_t, size_t)>& fn,
+        size_t grain = 0);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void submit(Job&& job);
+    void execute(Job& job);
+    void finish(JobCounter* counter);
+    bool try_get_job(int queue_index, Job& job);
+    void worker_loop(int worker_index);
+
+    // one queue per worker + one shared queue for non worker threads (last)
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;
+    std::vector<std::thread> _threads;
+
+    std::atomic<bool> _running;
+    std::atomic<int>  _num_pending;
+
+    std::mutex _sleep_mutex;
+    std::condition_variable _sleep_cv;
+};
+
+#endif // JOB_SYSTEM_H
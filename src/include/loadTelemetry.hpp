@@ -0,0 +1,100 @@
+#ifndef LOAD_TELEMETRY_H
+#define LOAD_TELEMETRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <filename.h>
+
+#include "exportMacros.hpp"
+
+// Per asset load timings recorded by the ResourceManager load paths, from
+// any thread. Each load is split into I/O (resolving and cache lookups),
+// decode (the Panda loader call, which reads and parses the file in one
+// go) and post-processing (registration, copies, streaming setup).
+// Loads over the thresholds are flagged in the panel and the export.
+class ENGINE_API LoadTelemetry {
+public:
+    enum CacheResult {
+        CACHE_NONE,
+        CACHE_HIT,
+        CACHE_MISS,
+    };
+
+    struct Record {
+        std::string path;
+        std::string kind;
+        std::string thread;
+        // seconds
+        double io_time       = 0.0;
+        double decode_time   = 0.0;
+        double post_time     = 0.0;
+        size_t bytes         = 0;
+        CacheResult cache    = CACHE_NONE;
+        bool async           = false;
+        bool failed          = false;
+
+        double get_total_time() const { return io_time + decode_time + post_time; }
+    };
+
+    struct Thresholds {
+        double slow_ms     = 50.0;
+        size_t large_bytes = 16 * 1024 * 1024;
+    };
+
+    // Times one load, 'end_io' and 'end_decode' close their phase, the
+    // rest until destruction counts as post-processing.
+    class ENGINE_API Scope {
+    public:
+        Scope(LoadTelemetry& telemetry, const std::string& kind, const std::string& path, bool async = false);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void end_io();
+        void end_decode();
+        void set_cache(CacheResult cache);
+        void set_file(const Filename& file);
+        void set_failed(bool failed);
+
+    private:
+        LoadTelemetry& _telemetry;
+        Record _record;
+        double _mark;
+    };
+
+    LoadTelemetry();
+
+    void set_enabled(bool enabled);
+    bool is_enabled() const;
+
+    void set_thresholds(const Thresholds& thresholds);
+    const Thresholds& get_thresholds() const;
+    bool is_slow(const Record& record) const;
+    bool is_large(const Record& record) const;
+
+    void add(const Record& record);
+    std::vector<Record> get_records() const;
+    void clear();
+
+    // Default file for the panel's export button
+    void set_export_filename(const std::string& filename);
+    bool write_json(const std::string& filename) const;
+
+    // Sortable table of all records, called between ImGui frames
+    void draw_panel(bool* open = nullptr);
+
+private:
+    std::atomic<bool> _enabled;
+    Thresholds _thresholds;
+    std::string _export_filename;
+
+    std::vector<Record> _records;
+    mutable std::mutex _mutex;
+};
+
+#endif // LOAD_TELEMETRY_H
@@ -5,6 +5,8 @@
 #include <vector>
 #include <string>
 
+#include <lpoint2.h>
+
 #include "exportMacros.hpp"
 
 class MouseWatcher;
@@ -25,6 +27,12 @@ public:
     
 	void center_mouse();
 	void toggle_force_relative_mode();
+
+	// Mouse of a view drawn inside the window, e.g. an ImGui panel. There is
+	// no mouse while the view is not hovered and get_mx/get_my are -1..1
+	// over the view instead of the window.
+	void set_view(bool hovered, const LPoint2& view_mouse);
+	void clear_view();
         
     void clear_modifier(int index);
     bool has_modifier(int modifier) const;
@@ -69,6 +77,10 @@ private:
 	float _horizontal_axis;
 
 	bool _force_relative_mode;
+
+	bool    _has_view;
+	bool    _view_hovered;
+	LPoint2 _view_mouse;
 	
     WPT(GraphicsWindow) _win;
     WPT(MouseWatcher)   _mouse_watcher;
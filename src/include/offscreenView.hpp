@@ -0,0 +1,84 @@
+#ifndef OFFSCREEN_VIEW_H
+#define OFFSCREEN_VIEW_H
+
+#include <string>
+#include <vector>
+
+#include <displayRegion.h>
+#include <graphicsOutput.h>
+#include <nodePath.h>
+#include <texture.h>
+
+#include "exportMacros.hpp"
+
+// Cameras rendered into a texture instead of the window, e.g. a viewport
+// shown as an ImGui panel. The buffer is the displayed size times the
+// render scale and renders at most 'refresh_rate' times a second, in
+// between and while hidden the texture keeps the last image and nothing
+// is rendered.
+class ENGINE_API OffscreenView {
+public:
+    OffscreenView(const std::string& name);
+    ~OffscreenView();
+
+    // Buffer sharing the host window's GSG, rendered before it (sort < 0)
+    bool create(GraphicsOutput* host, int sort = -10);
+    void destroy();
+    bool is_created() const;
+
+    // Display regions render in 'sort' order, the first usually clears
+    DisplayRegion* add_camera(NodePath camera, int sort = 0, bool clear = true, const LColor& clear_color = LColor(0, 0, 0, 1));
+
+    void set_render_scale(float scale);
+    float get_render_scale() const;
+    // 0 renders every frame
+    void set_refresh_rate(double refresh_rate);
+    double get_refresh_rate() const;
+    void set_visible(bool visible);
+    bool is_visible() const;
+
+    // Size the texture is shown at in pixels
+    void set_display_size(int width, int height);
+    LVecBase2i get_buffer_size() const;
+
+    // Called every frame before rendering, activates the buffer when due
+    void update();
+    bool is_rendering() const;
+
+    // ImGui window with the texture filling it, settings on right click.
+    // Returns false and stops rendering while closed or collapsed.
+    bool draw_panel(bool* open = nullptr);
+
+    Texture* get_texture() const;
+    const std::string& get_name() const;
+
+    // From the last draw_panel: whether the mouse is over the image, the
+    // mouse in -1..1 over it like MouseWatcher::get_mouse, and the image
+    // rect (left, right, bottom, top) in 0..1 of the ImGui display.
+    bool is_hovered() const;
+    LPoint2 get_mouse() const;
+    LVecBase4 get_image_rect() const;
+
+private:
+    void apply_size();
+
+    std::string _name;
+    PT(GraphicsOutput) _buffer;
+    PT(Texture) _texture;
+    std::vector<PT(DisplayRegion)> _regions;
+    std::vector<NodePath> _cameras;
+
+    float _render_scale;
+    double _refresh_rate;
+    double _last_render_time;
+    bool _visible;
+    bool _rendering;
+    LVecBase2i _display_size;
+    LVecBase2i _buffer_size;
+
+    bool _hovered;
+    LPoint2 _mouse;
+    LVecBase4 _image_rect;
+};
+
+#endif // OFFSCREEN_VIEW_H
@@ -0,0 +1,43 @@
+#ifndef PREFETCH_MANIFEST_H
+#define PREFETCH_MANIFEST_H
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "exportMacros.hpp"
+
+// Ordered list of the assets a game session loaded, saved per project so
+// the next session can load them in the background before scripts ask
+// for them, see ResourceManager::prefetch.
+class ENGINE_API PrefetchManifest {
+public:
+    PrefetchManifest();
+
+    void set_filename(const std::string& filename);
+    const std::string& get_filename() const;
+
+    // Only loads between begin and end are recorded, end saves the
+    // manifest if anything was recorded.
+    void begin_recording();
+    void end_recording();
+    bool is_recording() const;
+
+    // Each path is only recorded the first time it is loaded
+    void record(const std::string& path);
+
+    bool load();
+    bool save() const;
+
+    const std::vector<std::string>& get_paths() const;
+
+private:
+    std::string _filename;
+    bool _recording;
+
+    std::vector<std::string> _paths;
+    std::vector<std::string> _recorded;
+    std::unordered_set<std::string> _recorded_set;
+};
+
+#endif // PREFETCH_MANIFEST_H
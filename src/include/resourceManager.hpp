@@ -6,9 +6,21 @@
 #include <unordered_map>
 
 #include "exportMacros.hpp"
+#include "asyncLoad.hpp"
+#include "assetCache.hpp"
+#include "resourceRegistry.hpp"
+#include "textureStreamer.hpp"
+#include "prefetchManifest.hpp"
+#include "textureCooker.hpp"
+#include "fontCache.hpp"
+#include "soundManager.hpp"
+#include "loadTelemetry.hpp"
+
+class JobSystem;
 
 class NodePath;
 class Texture;
+class AsyncTaskChain;
 
 class ENGINE_API ResourceManager {
 public:
@@ -19,6 +31,50 @@ public:
 	NodePath load_model(
         const std::string& path,
         const LoaderOptions& loader_options);
+
+	// Async variants load on the resource loader threads and return right
+	// away, the callback is delivered on the main thread from update().
+	// Higher priority loads start first. A load can also be awaited from a
+	// coroutine with 'co_await wait_model(handle)'.
+	AsyncLoadHandle load_model_async(
+		const std::string& path,
+		AsyncLoadCallback callback = nullptr,
+		int priority = 0);
+
+	AsyncLoadHandle load_model_async(
+		const std::string& path,
+		const LoaderOptions& loader_options,
+		AsyncLoadCallback callback = nullptr,
+		int priority = 0);
+
+	AsyncLoadHandle load_texture_async(
+		const std::string& path,
+		AsyncLoadCallback callback = nullptr,
+		int priority = 0,
+		bool readMipmaps = false);
+
+	// Loads models and textures (picked by file extension) as one batch, the
+	// callback is called once after every load of the batch is ready or
+	// cancelled. It is not called when all of them were cancelled or after
+	// cancel_all_async.
+	std::vector<AsyncLoadHandle> load_batch_async(
+		const std::vector<std::string>& paths,
+		std::function<void(const std::vector<AsyncLoadHandle>&)> callback = nullptr,
+		int priority = 0);
+
+	// Loads the assets of the manifest in the background, in recorded
+	// order. Sync loads of an asset still being prefetched wait for it.
+	void prefetch();
+	size_t get_num_prefetching() const;
+	PrefetchManifest& get_prefetch_manifest();
+
+	void cancel_all_async();
+	void set_num_loader_threads(int num_threads);
+	int get_num_loader_threads() const;
+	size_t get_num_pending_async() const;
+
+	// Delivers completion callbacks, called once per frame by the engine
+	void update();
 	
 	PT(Texture) load_texture(const std::string& path, bool isCubeMap = false);
 	
@@ -38,13 +94,85 @@ public:
 		bool readMipmaps,
 		bool isCubeMap);
 
-    void load_font(const std::string& font);
-    void load_sound(const std::string& sound);
+	// Cube maps from a pattern where '#' is the face index 0-5, or from six
+	// paths in +x, -x, +y, -y, +z, -z order. The faces are decoded on the
+	// job system and the result is kept as '.txo' in the asset cache.
+	// 'prefilter' blurs each mip level more, for environment lighting.
+	PT(Texture) load_cube_map(const std::string& pattern, bool prefilter = false);
+	PT(Texture) load_cube_map(const std::vector<std::string>& faces, bool prefilter = false);
+
+	// Loads through the registry and takes a reference, the resource stays
+	// cached until it is released and evicted by the memory budget.
+	// Instance a model with 'get_registry().get_model(handle).copy_to(parent)'.
+	ResourceHandle acquire_model(const std::string& path);
+	ResourceHandle acquire_texture(const std::string& path);
+	void release(ResourceHandle& handle);
+
+    // Shared font with a persistent glyph atlas, see FontCache
+    PT(TextFont) load_font(const std::string& font, int pixel_size = 32, bool sdf = false);
+    FontCache& get_font_cache();
+
+    // Effects are decoded once and shared, 'stream' decodes music and
+    // ambience in chunks on the audio stream thread, see SoundManager.
+    PT(AudioSound) load_sound(const std::string& sound, bool stream = false);
+    SoundManager& get_sound_manager();
 
     PT(Loader) get_loader() const;
+    // Used for parallel work like decoding cube map faces, set by the Engine
+    void set_job_system(JobSystem* job_system);
+
+    // Binary conversion cache for text assets, disabled until a
+    // cache dir is set (see Demon::setup_paths).
+    AssetCache& get_asset_cache();
+    ResourceRegistry& get_registry();
+    TextureStreamer& get_texture_streamer();
+    // Timings of every load, see LoadTelemetry
+    LoadTelemetry& get_telemetry();
+
+    // When enabled, 2D textures from load_texture are streamed in by
+    // screen coverage instead of loaded at full resolution.
+    void set_texture_streaming(bool enabled);
+    bool get_texture_streaming() const;
+
+    // When enabled, images from load_texture and the textures of loaded
+    // models are cooked to '.txo' in the asset cache in the background and
+    // later loads read the '.txo'.
+    void set_texture_cooking(bool enabled, const TextureCooker::Options& options = TextureCooker::Options());
+    bool get_texture_cooking() const;
+    AssetCache::Stats get_cache_stats() const;
+
+    static bool is_texture_path(const std::string& path);
 
 private:
+    AsyncTaskChain* get_loader_chain();
+    void register_model(const std::string& engine_path, NodePath model);
+    // Thread safe, also used by loader threads
+    static void use_cooked_textures(
+        NodePath model,
+        AssetCache& asset_cache,
+        const TextureCooker::Options& cook_options,
+        const std::string& task_chain);
+    void record_load(const std::string& engine_path);
+    void wait_for_prefetch(const std::string& engine_path);
+    void add_async(const AsyncLoadHandle& load);
+
     PT(Loader) _loader;
+    JobSystem* _job_system;
+    AssetCache _asset_cache;
+    ResourceRegistry _registry;
+    FontCache _font_cache;
+    TextureStreamer _texture_streamer;
+    SoundManager _sound_manager;
+    LoadTelemetry _telemetry;
+    bool _texture_streaming;
+    PrefetchManifest _prefetch_manifest;
+    std::unordered_map<std::string, AsyncLoadHandle> _prefetching;
+    bool _issuing_prefetch;
+    bool _texture_cooking;
+    TextureCooker::Options _cook_options;
+    std::vector<AsyncLoadHandle> _pending_loads;
+    std::vector<AsyncLoadHandle> _finished_loads;
+    int _num_loader_threads;
 };
 
 #endif // RESOURCE_HANDLER_H
@@ -0,0 +1,142 @@
+#ifndef RESOURCE_REGISTRY_H
+#define RESOURCE_REGISTRY_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nodePath.h>
+#include <texture.h>
+#include <weakPointerTo.h>
+
+#include "exportMacros.hpp"
+
+// Stable reference to a registry entry, stays safe to use after the
+// entry is evicted (lookups then fail) and its slot is reused.
+struct ResourceHandle {
+    uint32_t index      = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool is_valid() const { return index != UINT32_MAX; }
+};
+
+// Tracks loaded models and textures by path with a reference count and
+// an estimate of the memory they use. Once the total goes over budget,
+// the least recently used entries nobody holds a reference to are
+// released from the model and texture pools and a "resource-evicted"
+// event is thrown.
+//
+// Only tracked entries, ones a reference was taken on at some point,
+// hold on to their resource, count against the budget and are evicted.
+// Untracked entries (plain loads) only watch the model or texture the
+// pools keep. They are found by lookups while it lives and expire when
+// pool garbage collection frees it, drop_expired removes them.
+class ENGINE_API ResourceRegistry {
+public:
+    enum Type {
+        MODEL,
+        TEXTURE,
+        ANIMATION,
+        NUM_TYPES,
+    };
+
+    using EvictCallback = std::function<void(Type type, const std::string& path)>;
+
+    ResourceRegistry();
+
+    // Registers a loaded resource, or finds the existing entry for the path.
+    // 'add_ref' is false for resources loaded without taking a reference,
+    // those are watched untracked until a reference is taken. Models are
+    // held as they are, register the pool's model rather than a copy.
+    ResourceHandle add_model(const std::string& path, NodePath model, bool add_ref = true);
+    ResourceHandle add_texture(const std::string& path, Texture* texture, bool add_ref = true);
+
+    ResourceHandle find(Type type, const std::string& path) const;
+    bool is_valid(const ResourceHandle& handle) const;
+
+    void add_ref(const ResourceHandle& handle);
+    // Drops a reference and resets the handle
+    void release(ResourceHandle& handle);
+    int get_ref_count(const ResourceHandle& handle) const;
+
+    // Marks the resource as used, which moves it to the back of the eviction order
+    void touch(const ResourceHandle& handle);
+
+    NodePath get_model(const ResourceHandle& handle);
+    PT(Texture) get_texture(const ResourceHandle& handle);
+    const std::string& get_path(const ResourceHandle& handle) const;
+
+    // 0 means no budget
+    void set_budget(size_t bytes);
+    size_t get_budget() const;
+    // Tracked entries only, what the budget applies to
+    size_t get_bytes(Type type) const;
+    size_t get_total_bytes() const;
+    size_t get_untracked_bytes(Type type) const;
+    size_t get_num_resources() const;
+
+    // Evicts unreferenced resources until the total is within budget,
+    // returns the number of bytes freed
+    size_t evict_to_budget();
+    size_t evict_unreferenced();
+    void set_evict_callback(EvictCallback callback);
+
+    // Removes untracked entries whose resource was freed, returns how many
+    size_t drop_expired();
+
+    void clear();
+
+    // Memory estimates, shared vertex data and textures are counted once
+    static size_t estimate_geometry_bytes(NodePath model);
+    static size_t estimate_animation_bytes(NodePath model);
+    static size_t estimate_texture_bytes(Texture* texture);
+
+private:
+    struct Entry {
+        Type type;
+        std::string path;
+        uint32_t generation;
+        int ref_count;
+        uint64_t last_used;
+        bool alive;
+        bool tracked;
+
+        // Set while tracked, the weak pointers always
+        PT(PandaNode) model;
+        PT(Texture) texture;
+        WPT(PandaNode) weak_model;
+        WPT(Texture) weak_texture;
+        size_t bytes[NUM_TYPES];
+
+        // Textures used by a model, kept alive as long as the model is
+        std::vector<ResourceHandle> dependencies;
+    };
+
+    Entry* get_entry(const ResourceHandle& handle);
+    const Entry* get_entry(const ResourceHandle& handle) const;
+    ResourceHandle allocate(Type type, const std::string& path);
+    bool is_expired(const Entry& entry) const;
+    void drop(uint32_t index);
+    void track(Entry& entry);
+    void take_ref(Entry& entry);
+    void add_bytes(const Entry& entry);
+    size_t evict(uint32_t index);
+    size_t evict_until(size_t target_bytes);
+
+    std::vector<Entry> _entries;
+    std::vector<uint32_t> _free_entries;
+    std::unordered_map<std::string, uint32_t> _lookup[NUM_TYPES];
+
+    size_t _bytes[NUM_TYPES];
+    size_t _untracked_bytes[NUM_TYPES];
+    size_t _budget;
+
+    // Tracked entries with no references, nothing to scan for without any
+    size_t _num_evictable;
+    uint64_t _use_counter;
+    EvictCallback _evict_callback;
+};
+
+#endif // RESOURCE_REGISTRY_H
@@ -31,6 +31,8 @@ protected:
     Demon& demon;
     Game& game;
     ResourceManager& resource_manager;
+    JobSystem& job_system;
+    DebugDraw& debug_draw;
     
     float dt;
     std::unordered_map<std::string, bool> input_map;
@@ -50,10 +52,23 @@ protected:
     }
 
     void register_button_map(std::unordered_map<std::string, std::pair<std::string, bool>>& map);
+
+    // Keeps track of a coroutine started by this script, so it is cancelled
+    // when the script stops, e.g. start_coroutine(spawn_wave(10));
+    void start_coroutine(CoTask task);
+
+    // Engine timers owned by this script, pending ones are cancelled when
+    // the script stops. Cost is O(1) per timer, so thousands are fine.
+    TimerHandle after_frames(int num_frames, std::function<void()> callback);
+    TimerHandle after_seconds(double seconds, std::function<void()> callback);
+    void cancel_timer(TimerHandle& handle);
     
     virtual void on_update(const PT(AsyncTask)&);
     virtual void on_event(const std::string& event_name);
+    // Editor UI, drawn over the whole window
     virtual void render_imgui();
+    // In-game UI, drawn in the game view
+    virtual void render_game_imgui();
     
     float get_dt();
 
@@ -61,6 +76,11 @@ private:
     std::string script_name;
     std::string task_name;
     PT(AsyncTask) update_task;
+    std::vector<CoTask> coroutines;
+    std::vector<TimerHandle> timers;
+    size_t timers_prune_size = 64;
+
+    TimerHandle track_timer(TimerHandle handle);
     std::unordered_map<std::string, std::pair<std::string, bool>> buttons_map_;
 };
 
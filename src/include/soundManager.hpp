@@ -0,0 +1,132 @@
+#ifndef SOUND_MANAGER_H
+#define SOUND_MANAGER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <audioManager.h>
+#include <audioSound.h>
+#include <asyncTask.h>
+#include <nodePath.h>
+
+#include "exportMacros.hpp"
+
+// Refers to a voice started with SoundManager::play, stays safe to
+// use after the voice ends.
+struct SoundHandle {
+    uint32_t index      = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool is_valid() const { return index != UINT32_MAX; }
+};
+
+// Sound loading and playback on top of Panda's AudioManager.
+//
+// Effects are fully decoded once and every voice playing the same file
+// shares the decoded data, finished voices go back to a per file pool.
+// Music and ambience are streamed, decoded in chunks by the music
+// manager's update, which runs on its own "AudioStream" thread.
+//
+// At most 'max_voices' voices are audible, the rest are virtual: they
+// keep their place in time but are stopped until they win a slot back,
+// decided by priority and then by how loud they would be.
+// Without a sound device Panda hands out a null manager and everything
+// still works, only silently. Null sounds have no length and never play,
+// so their voices end 'null_sound_length' seconds after they start.
+class ENGINE_API SoundManager {
+public:
+    enum Category {
+        EFFECT,
+        MUSIC,
+    };
+
+    SoundManager();
+    ~SoundManager();
+
+    // Creates the audio managers, called on first use. 'null_audio'
+    // uses the null manager whatever the device, e.g. for checks.
+    void initialize(bool null_audio = false);
+    void shutdown();
+    bool is_null() const;
+
+    // Loaded sound to play directly, streamed sounds come from the music
+    // manager. nullptr when the file could not be loaded.
+    PT(AudioSound) load(const std::string& path, bool stream = false);
+
+    // 'emitter' is optional, positioned voices get quieter with
+    // distance from the listener and are virtualised when inaudible.
+    SoundHandle play(
+        const std::string& path,
+        Category category = EFFECT,
+        int priority = 0,
+        float volume = 1.0f,
+        bool loop = false,
+        NodePath emitter = NodePath());
+
+    void stop(SoundHandle& handle);
+    void stop_all();
+    bool is_playing(const SoundHandle& handle) const;
+    bool is_virtual(const SoundHandle& handle) const;
+    void set_volume(const SoundHandle& handle, float volume);
+
+    void set_listener(NodePath listener);
+    void set_max_voices(int max_voices);
+    void set_category_volume(Category category, float volume);
+    // Distances the attenuation of positioned voices is computed over
+    void set_distance_range(float min_distance, float max_distance);
+    void set_null_sound_length(double seconds);
+
+    // Called once per frame on the main thread
+    void update();
+
+    int get_max_voices() const;
+    int get_num_voices() const;
+    int get_num_virtual() const;
+
+private:
+    struct Voice {
+        std::string path;
+        Category category;
+        PT(AudioSound) sound;
+        NodePath emitter;
+        int priority;
+        float volume;
+        float audibility;
+        bool loop;
+        bool active;
+        bool is_virtual;
+        // playback position is derived from it, also while virtual
+        double start_time;
+        uint32_t generation;
+    };
+
+    Voice* get_voice(const SoundHandle& handle);
+    const Voice* get_voice(const SoundHandle& handle) const;
+    PT(AudioSound) acquire_sound(const std::string& path, Category category);
+    PT(AudioSound) get_sound(const std::string& path, Category category);
+    void release_voice(Voice& voice);
+    void make_real(Voice& voice, double now);
+    void make_virtual(Voice& voice);
+    float compute_audibility(const Voice& voice) const;
+
+    PT(AudioManager) _effects_manager;
+    PT(AudioManager) _music_manager;
+    PT(AsyncTask) _stream_task;
+    bool _initialized;
+
+    std::vector<Voice> _voices;
+    std::vector<uint32_t> _free_voices;
+    std::unordered_map<std::string, std::vector<PT(AudioSound)>> _effect_pool;
+
+    NodePath _listener;
+    int _max_voices;
+    float _category_volume[2];
+    float _min_distance;
+    float _max_distance;
+    double _null_sound_length;
+    int _num_virtual;
+};
+
+#endif // SOUND_MANAGER_H
@@ -5,6 +5,9 @@
 #include <asyncTaskManager.h>
 #include <memory>
 
+// C++20 coroutines driven by the engine loop (next_frame, wait_seconds, etc.)
+#include "coTask.hpp"
+
 // Helper function to create an inline task
 template<class Callable>
 AsyncTask* make_task(Callable callable, const std::string& name, int sort = 0, int priority = 0) {
@@ -0,0 +1,51 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include <string>
+#include <vector>
+
+#include <filename.h>
+#include <texture.h>
+
+#include "exportMacros.hpp"
+
+class JobSystem;
+
+// Offline texture processing: decodes an image once, builds a filtered
+// mip chain, optionally block compresses it on the CPU and writes the
+// result as a '.txo' that loads without any decoding. Used by the asset
+// cache in ResourceManager and by the texture_cooker tool.
+class ENGINE_API TextureCooker {
+public:
+    struct Options {
+        bool generate_mipmaps = true;
+        // DXT1 for opaque, DXT5 for images with alpha
+        bool compress = false;
+        // Largest side of the top level, 0 keeps the source size
+        int max_size = 0;
+        // Radius of the gaussian filter used for each mip level
+        float filter_radius = 1.0f;
+        // Cube maps only, each mip level is blurred more than the last so
+        // lower levels can stand in for rougher reflections. The blur is
+        // over directions and reads across the cube edges.
+        bool prefilter = false;
+    };
+
+    static PT(Texture) cook(const Filename& source, const Options& options);
+    static bool cook(const Filename& source, const Filename& output, const Options& options);
+
+    // Six square faces in +x, -x, +y, -y, +z, -z order, the faces are
+    // decoded and filtered in parallel when a job system is given.
+    static PT(Texture) cook_cube_map(const std::vector<Filename>& faces, const Options& options, JobSystem* job_system = nullptr);
+
+    // Face paths of a cube map pattern, '#' is replaced by 0 to 5
+    static std::vector<std::string> get_cube_map_faces(const std::string& pattern);
+
+    // Image formats worth cooking
+    static bool is_cookable(const std::string& path);
+
+    // Cache file extension for a set of options, e.g. '.dxt.txo'
+    static std::string get_cache_extension(const Options& options);
+};
+
+#endif // TEXTURE_COOKER_H
@@ -0,0 +1,117 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nodePath.h>
+#include <pnmImage.h>
+#include <texture.h>
+
+#include "exportMacros.hpp"
+
+// Streams textures in by resolution. A streamed texture is loaded at a
+// small base size first, higher resolutions are decoded on the resource
+// loader threads once the texture covers enough of the screen and are
+// dropped back to the base size when it goes out of view or the global
+// budget is exceeded. The Texture object stays the same the whole time,
+// only its ram image is swapped.
+class ENGINE_API TextureStreamer {
+public:
+    TextureStreamer();
+
+    // Returns the streamed texture for 'path', loaded at the base size
+    PT(Texture) load(const std::string& path);
+    bool is_streamed(const Texture* texture) const;
+
+    // Camera the screen coverage is estimated for, and the scene
+    // searched for the nodes that use streamed textures.
+    void set_camera(NodePath camera, NodePath scene_root);
+
+    // Users are found without rescanning the scene: models attached to the
+    // scene root are searched once when they appear, users leave when they
+    // are removed from the scene. Streamed textures set on a subtree deeper
+    // in the scene after it was searched need add_users.
+    void add_users(NodePath root);
+
+    // Called once per frame on the main thread
+    void update(const std::string& task_chain);
+    void clear();
+
+    // Largest side of the image loaded up front
+    void set_base_size(int size);
+    // Limits the resolution of a single texture, 0 means no limit
+    void set_max_size(int size);
+    void set_max_size(const std::string& path, int size);
+    // Total bytes of all streamed images, 0 means no limit
+    void set_budget(size_t bytes);
+    // Screen coverage is estimated every this many frames
+    void set_update_interval(int num_frames);
+
+    size_t get_budget() const;
+    size_t get_resident_bytes() const;
+    size_t get_num_textures() const;
+    size_t get_num_pending() const;
+
+private:
+    struct Request {
+        int level;
+        PT(Texture) staged;
+        std::atomic<bool> done{ false };
+    };
+
+    struct Entry {
+        Filename fullpath;
+        PT(Texture) texture;
+        int full_x_size;
+        int full_y_size;
+        int num_components;
+
+        int base_level;
+        int resident_level;
+        int desired_level;
+        int max_size;
+
+        // image at the base level, put back when higher levels are dropped
+        CPTA_uchar base_image;
+        int base_x_size;
+        int base_y_size;
+        Texture::Format base_format;
+        Texture::ComponentType base_component_type;
+
+        std::vector<NodePath> users;
+        float screen_size;
+        std::shared_ptr<Request> request;
+    };
+
+    int get_level_for_size(const Entry& entry, int size) const;
+    size_t get_level_bytes(const Entry& entry, int level) const;
+    void find_users();
+    void update_users();
+    void estimate_screen_sizes();
+    void fit_to_budget();
+    void request_level(Entry& entry, int level, const std::string& task_chain);
+    void apply_request(Entry& entry);
+    void restore_base(Entry& entry);
+
+    std::unordered_map<std::string, Entry> _entries;
+    NodePath _camera;
+    NodePath _scene_root;
+    // Children of the scene root already searched for users
+    std::vector<PT(PandaNode)> _searched_children;
+    bool _search_scene;
+
+    int _base_size;
+    int _max_size;
+    size_t _budget;
+    size_t _resident_bytes;
+    int _update_interval;
+    int _frame;
+    int _max_in_flight;
+    int _num_in_flight;
+};
+
+#endif // TEXTURE_STREAMER_H
@@ -0,0 +1,116 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "exportMacros.hpp"
+
+// Handle to a scheduled timer, stays safe to use after the timer fired
+// or was cancelled (the generation won't match anymore).
+struct TimerHandle {
+    uint32_t index      = 0;
+    uint32_t generation = 0;
+    uint8_t  wheel      = 0;
+
+    bool is_valid() const { return generation != 0; }
+};
+
+// Hierarchical timer wheel, schedule, cancel and fire are O(1) per timer.
+// The unit of a tick is up to the owner (frames, milliseconds ...), timers
+// that are due on the same tick fire in the order they were scheduled.
+class ENGINE_API TimerWheel {
+public:
+    TimerWheel();
+
+    // Schedules callback to fire after 'delay' ticks, a delay < 1 fires on the next tick.
+    TimerHandle schedule(uint64_t delay, std::function<void()> callback);
+    bool cancel(const TimerHandle& handle);
+    bool is_pending(const TimerHandle& handle) const;
+
+    // Advances the wheel, firing all timers that become due.
+    void advance(uint64_t ticks);
+    void clear();
+
+    uint64_t get_current_tick() const;
+    size_t get_num_pending() const;
+
+private:
+    static constexpr int NUM_LEVELS   = 4;
+    static constexpr int LEVEL0_BITS  = 8;
+    static constexpr int LEVELN_BITS  = 6;
+    static constexpr int LEVEL0_SLOTS = 1 << LEVEL0_BITS;
+    static constexpr int LEVELN_SLOTS = 1 << LEVELN_BITS;
+    static constexpr int NUM_SLOTS    = LEVEL0_SLOTS + (NUM_LEVELS - 1) * LEVELN_SLOTS;
+    static constexpr uint64_t MAX_DELAY = (uint64_t(1) << (LEVEL0_BITS + (NUM_LEVELS - 1) * LEVELN_BITS)) - 1;
+    static constexpr int32_t NONE = -1;
+
+    struct Node {
+        std::function<void()> callback;
+        uint64_t due_tick   = 0;
+        uint64_t sequence   = 0;
+        uint32_t generation = 1;
+        int32_t  prev       = NONE;
+        int32_t  next       = NONE;
+        int32_t  slot       = NONE;
+    };
+
+    struct Slot {
+        int32_t head = NONE;
+        int32_t tail = NONE;
+    };
+
+    int32_t allocate_node();
+    void free_node(int32_t index);
+    void insert(int32_t index);
+    void link(int32_t slot, int32_t index);
+    void unlink(int32_t index);
+    void cascade(int level);
+    void tick();
+
+    std::vector<Node> _nodes;
+    std::vector<int32_t> _free_nodes;
+    Slot _slots[NUM_SLOTS];
+
+    uint64_t _current_tick;
+    uint64_t _next_sequence;
+    size_t   _num_pending;
+
+    // scratch buffer for timers firing on the current tick
+    std::vector<std::pair<int32_t, uint32_t>> _firing;
+};
+
+// Engine timer service, one wheel counts frames and one counts milliseconds
+// of frame time. Frame timers of a frame fire before time based timers.
+class ENGINE_API TimerService {
+public:
+    TimerService();
+
+    TimerHandle after_frames(int num_frames, std::function<void()> callback);
+    TimerHandle after_seconds(double seconds, std::function<void()> callback);
+
+    bool cancel(TimerHandle& handle);
+    bool is_pending(const TimerHandle& handle) const;
+
+    // Called once per frame with the current frame time.
+    void update(double frame_time);
+    void clear();
+
+    size_t get_num_pending() const;
+
+private:
+    enum WheelType : uint8_t {
+        FRAME_WHEEL = 0,
+        TIME_WHEEL  = 1,
+    };
+
+    TimerWheel _frame_wheel;
+    TimerWheel _time_wheel;
+
+    uint64_t _last_ms;
+    bool     _started;
+};
+
+#endif // TIMER_WHEEL_H
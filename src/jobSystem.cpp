@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <iostream>
+
+#include "jobSystem.hpp"
+
+namespace {
+    // index of the calling thread's queue, -1 for threads that are not workers
+    thread_local int tls_worker_index = -1;
+    thread_local const JobSystem* tls_job_system = nullptr;
+}
+
+JobSystem::JobSystem() : _running(false), _num_pending(0) {}
+
+JobSystem::~JobSystem() {
+    stop();
+}
+
+void JobSystem::start(int num_workers) {
+    if (_running)
+        return;
+
+    if (num_workers < 0) {
+        int hw_threads = static_cast<int>(std::thread::hardware_concurrency());
+        num_workers = std::max(hw_threads - 1, 1);
+    }
+
+    _queues.clear();
+    for (int i = 0; i < num_workers + 1; ++i) {
+        _queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    _running = true;
+    for (int i = 0; i < num_workers; ++i) {
+        _threads.emplace_back(&JobSystem::worker_loop, this, i);
+    }
+
+    std::cout << "JobSystem started with " << num_workers << " workers." << std::endl;
+}
+
+void JobSystem::stop() {
+    if (!_running)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _running = false;
+    }
+    _sleep_cv.notify_all();
+
+    for (std::thread& thread : _threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+    _threads.clear();
+
+    // Run whatever is left so that no counter is left waiting forever
+    Job job;
+    for (int i = 0; i < static_cast<int>(_queues.size()); ++i) {
+        while (try_get_job(i, job)) {
+            execute(job);
+        }
+    }
+    _queues.clear();
+}
+
+bool JobSystem::is_running() const {
+    return _running;
+}
+
+int JobSystem::get_num_workers() const {
+    return static_cast<int>(_threads.size());
+}
+
+void JobSystem::run(std::function<void()> fn, JobCounter* counter) {
+    if (counter)
+        counter->_value.fetch_add(1, std::memory_order_relaxed);
+
+    submit(Job{ std::move(fn), counter });
+}
+
+void JobSystem::run_after(JobCounter& dependency, std::function<void()> fn, JobCounter* counter) {
+    if (counter)
+        counter->_value.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(dependency._mutex);
+        if (!dependency.is_done()) {
+            dependency._continuations.push_back(Job{ std::move(fn), counter });
+            return;
+        }
+    }
+
+    submit(Job{ std::move(fn), counter });
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    int own_index = (tls_job_system == this) ? tls_worker_index : -1;
+
+    Job job;
+    while (!counter.is_done()) {
+        bool found = false;
+
+        if (_running) {
+            // own queue first, then the shared queue, then steal
+            if (own_index >= 0)
+                found = try_get_job(own_index, job);
+
+            for (int i = 0; !found && i < static_cast<int>(_queues.size()); ++i) {
+                if (i != own_index)
+                    found = try_get_job(i, job);
+            }
+        }
+
+        if (found)
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::parallel_for(
+    size_t begin,
+    size_t end,
+    const std::function<void(size_t, size_t)>& fn,
+    size_t grain) {
+
+    if (end <= begin)
+        return;
+
+    size_t count = end - begin;
+    size_t num_threads = static_cast<size_t>(get_num_workers()) + 1;
+
+    if (grain == 0)
+        grain = std::max<size_t>(count / (num_threads * 4), 1);
+
+    // Nothing to gain from splitting, run inline
+    if (!_running || count <= grain) {
+        fn(begin, end);
+        return;
+    }
+
+    JobCounter counter;
+    for (size_t range_begin = begin; range_begin < end; range_begin += grain) {
+        size_t range_end = std::min(range_begin + grain, end);
+        run([&fn, range_begin, range_end]() { fn(range_begin, range_end); }, &counter);
+    }
+
+    wait(counter);
+}
+
+void JobSystem::submit(Job&& job) {
+    if (!_running) {
+        execute(job);
+        return;
+    }
+
+    int queue_index = (tls_job_system == this) ? tls_worker_index : -1;
+    if (queue_index < 0)
+        queue_index = static_cast<int>(_queues.size()) - 1;
+
+    {
+        std::lock_guard<std::mutex> lock(_queues[queue_index]->mutex);
+        _queues[queue_index]->jobs.push_back(std::move(job));
+    }
+
+    // Counted under the sleep mutex, a worker checking it before it
+    // waits can't miss the notification
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _num_pending.fetch_add(1, std::memory_order_release);
+    }
+    _sleep_cv.notify_one();
+}
+
+void JobSystem::execute(Job& job) {
+    if (job.fn)
+        job.fn();
+    finish(job.counter);
+    job = Job();
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    if (counter == nullptr)
+        return;
+
+    if (counter->_value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    // Counter reached zero, release the jobs that depend on it
+    std::vector<Job> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->_mutex);
+        continuations.swap(counter->_continuations);
+    }
+
+    for (Job& continuation : continuations) {
+        submit(std::move(continuation));
+    }
+}
+
+bool JobSystem::try_get_job(int queue_index, Job& job) {
+    WorkerQueue& queue = *_queues[queue_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.jobs.empty())
+        return false;
+
+    // Owners take the newest job (cache warm), everyone else steals the oldest
+    bool is_owner = (tls_job_system == this && tls_worker_index == queue_index);
+    if (is_owner) {
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+    } else {
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+    }
+
+    _num_pending.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void JobSystem::worker_loop(int worker_index) {
+    tls_worker_index = worker_index;
+    tls_job_system = this;
+
+    int num_queues = static_cast<int>(_queues.size());
+    Job job;
+
+    while (_running) {
+        bool found = try_get_job(worker_index, job);
+
+        // steal, starting from the next queue so victims are spread evenly
+        for (int i = 1; !found && i < num_queues; ++i) {
+            found = try_get_job((worker_index + i) % num_queues, job);
+        }
+
+        if (found) {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleep_mutex);
+        _sleep_cv.wait(lock, [this]() {
+            return !_running || _num_pending.load(std::memory_order_acquire) > 0;
+        });
+    }
+
+    tls_worker_index = -1;
+    tls_job_system = nullptr;
+}
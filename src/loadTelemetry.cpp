@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include <config_putil.h>
+#include <thread.h>
+#include <trueClock.h>
+#include <virtualFileSystem.h>
+
+#include "imgui.h"
+#include "loadTelemetry.hpp"
+
+namespace {
+    // Oldest records are dropped past this
+    const size_t MAX_RECORDS = 10000;
+
+    double get_time() {
+        return TrueClock::get_global_ptr()->get_short_time();
+    }
+
+    const char* get_cache_name(LoadTelemetry::CacheResult cache) {
+        switch (cache) {
+        case LoadTelemetry::CACHE_HIT:  return "hit";
+        case LoadTelemetry::CACHE_MISS: return "miss";
+        default:                        return "none";
+        }
+    }
+
+    std::string escape_json(const std::string& text) {
+        std::string result;
+        for (char c : text) {
+            switch (c) {
+            case '"':  result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n";  break;
+            case '\t': result += "\\t";  break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    result += buffer;
+                } else {
+                    result += c;
+                }
+            }
+        }
+        return result;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// LoadTelemetry::Scope
+
+LoadTelemetry::Scope::Scope(LoadTelemetry& telemetry, const std::string& kind, const std::string& path, bool async) :
+    _telemetry(telemetry),
+    _mark(get_time()) {
+
+    _record.path = path;
+    _record.kind = kind;
+    _record.async = async;
+}
+
+LoadTelemetry::Scope::~Scope() {
+    if (!_telemetry.is_enabled())
+        return;
+
+    _record.post_time = get_time() - _mark;
+    _record.thread = Thread::get_current_thread()->get_name();
+    _telemetry.add(_record);
+}
+
+void LoadTelemetry::Scope::end_io() {
+    double now = get_time();
+    _record.io_time += now - _mark;
+    _mark = now;
+}
+
+void LoadTelemetry::Scope::end_decode() {
+    double now = get_time();
+    _record.decode_time += now - _mark;
+    _mark = now;
+}
+
+void LoadTelemetry::Scope::set_cache(CacheResult cache) {
+    _record.cache = cache;
+}
+
+void LoadTelemetry::Scope::set_file(const Filename& file) {
+    VirtualFileSystem* vfs = VirtualFileSystem::get_global_ptr();
+    Filename resolved = file;
+    if (!vfs->resolve_filename(resolved, get_model_path()))
+        return;
+
+    PT(VirtualFile) virtual_file = vfs->get_file(resolved);
+    if (virtual_file != nullptr)
+        _record.bytes = static_cast<size_t>(virtual_file->get_file_size());
+}
+
+void LoadTelemetry::Scope::set_failed(bool failed) {
+    _record.failed = failed;
+}
+
+// ---------------------------------------------------------------------------
+// LoadTelemetry
+
+LoadTelemetry::LoadTelemetry() : _enabled(true) {}
+
+void LoadTelemetry::set_enabled(bool enabled) {
+    _enabled = enabled;
+}
+
+bool LoadTelemetry::is_enabled() const {
+    return _enabled;
+}
+
+void LoadTelemetry::set_thresholds(const Thresholds& thresholds) {
+    _thresholds = thresholds;
+}
+
+const LoadTelemetry::Thresholds& LoadTelemetry::get_thresholds() const {
+    return _thresholds;
+}
+
+bool LoadTelemetry::is_slow(const Record& record) const {
+    return record.get_total_time() * 1000.0 > _thresholds.slow_ms;
+}
+
+bool LoadTelemetry::is_large(const Record& record) const {
+    return record.bytes > _thresholds.large_bytes;
+}
+
+void LoadTelemetry::add(const Record& record) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_records.size() >= MAX_RECORDS)
+        _records.erase(_records.begin(), _records.begin() + MAX_RECORDS / 10);
+    _records.push_back(record);
+}
+
+std::vector<LoadTelemetry::Record> LoadTelemetry::get_records() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _records;
+}
+
+void LoadTelemetry::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _records.clear();
+}
+
+void LoadTelemetry::set_export_filename(const std::string& filename) {
+    _export_filename = filename;
+}
+
+bool LoadTelemetry::write_json(const std::string& filename) const {
+    if (filename.empty())
+        return false;
+
+    Filename(Filename::from_os_specific(filename)).make_dir();
+
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "LoadTelemetry: could not write " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<Record> records = get_records();
+
+    file << "{\n";
+    file << "  \"thresholds\": { \"slow_ms\": " << _thresholds.slow_ms
+         << ", \"large_bytes\": " << _thresholds.large_bytes << " },\n";
+    file << "  \"loads\": [\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        const Record& record = records[i];
+        file << "    { \"path\": \"" << escape_json(record.path) << "\""
+             << ", \"kind\": \"" << escape_json(record.kind) << "\""
+             << ", \"thread\": \"" << escape_json(record.thread) << "\""
+             << ", \"async\": " << (record.async ? "true" : "false")
+             << ", \"failed\": " << (record.failed ? "true" : "false")
+             << ", \"total_ms\": " << record.get_total_time() * 1000.0
+             << ", \"io_ms\": " << record.io_time * 1000.0
+             << ", \"decode_ms\": " << record.decode_time * 1000.0
+             << ", \"post_ms\": " << record.post_time * 1000.0
+             << ", \"bytes\": " << record.bytes
+             << ", \"cache\": \"" << get_cache_name(record.cache) << "\""
+             << ", \"slow\": " << (is_slow(record) ? "true" : "false")
+             << ", \"large\": " << (is_large(record) ? "true" : "false")
+             << " }" << (i + 1 < records.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+
+    return file.good();
+}
+
+void LoadTelemetry::draw_panel(bool* open) {
+    if (!ImGui::Begin("Load Telemetry", open)) {
+        ImGui::End();
+        return;
+    }
+
+    std::vector<Record> records = get_records();
+
+    double total_time = 0.0;
+    size_t total_bytes = 0;
+    int num_flagged = 0;
+    for (const Record& record : records) {
+        total_time += record.get_total_time();
+        total_bytes += record.bytes;
+        if (is_slow(record) || is_large(record))
+            ++num_flagged;
+    }
+
+    ImGui::Text("%d loads, %.1f ms, %.2f MB, %d flagged",
+        (int)records.size(), total_time * 1000.0, total_bytes / (1024.0 * 1024.0), num_flagged);
+
+    float slow_ms = static_cast<float>(_thresholds.slow_ms);
+    ImGui::SetNextItemWidth(120.0f);
+    if (ImGui::DragFloat("Slow ms", &slow_ms, 1.0f, 0.0f, 10000.0f, "%.0f"))
+        _thresholds.slow_ms = slow_ms;
+
+    ImGui::SameLine();
+    float large_mb = static_cast<float>(_thresholds.large_bytes / (1024.0 * 1024.0));
+    ImGui::SetNextItemWidth(120.0f);
+    if (ImGui::DragFloat("Large MB", &large_mb, 0.5f, 0.0f, 4096.0f, "%.1f"))
+        _thresholds.large_bytes = static_cast<size_t>(large_mb * 1024.0 * 1024.0);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Export JSON") && write_json(_export_filename))
+        std::cout << "Load telemetry written to " << _export_filename << std::endl;
+
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+        clear();
+
+    enum Column { PATH, KIND, TOTAL, IO, DECODE, POST, BYTES, CACHE, THREAD };
+
+    ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_Resizable |
+        ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersOuter;
+
+    if (ImGui::BeginTable("loads", 9, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Path", ImGuiTableColumnFlags_WidthStretch, 0.0f, PATH);
+        ImGui::TableSetupColumn("Kind", 0, 0.0f, KIND);
+        ImGui::TableSetupColumn("Total ms", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending, 0.0f, TOTAL);
+        ImGui::TableSetupColumn("I/O ms", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, IO);
+        ImGui::TableSetupColumn("Decode ms", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, DECODE);
+        ImGui::TableSetupColumn("Post ms", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, POST);
+        ImGui::TableSetupColumn("Bytes", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, BYTES);
+        ImGui::TableSetupColumn("Cache", 0, 0.0f, CACHE);
+        ImGui::TableSetupColumn("Thread", 0, 0.0f, THREAD);
+        ImGui::TableHeadersRow();
+
+        // Sorted every frame, the records are copied anyway
+        if (ImGuiTableSortSpecs* sort_specs = ImGui::TableGetSortSpecs()) {
+            if (sort_specs->SpecsCount > 0) {
+                const ImGuiTableColumnSortSpecs& spec = sort_specs->Specs[0];
+                bool ascending = spec.SortDirection == ImGuiSortDirection_Ascending;
+
+                std::stable_sort(records.begin(), records.end(), [&](const Record& a, const Record& b) {
+                    int order = 0;
+                    switch (spec.ColumnUserID) {
+                    case PATH:   order = a.path.compare(b.path); break;
+                    case KIND:   order = a.kind.compare(b.kind); break;
+                    case TOTAL:  order = (a.get_total_time() < b.get_total_time()) ? -1 : (a.get_total_time() > b.get_total_time()); break;
+                    case IO:     order = (a.io_time < b.io_time) ? -1 : (a.io_time > b.io_time); break;
+                    case DECODE: order = (a.decode_time < b.decode_time) ? -1 : (a.decode_time > b.decode_time); break;
+                    case POST:   order = (a.post_time < b.post_time) ? -1 : (a.post_time > b.post_time); break;
+                    case BYTES:  order = (a.bytes < b.bytes) ? -1 : (a.bytes > b.bytes); break;
+                    case CACHE:  order = (int)a.cache - (int)b.cache; break;
+                    case THREAD: order = a.thread.compare(b.thread); break;
+                    }
+                    return ascending ? order < 0 : order > 0;
+                });
+            }
+        }
+
+        const ImVec4 flagged_color(1.0f, 0.45f, 0.35f, 1.0f);
+
+        ImGuiListClipper clipper;
+        clipper.Begin((int)records.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                const Record& record = records[i];
+                bool slow = is_slow(record);
+                bool large = is_large(record);
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if (record.failed)
+                    ImGui::TextColored(flagged_color, "%s (failed)", record.path.c_str());
+                else
+                    ImGui::TextUnformatted(record.path.c_str());
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%s%s", record.kind.c_str(), record.async ? " (async)" : "");
+
+                ImGui::TableNextColumn();
+                if (slow)
+                    ImGui::TextColored(flagged_color, "%.2f", record.get_total_time() * 1000.0);
+                else
+                    ImGui::Text("%.2f", record.get_total_time() * 1000.0);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", record.io_time * 1000.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", record.decode_time * 1000.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", record.post_time * 1000.0);
+
+                ImGui::TableNextColumn();
+                if (large)
+                    ImGui::TextColored(flagged_color, "%zu", record.bytes);
+                else
+                    ImGui::Text("%zu", record.bytes);
+
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(get_cache_name(record.cache));
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(record.thread.c_str());
+            }
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
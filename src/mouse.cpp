@@ -21,7 +21,9 @@ Mouse::Mouse() :
     _dx(0), _dy(0),
     _zoom(0),
     _vertical_axis(0), _horizontal_axis(0),
-    _force_relative_mode(false) {}
+    _force_relative_mode(false),
+    _has_view(false), _view_hovered(false),
+    _view_mouse(0, 0) {}
 
 void Mouse::initialize(WPT(GraphicsWindow) win, WPT(MouseWatcher) mw) {
     _win = win;
@@ -36,7 +38,7 @@ void Mouse::initialize(WPT(GraphicsWindow) win, WPT(MouseWatcher) mw) {
 }
 
 void Mouse::update() {
-    if (!_mouse_watcher->has_mouse())
+    if (!has_mouse())
         return;
 
     for (auto& btn : _mouse_buttons) {
@@ -50,9 +52,9 @@ void Mouse::update() {
     _dx = pointer_data.get_x() - _x;
     _dy = pointer_data.get_y() - _y;
 
-    // Normalized coords from watcher
-    _mx = _mouse_watcher->get_mouse_x();
-    _my = _mouse_watcher->get_mouse_y();
+    // Normalized coords from watcher, or over the view
+    _mx = _has_view ? _view_mouse[0] : _mouse_watcher->get_mouse_x();
+    _my = _has_view ? _view_mouse[1] : _mouse_watcher->get_mouse_y();
 
     if (_force_relative_mode) { 
         _horizontal_axis = (_mx > 0) ? 1 : (_mx < 0) ? -1 : 0;
@@ -82,8 +84,18 @@ void Mouse::toggle_force_relative_mode() {
     std::cout << "Toggle force mouse relative mode: " << _force_relative_mode << std::endl;
 }
 
+void Mouse::set_view(bool hovered, const LPoint2& view_mouse) {
+    _has_view = true;
+    _view_hovered = hovered;
+    _view_mouse = view_mouse;
+}
+
+void Mouse::clear_view() {
+    _has_view = false;
+}
+
 bool Mouse::has_mouse() const {
-    return _mouse_watcher->has_mouse();
+    return _mouse_watcher->has_mouse() && (!_has_view || _view_hovered);
 }
 
 bool Mouse::is_button_down(int btn_idx) const {
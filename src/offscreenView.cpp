@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <iostream>
+
+#include <camera.h>
+#include <clockObject.h>
+#include <frameBufferProperties.h>
+#include <graphicsEngine.h>
+#include <graphicsPipe.h>
+#include <perspectiveLens.h>
+#include <windowProperties.h>
+
+#include "imgui.h"
+#include "offscreenView.hpp"
+
+namespace {
+    const float MIN_RENDER_SCALE = 0.1f;
+    const float MAX_RENDER_SCALE = 2.0f;
+}
+
+OffscreenView::OffscreenView(const std::string& name) :
+    _name(name),
+    _render_scale(1.0f),
+    _refresh_rate(0.0),
+    _last_render_time(0.0),
+    _visible(true),
+    _rendering(false),
+    _display_size(512, 512),
+    _buffer_size(0, 0),
+    _hovered(false),
+    _mouse(0, 0),
+    _image_rect(0, 1, 0, 1) {}
+
+OffscreenView::~OffscreenView() {
+    destroy();
+}
+
+bool OffscreenView::create(GraphicsOutput* host, int sort) {
+    if (_buffer != nullptr)
+        return true;
+
+    GraphicsEngine* engine = GraphicsEngine::get_global_ptr();
+
+    // The buffer shares the window's GSG so the texture can be shown in it
+    if (host->get_gsg() == nullptr)
+        engine->open_windows();
+
+    FrameBufferProperties fb_props;
+    fb_props.set_rgb_color(true);
+    fb_props.set_color_bits(3 * 8);
+    fb_props.set_depth_bits(24);
+
+    _buffer_size = LVecBase2i(
+        std::max(1, int(_display_size[0] * _render_scale)),
+        std::max(1, int(_display_size[1] * _render_scale)));
+
+    _buffer = engine->make_output(
+        host->get_pipe(),
+        _name,
+        sort,
+        fb_props,
+        WindowProperties::size(_buffer_size[0], _buffer_size[1]),
+        GraphicsPipe::BF_refuse_window | GraphicsPipe::BF_resizeable,
+        host->get_gsg(),
+        host);
+
+    if (_buffer == nullptr) {
+        std::cerr << "OffscreenView: could not create a buffer for " << _name << std::endl;
+        return false;
+    }
+
+    _texture = new Texture(_name);
+    _texture->set_minfilter(SamplerState::FT_linear);
+    _texture->set_magfilter(SamplerState::FT_linear);
+    _buffer->add_render_texture(_texture, GraphicsOutput::RTM_bind_or_copy);
+    _buffer->set_clear_color_active(false);
+    _buffer->set_clear_depth_active(false);
+
+    // Nothing is rendered until the first update decides it is due
+    _buffer->set_active(false);
+    _last_render_time = 0.0;
+    return true;
+}
+
+void OffscreenView::destroy() {
+    if (_buffer == nullptr)
+        return;
+
+    _buffer->clear_render_textures();
+    GraphicsEngine::get_global_ptr()->remove_window(_buffer);
+    _buffer = nullptr;
+    _regions.clear();
+    _cameras.clear();
+    _rendering = false;
+}
+
+bool OffscreenView::is_created() const {
+    return _buffer != nullptr;
+}
+
+DisplayRegion* OffscreenView::add_camera(NodePath camera, int sort, bool clear, const LColor& clear_color) {
+    if (_buffer == nullptr)
+        return nullptr;
+
+    PT(DisplayRegion) region = _buffer->make_display_region();
+    region->set_sort(sort);
+    region->set_camera(camera);
+    region->set_clear_color_active(clear);
+    region->set_clear_depth_active(clear);
+    region->set_clear_color(clear_color);
+
+    _regions.push_back(region);
+    _cameras.push_back(camera);
+    apply_size();
+    return region;
+}
+
+void OffscreenView::set_render_scale(float scale) {
+    _render_scale = std::min(std::max(scale, MIN_RENDER_SCALE), MAX_RENDER_SCALE);
+    apply_size();
+}
+
+float OffscreenView::get_render_scale() const {
+    return _render_scale;
+}
+
+void OffscreenView::set_refresh_rate(double refresh_rate) {
+    _refresh_rate = std::max(refresh_rate, 0.0);
+}
+
+double OffscreenView::get_refresh_rate() const {
+    return _refresh_rate;
+}
+
+void OffscreenView::set_visible(bool visible) {
+    // Shown again, render right away rather than at the next due time
+    if (visible && !_visible)
+        _last_render_time = 0.0;
+    _visible = visible;
+}
+
+bool OffscreenView::is_visible() const {
+    return _visible;
+}
+
+void OffscreenView::set_display_size(int width, int height) {
+    _display_size = LVecBase2i(std::max(width, 1), std::max(height, 1));
+    apply_size();
+}
+
+LVecBase2i OffscreenView::get_buffer_size() const {
+    return _buffer_size;
+}
+
+void OffscreenView::update() {
+    if (_buffer == nullptr)
+        return;
+
+    _rendering = false;
+
+    if (_visible) {
+        // Half a frame of slack, or a rate of half the frame rate drops to a third
+        ClockObject* clock = ClockObject::get_global_clock();
+        double elapsed = clock->get_frame_time() - _last_render_time;
+        _rendering = _refresh_rate <= 0.0 || elapsed + 0.5 * clock->get_dt() >= 1.0 / _refresh_rate;
+        if (_rendering)
+            _last_render_time = clock->get_frame_time();
+    }
+
+    _buffer->set_active(_rendering);
+}
+
+bool OffscreenView::is_rendering() const {
+    return _rendering;
+}
+
+bool OffscreenView::draw_panel(bool* open) {
+    ImGui::SetNextWindowSize(ImVec2(480.0f, 320.0f), ImGuiCond_FirstUseEver);
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
+    bool shown = ImGui::Begin(_name.c_str(), open, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
+    ImGui::PopStyleVar();
+
+    if (open != nullptr && !*open)
+        shown = false;
+
+    _hovered = false;
+
+    if (shown && _texture != nullptr) {
+        ImVec2 size = ImGui::GetContentRegionAvail();
+        set_display_size(int(size.x), int(size.y));
+
+        // Rendered textures are bottom up and may be padded to a power of two
+        LVecBase2 tex_scale = _texture->get_tex_scale();
+        ImGui::Image((ImTextureID)_texture.p(), size, ImVec2(0.0f, tex_scale[1]), ImVec2(tex_scale[0], 0.0f));
+
+        const ImGuiIO& io = ImGui::GetIO();
+        ImVec2 image_min = ImGui::GetItemRectMin();
+        _hovered = ImGui::IsItemHovered();
+
+        if (size.x > 0.0f && size.y > 0.0f) {
+            _mouse = LPoint2(
+                (io.MousePos.x - image_min.x) / size.x * 2.0f - 1.0f,
+                1.0f - (io.MousePos.y - image_min.y) / size.y * 2.0f);
+        }
+
+        if (io.DisplaySize.x > 0.0f && io.DisplaySize.y > 0.0f) {
+            _image_rect = LVecBase4(
+                image_min.x / io.DisplaySize.x,
+                (image_min.x + size.x) / io.DisplaySize.x,
+                1.0f - (image_min.y + size.y) / io.DisplaySize.y,
+                1.0f - image_min.y / io.DisplaySize.y);
+        }
+
+        // What the view costs is set per view
+        if (ImGui::BeginPopupContextItem("ViewSettings")) {
+            float render_scale = _render_scale;
+            if (ImGui::SliderFloat("Render scale", &render_scale, MIN_RENDER_SCALE, MAX_RENDER_SCALE, "%.2f"))
+                set_render_scale(render_scale);
+
+            float refresh_rate = static_cast<float>(_refresh_rate);
+            if (ImGui::DragFloat("Refresh rate", &refresh_rate, 1.0f, 0.0f, 240.0f, refresh_rate > 0.0f ? "%.0f Hz" : "every frame"))
+                set_refresh_rate(refresh_rate);
+
+            ImGui::Text("%d x %d", _buffer_size[0], _buffer_size[1]);
+            ImGui::EndPopup();
+        }
+    }
+
+    ImGui::End();
+
+    set_visible(shown);
+    return shown;
+}
+
+Texture* OffscreenView::get_texture() const {
+    return _texture;
+}
+
+const std::string& OffscreenView::get_name() const {
+    return _name;
+}
+
+bool OffscreenView::is_hovered() const {
+    return _hovered;
+}
+
+LPoint2 OffscreenView::get_mouse() const {
+    return _mouse;
+}
+
+LVecBase4 OffscreenView::get_image_rect() const {
+    return _image_rect;
+}
+
+void OffscreenView::apply_size() {
+    LVecBase2i size(
+        std::max(1, int(_display_size[0] * _render_scale)),
+        std::max(1, int(_display_size[1] * _render_scale)));
+
+    if (_buffer != nullptr && size != _buffer_size)
+        _buffer->set_size(size[0], size[1]);
+    _buffer_size = size;
+
+    // Perspective cameras follow the shape of the view
+    float aspect_ratio = float(_display_size[0]) / float(_display_size[1]);
+    for (const NodePath& camera : _cameras) {
+        Camera* camera_node = DCAST(Camera, camera.node());
+        Lens* lens = camera_node->get_lens();
+        if (lens != nullptr && lens->is_of_type(PerspectiveLens::get_class_type()) &&
+            lens->get_aspect_ratio() != aspect_ratio)
+            lens->set_aspect_ratio(aspect_ratio);
+    }
+}
@@ -0,0 +1,91 @@
+#include <fstream>
+#include <iostream>
+
+#include <filename.h>
+
+#include "prefetchManifest.hpp"
+
+PrefetchManifest::PrefetchManifest() : _recording(false) {}
+
+void PrefetchManifest::set_filename(const std::string& filename) {
+    _filename = filename;
+}
+
+const std::string& PrefetchManifest::get_filename() const {
+    return _filename;
+}
+
+void PrefetchManifest::begin_recording() {
+    _recording = true;
+    _recorded.clear();
+    _recorded_set.clear();
+}
+
+void PrefetchManifest::end_recording() {
+    if (!_recording)
+        return;
+
+    _recording = false;
+
+    // A session that loaded nothing keeps the previous manifest
+    if (_recorded.empty())
+        return;
+
+    _paths = std::move(_recorded);
+    _recorded.clear();
+    _recorded_set.clear();
+    save();
+}
+
+bool PrefetchManifest::is_recording() const {
+    return _recording;
+}
+
+void PrefetchManifest::record(const std::string& path) {
+    if (!_recording || path.empty())
+        return;
+
+    if (_recorded_set.insert(path).second)
+        _recorded.push_back(path);
+}
+
+bool PrefetchManifest::load() {
+    _paths.clear();
+    if (_filename.empty())
+        return false;
+
+    std::ifstream file(_filename);
+    if (!file.is_open())
+        return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty())
+            _paths.push_back(line);
+    }
+    return true;
+}
+
+bool PrefetchManifest::save() const {
+    if (_filename.empty())
+        return false;
+
+    Filename(Filename::from_os_specific(_filename)).make_dir();
+
+    std::ofstream file(_filename, std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "PrefetchManifest: could not write " << _filename << std::endl;
+        return false;
+    }
+
+    for (const std::string& path : _paths) {
+        file << path << "\n";
+    }
+    return true;
+}
+
+const std::vector<std::string>& PrefetchManifest::get_paths() const {
+    return _paths;
+}
@@ -1,14 +1,34 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <config_putil.h>
 #include <loader.h>
+#include <asyncTaskManager.h>
+#include <asyncTaskChain.h>
 #include <loaderOptions.h>
+#include <modelPool.h>
+#include <modelRoot.h>
 #include <nodePath.h>
 #include <texture.h>
+#include <textureCollection.h>
 #include <texturePool.h>
+#include <virtualFileSystem.h>
 
 #include "resourceManager.hpp"
+#include "taskUtils.hpp"
 #include "pathUtils.hpp"
 
 
-ResourceManager::ResourceManager() {
+ResourceManager::ResourceManager() :
+	_job_system(nullptr),
+	_font_cache(_asset_cache),
+	_texture_streaming(false),
+	_issuing_prefetch(false),
+	_texture_cooking(false),
+	_num_loader_threads(2) {
     _loader = Loader::get_global_ptr();
 }
 
@@ -27,13 +47,388 @@ NodePath ResourceManager::load_model(
     const LoaderOptions& options) {
 	
 	NodePath result;
-	
-	PT(PandaNode) node = _loader->load_sync(PathUtils::to_engine_specific(path), options);
+	std::string engine_path = PathUtils::to_engine_specific(path);
+	record_load(engine_path);
+
+	LoadTelemetry::Scope telemetry(_telemetry, "model", engine_path);
+	wait_for_prefetch(engine_path);
+
+	// Already loaded (or prefetched), hand out a copy of the registry's model
+	if (!(options.get_flags() & LoaderOptions::LF_no_cache)) {
+		ResourceHandle handle = _registry.find(ResourceRegistry::MODEL, engine_path);
+		NodePath model = _registry.get_model(handle);
+		if (!model.is_empty()) {
+			telemetry.set_cache(LoadTelemetry::CACHE_HIT);
+			telemetry.end_io();
+			return NodePath(model.node()->copy_subgraph());
+		}
+	}
+
+	// Use the converted '.bam' if there is one, otherwise load the
+	// source and convert it in the background for the next time.
+	Filename load_path = engine_path;
+	if (_asset_cache.is_enabled() && AssetCache::is_cacheable(engine_path)) {
+		Filename cached = _asset_cache.lookup(engine_path, options);
+		if (!cached.empty()) {
+			load_path = cached;
+			telemetry.set_cache(LoadTelemetry::CACHE_HIT);
+		}
+		else {
+			telemetry.set_cache(LoadTelemetry::CACHE_MISS);
+			_asset_cache.convert_model_async(engine_path, options, get_loader_chain()->get_name());
+		}
+	}
+	telemetry.set_file(load_path);
+	telemetry.end_io();
+
+	PT(PandaNode) node = _loader->load_sync(load_path, options);
+	if (node == nullptr && load_path != engine_path)
+		node = _loader->load_sync(engine_path, options);
+	telemetry.end_decode();
+
 	if(node)
 		result = NodePath(node);
+	telemetry.set_failed(result.is_empty());
+
+	if (!result.is_empty() && _texture_cooking && _asset_cache.is_enabled())
+		use_cooked_textures(result, _asset_cache, _cook_options, get_loader_chain()->get_name());
+
+	register_model(engine_path, result);
 	return result;
 }
 
+AsyncLoadHandle ResourceManager::load_model_async(
+	const std::string& path,
+	AsyncLoadCallback callback,
+	int priority) {
+
+	LoaderOptions options = LoaderOptions();
+	options.set_flags(options.get_flags() & ~LoaderOptions::LF_no_cache);
+	options.set_flags(options.get_flags() & ~LoaderOptions::LF_allow_instance);
+
+	return ResourceManager::load_model_async(path, options, std::move(callback), priority);
+}
+
+AsyncLoadHandle ResourceManager::load_model_async(
+	const std::string& path,
+	const LoaderOptions& options,
+	AsyncLoadCallback callback,
+	int priority) {
+
+	AsyncLoadHandle load = std::make_shared<AsyncLoad>(AsyncLoad::MODEL, path, priority);
+	load->_callback = std::move(callback);
+
+	std::string engine_path = PathUtils::to_engine_specific(path);
+	record_load(engine_path);
+
+	// A plain task rather than a ModelLoadRequest, so the load can be timed.
+	// The cache lookup hashes the source file, so it runs in the task too
+	// rather than on the main thread.
+	std::weak_ptr<AsyncLoad> weak_load = load;
+	LoadTelemetry* telemetry = &_telemetry;
+	AssetCache* asset_cache = &_asset_cache;
+	std::string task_chain = get_loader_chain()->get_name();
+	bool cook_textures = _texture_cooking && _asset_cache.is_enabled();
+	TextureCooker::Options cook_options = _cook_options;
+
+	load->_task = make_task([weak_load, engine_path, options, telemetry, asset_cache, task_chain, cook_textures, cook_options](AsyncTask*) -> AsyncTask::DoneStatus {
+		AsyncLoadHandle load = weak_load.lock();
+		if (load == nullptr)
+			return AsyncTask::DS_done;
+
+		LoadTelemetry::Scope scope(*telemetry, "model", engine_path, true);
+
+		Filename load_path = engine_path;
+		if (asset_cache->is_enabled() && AssetCache::is_cacheable(engine_path)) {
+			Filename cached = asset_cache->lookup(engine_path, options);
+			if (!cached.empty()) {
+				load_path = cached;
+				scope.set_cache(LoadTelemetry::CACHE_HIT);
+			}
+			else {
+				scope.set_cache(LoadTelemetry::CACHE_MISS);
+				asset_cache->convert_model_async(engine_path, options, task_chain);
+			}
+		}
+		scope.set_file(load_path);
+		scope.end_io();
+
+		load->_model = Loader::get_global_ptr()->load_sync(load_path, options);
+		if (load->_model == nullptr && load_path != engine_path)
+			load->_model = Loader::get_global_ptr()->load_sync(engine_path, options);
+		scope.end_decode();
+		scope.set_failed(load->_model == nullptr);
+
+		if (load->_model != nullptr && cook_textures)
+			use_cooked_textures(NodePath(load->_model), *asset_cache, cook_options, task_chain);
+		return AsyncTask::DS_done;
+	}, "LoadModel:" + path);
+
+	add_async(load);
+	return load;
+}
+
+AsyncLoadHandle ResourceManager::load_texture_async(
+	const std::string& path,
+	AsyncLoadCallback callback,
+	int priority,
+	bool readMipmaps) {
+
+	AsyncLoadHandle load = std::make_shared<AsyncLoad>(AsyncLoad::TEXTURE, path, priority);
+	load->_callback = std::move(callback);
+
+	// TexturePool is thread safe, the result is only read on
+	// the main thread once the task is done.
+	std::weak_ptr<AsyncLoad> weak_load = load;
+	std::string engine_path = PathUtils::to_engine_specific(path);
+	record_load(engine_path);
+
+	LoadTelemetry* telemetry = &_telemetry;
+
+	load->_task = make_task([weak_load, engine_path, readMipmaps, telemetry](AsyncTask*) -> AsyncTask::DoneStatus {
+		AsyncLoadHandle load = weak_load.lock();
+		if (load == nullptr)
+			return AsyncTask::DS_done;
+
+		LoadTelemetry::Scope scope(*telemetry, "texture", engine_path, true);
+		scope.set_file(engine_path);
+		scope.end_io();
+
+		LoaderOptions options = LoaderOptions();
+		load->_texture = TexturePool::load_texture(engine_path, 0, readMipmaps, options);
+		scope.end_decode();
+		scope.set_failed(load->_texture == nullptr);
+		return AsyncTask::DS_done;
+	}, "LoadTexture:" + path);
+
+	add_async(load);
+	return load;
+}
+
+std::vector<AsyncLoadHandle> ResourceManager::load_batch_async(
+	const std::vector<std::string>& paths,
+	std::function<void(const std::vector<AsyncLoadHandle>&)> callback,
+	int priority) {
+
+	struct BatchState {
+		std::vector<AsyncLoadHandle> loads;
+		std::function<void(const std::vector<AsyncLoadHandle>&)> callback;
+		size_t num_remaining;
+		size_t num_cancelled;
+	};
+
+	if (paths.empty()) {
+		if (callback)
+			callback({});
+		return {};
+	}
+
+	auto batch = std::make_shared<BatchState>();
+	batch->callback = std::move(callback);
+	batch->num_remaining = paths.size();
+	batch->num_cancelled = 0;
+
+	// Every load of the batch holds on to the batch state, the last one
+	// to be delivered or cancelled calls the batch callback. With all of
+	// them cancelled the batch is, e.g. by a script going away.
+	AsyncLoadCallback on_loaded = [batch](const AsyncLoadHandle& load) {
+		if (load->get_status() == AsyncLoad::CANCELLED)
+			++batch->num_cancelled;
+		if (--batch->num_remaining > 0)
+			return;
+
+		auto batch_callback = std::move(batch->callback);
+		batch->callback = nullptr;
+		if (batch_callback && batch->num_cancelled < batch->loads.size())
+			batch_callback(batch->loads);
+		batch->loads.clear();
+	};
+
+	for (const std::string& path : paths) {
+		if (is_texture_path(path))
+			batch->loads.push_back(load_texture_async(path, on_loaded, priority));
+		else
+			batch->loads.push_back(load_model_async(path, on_loaded, priority));
+		batch->loads.back()->_cancel_callback = on_loaded;
+	}
+
+	return batch->loads;
+}
+
+void ResourceManager::prefetch() {
+	if (!_prefetch_manifest.load())
+		return;
+
+	const std::vector<std::string>& paths = _prefetch_manifest.get_paths();
+
+	// Below any load a script asks for, earlier entries first. Recording
+	// is for what the game itself loads, prefetches are left out.
+	int priority = -1000;
+	_issuing_prefetch = true;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		const std::string& engine_path = paths[i];
+		bool is_texture = is_texture_path(engine_path);
+
+		if (_prefetching.count(engine_path) ||
+			_registry.find(is_texture ? ResourceRegistry::TEXTURE : ResourceRegistry::MODEL, engine_path).is_valid())
+			continue;
+
+		AsyncLoadCallback on_loaded = [this, engine_path](const AsyncLoadHandle&) {
+			_prefetching.erase(engine_path);
+		};
+
+		int load_priority = priority - static_cast<int>(i);
+		_prefetching[engine_path] = is_texture ?
+			load_texture_async(engine_path, on_loaded, load_priority) :
+			load_model_async(engine_path, on_loaded, load_priority);
+	}
+	_issuing_prefetch = false;
+}
+
+size_t ResourceManager::get_num_prefetching() const {
+	return _prefetching.size();
+}
+
+PrefetchManifest& ResourceManager::get_prefetch_manifest() {
+	return _prefetch_manifest;
+}
+
+void ResourceManager::cancel_all_async() {
+	for (const AsyncLoadHandle& load : _pending_loads) {
+		load->cancel();
+		load->_cancel_callback = nullptr;
+	}
+	_pending_loads.clear();
+	_prefetching.clear();
+}
+
+void ResourceManager::set_num_loader_threads(int num_threads) {
+	_num_loader_threads = std::max(num_threads, 1);
+	get_loader_chain()->set_num_threads(_num_loader_threads);
+}
+
+int ResourceManager::get_num_loader_threads() const {
+	return _num_loader_threads;
+}
+
+size_t ResourceManager::get_num_pending_async() const {
+	return _pending_loads.size();
+}
+
+void ResourceManager::update() {
+	_sound_manager.update();
+
+	if (_texture_streaming)
+		_texture_streamer.update(get_loader_chain()->get_name());
+
+	if (_pending_loads.empty())
+		return;
+
+	// Move ready loads out first, callbacks may start new loads
+	_finished_loads.clear();
+	for (size_t i = 0; i < _pending_loads.size(); ) {
+		if (_pending_loads[i]->is_ready()) {
+			_finished_loads.push_back(std::move(_pending_loads[i]));
+			_pending_loads[i] = std::move(_pending_loads.back());
+			_pending_loads.pop_back();
+		} else {
+			++i;
+		}
+	}
+
+	// deliver in priority order
+	std::stable_sort(_finished_loads.begin(), _finished_loads.end(),
+		[](const AsyncLoadHandle& a, const AsyncLoadHandle& b) {
+			return a->get_priority() > b->get_priority();
+		});
+
+	for (const AsyncLoadHandle& load : _finished_loads) {
+		if (load->_cancelled) {
+			if (load->_cancel_callback) {
+				AsyncLoadCallback cancel_callback = std::move(load->_cancel_callback);
+				load->_cancel_callback = nullptr;
+				cancel_callback(load);
+			}
+			continue;
+		}
+
+		load->_delivered = true;
+		load->_cancel_callback = nullptr;
+
+		std::string engine_path = PathUtils::to_engine_specific(load->get_path());
+		if (load->get_type() == AsyncLoad::MODEL)
+			register_model(engine_path, load->get_model());
+		else
+			_registry.add_texture(engine_path, load->get_texture(), false);
+
+		if (load->_callback) {
+			AsyncLoadCallback callback = std::move(load->_callback);
+			load->_callback = nullptr;
+			callback(load);
+		}
+	}
+	_finished_loads.clear();
+}
+
+AsyncTaskChain* ResourceManager::get_loader_chain() {
+	AsyncTaskManager* task_mgr = AsyncTaskManager::get_global_ptr();
+
+	AsyncTaskChain* chain = task_mgr->find_task_chain("ResourceLoader");
+	if (chain == nullptr) {
+		chain = task_mgr->make_task_chain("ResourceLoader");
+		chain->set_num_threads(_num_loader_threads);
+		chain->set_thread_priority(TP_low);
+	}
+	return chain;
+}
+
+void ResourceManager::register_model(const std::string& engine_path, NodePath model) {
+	if (model.is_empty() || _registry.find(ResourceRegistry::MODEL, engine_path).is_valid())
+		return;
+
+	// Loads hand out copies of the model pool's model, the registry
+	// watches that one instead of keeping a copy of its own. Not pooled
+	// (LF_no_cache), there is nothing to share. Untracked until a
+	// reference is taken, see acquire_model.
+	if (!model.node()->is_of_type(ModelRoot::get_class_type()))
+		return;
+
+	ModelRoot* pooled = ModelPool::get_model(DCAST(ModelRoot, model.node())->get_fullpath(), false);
+	if (pooled == nullptr)
+		return;
+
+	// Later copies, from here or the loader, then come with them as well
+	if (_texture_cooking && _asset_cache.is_enabled())
+		use_cooked_textures(NodePath(pooled), _asset_cache, _cook_options, get_loader_chain()->get_name());
+
+	_registry.add_model(engine_path, NodePath(pooled), false);
+}
+
+void ResourceManager::record_load(const std::string& engine_path) {
+	if (!_issuing_prefetch)
+		_prefetch_manifest.record(engine_path);
+}
+
+void ResourceManager::wait_for_prefetch(const std::string& engine_path) {
+	auto it = _prefetching.find(engine_path);
+	if (it == _prefetching.end())
+		return;
+
+	// Block until the loader thread is done with it, the sync load that
+	// follows is then served from the model or texture pool.
+	AsyncLoadHandle load = it->second;
+	if (!load->is_ready())
+		load->_task->wait();
+}
+
+void ResourceManager::add_async(const AsyncLoadHandle& load) {
+	load->_task->set_task_chain(get_loader_chain()->get_name());
+	load->_task->set_priority(load->_priority);
+	AsyncTaskManager::get_global_ptr()->add(load->_task);
+
+	_pending_loads.push_back(load);
+}
+
 PT(Texture) ResourceManager::load_texture(const std::string& path, bool isCubeMap) {
 
 	LoaderOptions options = LoaderOptions();
@@ -65,24 +460,317 @@ PT(Texture) ResourceManager::load_texture(
 		
 	if(isCubeMap) {
 
-		// Load a cube map texture
-		std::string texture_pattern = ""; // This should be set appropriately
-		return TexturePool::load_cube_map(PathUtils::to_engine_specific(texture_pattern), readMipmaps, options);
+		// 'path' is the face pattern, e.g. 'sky_#.png'
+		return load_cube_map(path);
 	}
 	else {
 		
-		return TexturePool::load_texture(PathUtils::to_engine_specific(path), 0, readMipmaps, options);
+		std::string engine_path = PathUtils::to_engine_specific(path);
+		record_load(engine_path);
+
+		LoadTelemetry::Scope telemetry(_telemetry, "texture", engine_path);
+		wait_for_prefetch(engine_path);
+
+		PT(Texture) texture;
+		if (_texture_streaming) {
+			telemetry.set_file(engine_path);
+			telemetry.end_io();
+			texture = _texture_streamer.load(engine_path);
+			telemetry.end_decode();
+		}
+
+		// Cooked '.txo' from the cache, otherwise cook one for the next load
+		if (texture == nullptr && _texture_cooking && _asset_cache.is_enabled() &&
+			TextureCooker::is_cookable(engine_path)) {
+			std::string extension = TextureCooker::get_cache_extension(_cook_options);
+			Filename cached = _asset_cache.lookup(engine_path, options, extension);
+			if (!cached.empty()) {
+				telemetry.set_cache(LoadTelemetry::CACHE_HIT);
+				telemetry.set_file(cached);
+				telemetry.end_io();
+				texture = TexturePool::load_texture(cached, 0, false, options);
+				telemetry.end_decode();
+			}
+			else {
+				telemetry.set_cache(LoadTelemetry::CACHE_MISS);
+				TextureCooker::Options cook_options = _cook_options;
+				_asset_cache.convert_async(engine_path, options, extension, get_loader_chain()->get_name(),
+					[cook_options](const Filename& source, const Filename& output) {
+						return TextureCooker::cook(source, output, cook_options);
+					});
+			}
+		}
+
+		if (texture == nullptr) {
+			telemetry.set_file(engine_path);
+			telemetry.end_io();
+			texture = TexturePool::load_texture(engine_path, 0, readMipmaps, options);
+			telemetry.end_decode();
+		}
+		telemetry.set_failed(texture == nullptr);
+
+		_registry.add_texture(engine_path, texture, false);
+		return texture;
+	}
+}
+
+PT(Texture) ResourceManager::load_cube_map(const std::string& pattern, bool prefilter) {
+	std::vector<std::string> faces = TextureCooker::get_cube_map_faces(pattern);
+	if (faces.empty()) {
+		std::cerr << "Cube map pattern has no '#': " << pattern << std::endl;
+		return nullptr;
+	}
+	return load_cube_map(faces, prefilter);
+}
+
+PT(Texture) ResourceManager::load_cube_map(const std::vector<std::string>& faces, bool prefilter) {
+	if (faces.size() != 6) {
+		std::cerr << "A cube map needs 6 faces, got " << faces.size() << std::endl;
+		return nullptr;
 	}
+
+	LoadTelemetry::Scope telemetry(_telemetry, "cube_map", faces[0]);
+
+	VirtualFileSystem* vfs = VirtualFileSystem::get_global_ptr();
+	std::vector<Filename> resolved_faces;
+	std::string faces_key;
+	for (const std::string& face : faces) {
+		Filename resolved = PathUtils::to_engine_specific(face);
+		if (!vfs->resolve_filename(resolved, get_model_path())) {
+			std::cerr << "Could not find cube map face: " << face << std::endl;
+			telemetry.set_failed(true);
+			return nullptr;
+		}
+
+		PT(VirtualFile) file = vfs->get_file(resolved);
+		faces_key += resolved.get_fullpath() + std::to_string(file != nullptr ? file->get_timestamp() : 0);
+		resolved_faces.push_back(resolved);
+	}
+
+	// The cache entry hangs off the first face, the other faces
+	// are part of the extension so changing any of them misses.
+	TextureCooker::Options cook_options = _cook_options;
+	cook_options.generate_mipmaps = true;
+	cook_options.prefilter = prefilter;
+
+	std::ostringstream extension;
+	extension << ".cube" << std::hex << (std::hash<std::string>{}(faces_key) & 0xffffffff)
+			  << TextureCooker::get_cache_extension(cook_options);
+
+	std::string engine_path = resolved_faces[0].get_fullpath();
+	record_load(engine_path);
+
+	ResourceHandle handle = _registry.find(ResourceRegistry::TEXTURE, engine_path + extension.str());
+	if (handle.is_valid()) {
+		telemetry.set_cache(LoadTelemetry::CACHE_HIT);
+		_registry.touch(handle);
+		return _registry.get_texture(handle);
+	}
+
+	LoaderOptions options;
+	PT(Texture) texture;
+	Filename cached = _asset_cache.lookup(engine_path, options, extension.str());
+	if (!cached.empty()) {
+		telemetry.set_cache(LoadTelemetry::CACHE_HIT);
+		telemetry.set_file(cached);
+		telemetry.end_io();
+		texture = TexturePool::load_texture(cached, 0, false, options);
+		telemetry.end_decode();
+	}
+
+	if (texture == nullptr) {
+		if (_asset_cache.is_enabled())
+			telemetry.set_cache(LoadTelemetry::CACHE_MISS);
+		telemetry.end_io();
+		texture = TextureCooker::cook_cube_map(resolved_faces, cook_options, _job_system);
+		telemetry.end_decode();
+		if (texture == nullptr) {
+			telemetry.set_failed(true);
+			return nullptr;
+		}
+
+		// Only writes the cooked texture out, on a loader thread
+		_asset_cache.convert_async(engine_path, options, extension.str(), get_loader_chain()->get_name(),
+			[texture](const Filename&, const Filename& output) {
+				return texture->write(output);
+			});
+	}
+
+	_registry.add_texture(engine_path + extension.str(), texture, false);
+	return texture;
 }
 
-void ResourceManager::load_font(const std::string& font) {
-    // Implement font loading logic here
+ResourceHandle ResourceManager::acquire_model(const std::string& path) {
+	std::string engine_path = PathUtils::to_engine_specific(path);
+
+	ResourceHandle handle = _registry.find(ResourceRegistry::MODEL, engine_path);
+	if (handle.is_valid()) {
+		_registry.add_ref(handle);
+		_registry.touch(handle);
+		return handle;
+	}
+
+	NodePath model = load_model(path);
+	return _registry.add_model(engine_path, model, true);
+}
+
+ResourceHandle ResourceManager::acquire_texture(const std::string& path) {
+	std::string engine_path = PathUtils::to_engine_specific(path);
+
+	ResourceHandle handle = _registry.find(ResourceRegistry::TEXTURE, engine_path);
+	if (handle.is_valid()) {
+		_registry.add_ref(handle);
+		_registry.touch(handle);
+		return handle;
+	}
+
+	PT(Texture) texture = load_texture(path);
+	return _registry.add_texture(engine_path, texture, true);
 }
 
-void ResourceManager::load_sound(const std::string& sound) {
-    // Implement sound loading logic here
+void ResourceManager::release(ResourceHandle& handle) {
+	_registry.release(handle);
+}
+
+PT(TextFont) ResourceManager::load_font(const std::string& font, int pixel_size, bool sdf) {
+    std::string engine_path = PathUtils::to_engine_specific(font);
+
+    // The font cache does its own lookups, all of it counts as decode
+    LoadTelemetry::Scope telemetry(_telemetry, "font", engine_path);
+    telemetry.set_file(engine_path);
+    telemetry.end_io();
+
+    PT(TextFont) result = _font_cache.load(engine_path, pixel_size, sdf);
+    telemetry.end_decode();
+    telemetry.set_failed(result == nullptr);
+    return result;
+}
+
+LoadTelemetry& ResourceManager::get_telemetry() {
+    return _telemetry;
+}
+
+FontCache& ResourceManager::get_font_cache() {
+    return _font_cache;
+}
+
+PT(AudioSound) ResourceManager::load_sound(const std::string& sound, bool stream) {
+	std::string engine_path = PathUtils::to_engine_specific(sound);
+    LoadTelemetry::Scope telemetry(_telemetry, stream ? "sound_stream" : "sound", engine_path);
+    telemetry.set_file(engine_path);
+    telemetry.end_io();
+
+    // nullptr when it failed, the sound manager reports it
+    PT(AudioSound) result = _sound_manager.load(engine_path, stream);
+    telemetry.end_decode();
+    telemetry.set_failed(result == nullptr);
+    return result;
+}
+
+SoundManager& ResourceManager::get_sound_manager() {
+    return _sound_manager;
+}
+
+void ResourceManager::set_job_system(JobSystem* job_system) {
+	_job_system = job_system;
 }
 
 PT(Loader) ResourceManager::get_loader() const {
     return _loader;
 }
+
+AssetCache& ResourceManager::get_asset_cache() {
+    return _asset_cache;
+}
+
+ResourceRegistry& ResourceManager::get_registry() {
+    return _registry;
+}
+
+TextureStreamer& ResourceManager::get_texture_streamer() {
+    return _texture_streamer;
+}
+
+void ResourceManager::set_texture_streaming(bool enabled) {
+    _texture_streaming = enabled;
+}
+
+bool ResourceManager::get_texture_streaming() const {
+    return _texture_streaming;
+}
+
+void ResourceManager::set_texture_cooking(bool enabled, const TextureCooker::Options& options) {
+    _texture_cooking = enabled;
+    _cook_options = options;
+}
+
+bool ResourceManager::get_texture_cooking() const {
+    return _texture_cooking;
+}
+
+AssetCache::Stats ResourceManager::get_cache_stats() const {
+    return _asset_cache.get_stats();
+}
+
+void ResourceManager::use_cooked_textures(
+	NodePath model,
+	AssetCache& asset_cache,
+	const TextureCooker::Options& cook_options,
+	const std::string& task_chain) {
+
+	// Same cache entries as load_texture with its default options
+	std::string extension = TextureCooker::get_cache_extension(cook_options);
+	LoaderOptions options = LoaderOptions();
+
+	TextureCollection textures = model.find_all_textures();
+	for (int i = 0; i < textures.get_num_textures(); ++i) {
+		Texture* texture = textures.get_texture(i);
+
+		// Plain image files only, not cube maps, volumes or separate alpha files
+		std::string source = texture->get_fullpath().get_fullpath();
+		if (source.empty() || texture->get_texture_type() != Texture::TT_2d_texture ||
+			texture->has_alpha_fullpath() || !TextureCooker::is_cookable(source))
+			continue;
+
+		Filename cached = asset_cache.lookup(source, options, extension);
+		if (cached.empty()) {
+			asset_cache.convert_async(source, options, extension, task_chain,
+				[cook_options](const Filename& source, const Filename& output) {
+					return TextureCooker::cook(source, output, cook_options);
+				});
+			continue;
+		}
+
+		// The model's sampler settings stay, the cooked image brings its mips
+		PT(Texture) cooked = TexturePool::load_texture(cached, 0, false, options);
+		if (cooked == nullptr)
+			continue;
+		cooked->set_wrap_u(texture->get_wrap_u());
+		cooked->set_wrap_v(texture->get_wrap_v());
+		cooked->set_magfilter(texture->get_magfilter());
+		model.replace_texture(texture, cooked);
+	}
+}
+
+bool ResourceManager::is_texture_path(const std::string& path) {
+    static const char* texture_extensions[] = {
+        ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".dds",
+        ".tif", ".tiff", ".exr", ".hdr", ".ktx", ".txo", ".sgi", ".rgb",
+    };
+
+    std::string lower_path = path;
+    std::transform(lower_path.begin(), lower_path.end(), lower_path.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    // ignore compression extension, e.g. 'diffuse.png.pz'
+    if (lower_path.size() > 3 && lower_path.compare(lower_path.size() - 3, 3, ".pz") == 0)
+        lower_path.resize(lower_path.size() - 3);
+
+    for (const char* ext : texture_extensions) {
+        size_t ext_len = std::strlen(ext);
+        if (lower_path.size() > ext_len &&
+            lower_path.compare(lower_path.size() - ext_len, ext_len, ext) == 0)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,496 @@
+#include <algorithm>
+#include <unordered_set>
+
+#include <animBundleNode.h>
+#include <animChannelMatrixXfmTable.h>
+#include <animChannelScalarTable.h>
+#include <eventParameter.h>
+#include <geom.h>
+#include <geomNode.h>
+#include <geomPrimitive.h>
+#include <geomVertexData.h>
+#include <modelPool.h>
+#include <modelRoot.h>
+#include <nodePathCollection.h>
+#include <textureCollection.h>
+#include <texturePool.h>
+#include <throw_event.h>
+
+#include "resourceRegistry.hpp"
+
+namespace {
+    const std::string empty_path;
+
+    void add_anim_group_bytes(AnimGroup* group, size_t& bytes) {
+        if (group->is_of_type(AnimChannelMatrixXfmTable::get_class_type())) {
+            AnimChannelMatrixXfmTable* table = DCAST(AnimChannelMatrixXfmTable, group);
+            for (const char* c = "ijkabchprxyz"; *c != '\0'; ++c) {
+                bytes += table->get_table(*c).size() * sizeof(PN_stdfloat);
+            }
+        }
+        else if (group->is_of_type(AnimChannelScalarTable::get_class_type())) {
+            bytes += DCAST(AnimChannelScalarTable, group)->get_table().size() * sizeof(PN_stdfloat);
+        }
+
+        for (int i = 0; i < group->get_num_children(); ++i) {
+            add_anim_group_bytes(group->get_child(i), bytes);
+        }
+    }
+
+    // Collects 'np' itself and its descendants of the given node type
+    NodePathCollection find_all_of_type(NodePath np, const std::string& type_name, TypeHandle type) {
+        NodePathCollection result = np.find_all_matches("**/+" + type_name);
+        if (np.node()->is_of_type(type))
+            result.add_path(np);
+        return result;
+    }
+}
+
+ResourceRegistry::ResourceRegistry() :
+    _bytes(),
+    _untracked_bytes(),
+    _budget(0),
+    _num_evictable(0),
+    _use_counter(0) {}
+
+ResourceHandle ResourceRegistry::add_model(const std::string& path, NodePath model, bool add_ref) {
+    ResourceHandle handle = find(MODEL, path);
+    if (handle.is_valid()) {
+        if (add_ref)
+            this->add_ref(handle);
+        touch(handle);
+        return handle;
+    }
+
+    if (model.is_empty())
+        return ResourceHandle();
+
+    handle = allocate(MODEL, path);
+    Entry* entry = get_entry(handle);
+    entry->weak_model = model.node();
+    if (add_ref)
+        entry->model = model.node();
+    entry->ref_count = add_ref ? 1 : 0;
+    entry->tracked = add_ref;
+    entry->bytes[MODEL] = estimate_geometry_bytes(model);
+    entry->bytes[ANIMATION] = estimate_animation_bytes(model);
+
+    // Textures are tracked as their own entries, shared by every model
+    // using them. Only a tracked model holds references to them.
+    std::vector<ResourceHandle> dependencies;
+    TextureCollection textures = model.find_all_textures();
+    for (int i = 0; i < textures.get_num_textures(); ++i) {
+        Texture* texture = textures.get_texture(i);
+        std::string texture_path = texture->has_fullpath() ? texture->get_fullpath().get_fullpath() : texture->get_name();
+        dependencies.push_back(add_texture(texture_path, texture, add_ref));
+    }
+
+    // add_texture may have grown _entries, look the model entry up again
+    entry = get_entry(handle);
+    entry->dependencies = std::move(dependencies);
+    add_bytes(*entry);
+
+    evict_to_budget();
+    return handle;
+}
+
+ResourceHandle ResourceRegistry::add_texture(const std::string& path, Texture* texture, bool add_ref) {
+    ResourceHandle handle = find(TEXTURE, path);
+    if (handle.is_valid()) {
+        if (add_ref)
+            this->add_ref(handle);
+        touch(handle);
+        return handle;
+    }
+
+    if (texture == nullptr)
+        return ResourceHandle();
+
+    handle = allocate(TEXTURE, path);
+    Entry* entry = get_entry(handle);
+    entry->weak_texture = texture;
+    if (add_ref)
+        entry->texture = texture;
+    entry->ref_count = add_ref ? 1 : 0;
+    entry->tracked = add_ref;
+    entry->bytes[TEXTURE] = estimate_texture_bytes(texture);
+    add_bytes(*entry);
+
+    evict_to_budget();
+    return handle;
+}
+
+ResourceHandle ResourceRegistry::find(Type type, const std::string& path) const {
+    auto it = _lookup[type].find(path);
+    if (it == _lookup[type].end() || is_expired(_entries[it->second]))
+        return ResourceHandle();
+
+    ResourceHandle handle;
+    handle.index = it->second;
+    handle.generation = _entries[it->second].generation;
+    return handle;
+}
+
+bool ResourceRegistry::is_valid(const ResourceHandle& handle) const {
+    return get_entry(handle) != nullptr;
+}
+
+void ResourceRegistry::add_ref(const ResourceHandle& handle) {
+    if (Entry* entry = get_entry(handle)) {
+        take_ref(*entry);
+        evict_to_budget();
+    }
+}
+
+void ResourceRegistry::release(ResourceHandle& handle) {
+    if (Entry* entry = get_entry(handle)) {
+        if (entry->ref_count > 0 && --entry->ref_count == 0 && entry->tracked)
+            ++_num_evictable;
+    }
+    handle = ResourceHandle();
+}
+
+int ResourceRegistry::get_ref_count(const ResourceHandle& handle) const {
+    const Entry* entry = get_entry(handle);
+    return entry != nullptr ? entry->ref_count : 0;
+}
+
+void ResourceRegistry::touch(const ResourceHandle& handle) {
+    if (Entry* entry = get_entry(handle))
+        entry->last_used = ++_use_counter;
+}
+
+NodePath ResourceRegistry::get_model(const ResourceHandle& handle) {
+    Entry* entry = get_entry(handle);
+    if (entry == nullptr)
+        return NodePath();
+
+    PT(PandaNode) model = entry->tracked ? entry->model : entry->weak_model.lock();
+    if (model == nullptr)
+        return NodePath();
+
+    entry->last_used = ++_use_counter;
+    return NodePath(model);
+}
+
+PT(Texture) ResourceRegistry::get_texture(const ResourceHandle& handle) {
+    Entry* entry = get_entry(handle);
+    if (entry == nullptr)
+        return nullptr;
+
+    entry->last_used = ++_use_counter;
+    return entry->tracked ? entry->texture : entry->weak_texture.lock();
+}
+
+const std::string& ResourceRegistry::get_path(const ResourceHandle& handle) const {
+    const Entry* entry = get_entry(handle);
+    return entry != nullptr ? entry->path : empty_path;
+}
+
+void ResourceRegistry::set_budget(size_t bytes) {
+    _budget = bytes;
+    evict_to_budget();
+}
+
+size_t ResourceRegistry::get_budget() const {
+    return _budget;
+}
+
+size_t ResourceRegistry::get_bytes(Type type) const {
+    return _bytes[type];
+}
+
+size_t ResourceRegistry::get_total_bytes() const {
+    return _bytes[MODEL] + _bytes[TEXTURE] + _bytes[ANIMATION];
+}
+
+size_t ResourceRegistry::get_untracked_bytes(Type type) const {
+    return _untracked_bytes[type];
+}
+
+size_t ResourceRegistry::get_num_resources() const {
+    return _entries.size() - _free_entries.size();
+}
+
+size_t ResourceRegistry::evict_to_budget() {
+    if (_budget == 0 || get_total_bytes() <= _budget)
+        return 0;
+
+    return evict_until(_budget);
+}
+
+size_t ResourceRegistry::evict_unreferenced() {
+    return evict_until(0);
+}
+
+void ResourceRegistry::set_evict_callback(EvictCallback callback) {
+    _evict_callback = std::move(callback);
+}
+
+size_t ResourceRegistry::drop_expired() {
+    size_t num_dropped = 0;
+    for (uint32_t i = 0; i < _entries.size(); ++i) {
+        if (_entries[i].alive && is_expired(_entries[i])) {
+            drop(i);
+            ++num_dropped;
+        }
+    }
+    return num_dropped;
+}
+
+void ResourceRegistry::clear() {
+    _entries.clear();
+    _free_entries.clear();
+    for (int i = 0; i < NUM_TYPES; ++i) {
+        _lookup[i].clear();
+        _bytes[i] = 0;
+        _untracked_bytes[i] = 0;
+    }
+    _num_evictable = 0;
+}
+
+size_t ResourceRegistry::estimate_geometry_bytes(NodePath model) {
+    if (model.is_empty())
+        return 0;
+
+    size_t bytes = 0;
+    std::unordered_set<const GeomVertexData*> counted;
+
+    NodePathCollection geom_nodes = find_all_of_type(model, "GeomNode", GeomNode::get_class_type());
+    for (int i = 0; i < geom_nodes.get_num_paths(); ++i) {
+        GeomNode* geom_node = DCAST(GeomNode, geom_nodes.get_path(i).node());
+
+        for (int j = 0; j < geom_node->get_num_geoms(); ++j) {
+            CPT(Geom) geom = geom_node->get_geom(j);
+
+            CPT(GeomVertexData) vdata = geom->get_vertex_data();
+            if (counted.insert(vdata.p()).second) {
+                for (size_t k = 0; k < vdata->get_num_arrays(); ++k) {
+                    bytes += vdata->get_array(k)->get_data_size_bytes();
+                }
+            }
+
+            for (size_t k = 0; k < geom->get_num_primitives(); ++k) {
+                bytes += geom->get_primitive(k)->get_data_size_bytes();
+            }
+        }
+    }
+
+    return bytes;
+}
+
+size_t ResourceRegistry::estimate_animation_bytes(NodePath model) {
+    if (model.is_empty())
+        return 0;
+
+    size_t bytes = 0;
+    NodePathCollection anim_nodes = find_all_of_type(model, "AnimBundleNode", AnimBundleNode::get_class_type());
+    for (int i = 0; i < anim_nodes.get_num_paths(); ++i) {
+        AnimBundle* bundle = DCAST(AnimBundleNode, anim_nodes.get_path(i).node())->get_bundle();
+        if (bundle != nullptr)
+            add_anim_group_bytes(bundle, bytes);
+    }
+
+    return bytes;
+}
+
+size_t ResourceRegistry::estimate_texture_bytes(Texture* texture) {
+    if (texture == nullptr)
+        return 0;
+
+    // Video memory once prepared, plus the system memory copy if kept around
+    size_t bytes = texture->estimate_texture_memory();
+    if (texture->has_ram_image())
+        bytes += texture->get_ram_image_size();
+    return bytes;
+}
+
+ResourceRegistry::Entry* ResourceRegistry::get_entry(const ResourceHandle& handle) {
+    if (handle.index >= _entries.size())
+        return nullptr;
+
+    Entry& entry = _entries[handle.index];
+    return (entry.alive && entry.generation == handle.generation) ? &entry : nullptr;
+}
+
+const ResourceRegistry::Entry* ResourceRegistry::get_entry(const ResourceHandle& handle) const {
+    if (handle.index >= _entries.size())
+        return nullptr;
+
+    const Entry& entry = _entries[handle.index];
+    return (entry.alive && entry.generation == handle.generation) ? &entry : nullptr;
+}
+
+ResourceHandle ResourceRegistry::allocate(Type type, const std::string& path) {
+    // An expired entry for the path makes way for the new one
+    auto it = _lookup[type].find(path);
+    if (it != _lookup[type].end())
+        drop(it->second);
+
+    uint32_t index;
+    if (!_free_entries.empty()) {
+        index = _free_entries.back();
+        _free_entries.pop_back();
+    } else {
+        index = static_cast<uint32_t>(_entries.size());
+        _entries.emplace_back();
+        _entries.back().generation = 0;
+    }
+
+    Entry& entry = _entries[index];
+    entry.type = type;
+    entry.path = path;
+    entry.ref_count = 0;
+    entry.last_used = ++_use_counter;
+    entry.alive = true;
+    entry.tracked = false;
+    entry.model = nullptr;
+    entry.texture = nullptr;
+    entry.weak_model = nullptr;
+    entry.weak_texture = nullptr;
+    std::fill(std::begin(entry.bytes), std::end(entry.bytes), 0);
+    entry.dependencies.clear();
+
+    _lookup[type][path] = index;
+
+    ResourceHandle handle;
+    handle.index = index;
+    handle.generation = entry.generation;
+    return handle;
+}
+
+bool ResourceRegistry::is_expired(const Entry& entry) const {
+    if (entry.tracked)
+        return false;
+    return entry.type == TEXTURE ? entry.weak_texture.was_deleted() : entry.weak_model.was_deleted();
+}
+
+void ResourceRegistry::drop(uint32_t index) {
+    Entry& entry = _entries[index];
+    size_t* bytes = entry.tracked ? _bytes : _untracked_bytes;
+    for (int i = 0; i < NUM_TYPES; ++i) {
+        bytes[i] -= entry.bytes[i];
+    }
+    if (entry.tracked && entry.ref_count == 0)
+        --_num_evictable;
+
+    _lookup[entry.type].erase(entry.path);
+    entry.alive = false;
+    entry.model = nullptr;
+    entry.texture = nullptr;
+    entry.weak_model = nullptr;
+    entry.weak_texture = nullptr;
+    entry.dependencies.clear();
+    ++entry.generation;
+    _free_entries.push_back(index);
+}
+
+void ResourceRegistry::track(Entry& entry) {
+    // From now on the registry holds on to it
+    entry.model = entry.weak_model.lock();
+    entry.texture = entry.weak_texture.lock();
+    entry.tracked = true;
+    for (int i = 0; i < NUM_TYPES; ++i) {
+        _untracked_bytes[i] -= entry.bytes[i];
+        _bytes[i] += entry.bytes[i];
+    }
+
+    // Its textures are now held on to like those of a tracked model
+    for (const ResourceHandle& dependency : entry.dependencies) {
+        if (Entry* texture_entry = get_entry(dependency))
+            take_ref(*texture_entry);
+    }
+}
+
+void ResourceRegistry::take_ref(Entry& entry) {
+    if (!entry.tracked)
+        track(entry);
+    else if (entry.ref_count == 0)
+        --_num_evictable;
+
+    ++entry.ref_count;
+}
+
+void ResourceRegistry::add_bytes(const Entry& entry) {
+    size_t* bytes = entry.tracked ? _bytes : _untracked_bytes;
+    for (int i = 0; i < NUM_TYPES; ++i) {
+        bytes[i] += entry.bytes[i];
+    }
+}
+
+size_t ResourceRegistry::evict(uint32_t index) {
+    Entry& entry = _entries[index];
+    --_num_evictable;
+
+    size_t freed = 0;
+    for (int i = 0; i < NUM_TYPES; ++i) {
+        _bytes[i] -= entry.bytes[i];
+        freed += entry.bytes[i];
+    }
+
+    // Release from the pools so the next load reads it again, the memory
+    // itself is freed once nothing in the scene graph uses it anymore.
+    if (entry.model != nullptr && entry.model->is_of_type(ModelRoot::get_class_type()))
+        ModelPool::release_model(DCAST(ModelRoot, entry.model)->get_fullpath());
+    if (entry.texture != nullptr)
+        TexturePool::release_texture(entry.texture);
+
+    Type type = entry.type;
+    std::string path = std::move(entry.path);
+    std::vector<ResourceHandle> dependencies = std::move(entry.dependencies);
+
+    _lookup[type].erase(path);
+    entry.alive = false;
+    entry.model = nullptr;
+    entry.texture = nullptr;
+    entry.weak_model = nullptr;
+    entry.weak_texture = nullptr;
+    entry.dependencies.clear();
+    ++entry.generation;
+    _free_entries.push_back(index);
+
+    // The model no longer holds on to its textures
+    for (ResourceHandle& dependency : dependencies) {
+        release(dependency);
+    }
+
+    throw_event("resource-evicted", EventParameter(path));
+    if (_evict_callback)
+        _evict_callback(type, path);
+
+    return freed;
+}
+
+size_t ResourceRegistry::evict_until(size_t target_bytes) {
+    size_t freed = 0;
+
+    // Evicting a model can make its textures unreferenced,
+    // so keep going until nothing more can be evicted.
+    bool evicted = true;
+    while (evicted && _num_evictable > 0 && get_total_bytes() > target_bytes) {
+        evicted = false;
+
+        std::vector<uint32_t> candidates;
+        candidates.reserve(_num_evictable);
+        for (uint32_t i = 0; i < _entries.size(); ++i) {
+            const Entry& entry = _entries[i];
+            if (entry.alive && entry.tracked && entry.ref_count == 0)
+                candidates.push_back(i);
+        }
+
+        // least recently used first
+        std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+            return _entries[a].last_used < _entries[b].last_used;
+        });
+
+        for (uint32_t index : candidates) {
+            if (get_total_bytes() <= target_bytes)
+                break;
+
+            freed += evict(index);
+            evicted = true;
+        }
+    }
+
+    return freed;
+}
@@ -2,12 +2,15 @@
 #include "asyncTaskManager.h"
 #include "runtimeScript.hpp"
 #include <mouseButton.h>
+#include <algorithm>
 
 // Constructors
 RuntimeScript::RuntimeScript(Demon& demon) :
     demon(demon),
     game(demon.game),
-    resource_manager(demon.engine.resource_manager) {}
+    resource_manager(demon.engine.resource_manager),
+    job_system(demon.engine.job_system),
+    debug_draw(demon.engine.debug_draw) {}
 
 // Destructor
 RuntimeScript::~RuntimeScript() {}
@@ -39,6 +42,11 @@ void RuntimeScript::start() {
         ImGui::SetCurrentContext(demon.p3d_imgui.context_);
         this->render_imgui();
     });
+
+    demon.engine.accept(script_name, "render_game_imgui", [this]() {
+        ImGui::SetCurrentContext(demon.game_imgui.context_);
+        this->render_game_imgui();
+    });
         
     // Start the update task and finalize
     start_update_task();
@@ -46,6 +54,7 @@ void RuntimeScript::start() {
 }
 
 void RuntimeScript::render_imgui() {}
+void RuntimeScript::render_game_imgui() {}
 
 // Getters
 int RuntimeScript::get_sort() { return -1; }
@@ -79,6 +88,47 @@ void RuntimeScript::register_button_map(
     }
 }
 
+// Coroutines
+void RuntimeScript::start_coroutine(CoTask task) {
+    // forget about coroutines that have already finished
+    coroutines.erase(
+        std::remove_if(coroutines.begin(), coroutines.end(),
+            [](const CoTask& co) { return co.is_done(); }),
+        coroutines.end());
+
+    if (!task.is_done())
+        coroutines.push_back(std::move(task));
+}
+
+// Timers
+TimerHandle RuntimeScript::after_frames(int num_frames, std::function<void()> callback) {
+    return track_timer(demon.engine.timers.after_frames(num_frames, std::move(callback)));
+}
+
+TimerHandle RuntimeScript::after_seconds(double seconds, std::function<void()> callback) {
+    return track_timer(demon.engine.timers.after_seconds(seconds, std::move(callback)));
+}
+
+TimerHandle RuntimeScript::track_timer(TimerHandle handle) {
+    // Forget about timers that have already fired, the threshold grows
+    // with the number of live timers to keep this amortized O(1).
+    if (timers.size() >= timers_prune_size) {
+        TimerService& timer_service = demon.engine.timers;
+        timers.erase(
+            std::remove_if(timers.begin(), timers.end(),
+                [&timer_service](const TimerHandle& h) { return !timer_service.is_pending(h); }),
+            timers.end());
+        timers_prune_size = std::max<size_t>(64, timers.size() * 2);
+    }
+
+    timers.push_back(handle);
+    return handle;
+}
+
+void RuntimeScript::cancel_timer(TimerHandle& handle) {
+    demon.engine.timers.cancel(handle);
+}
+
 // Event handling
 void RuntimeScript::on_update(const PT(AsyncTask)&) {}
  
@@ -112,6 +162,19 @@ void RuntimeScript::stop_update_task() {
     demon.engine.remove_event_listener(script_name + "EventListener");
     std::cout << "Ignoring events from script: " << script_name << std::endl;
     demon.engine.ignore(script_name);
+
+    // Coroutine frames live in the script dll, destroy them before it is unloaded
+    for (CoTask& co : coroutines) {
+        co.cancel();
+    }
+    coroutines.clear();
+
+    // Same for timer callbacks
+    for (TimerHandle& handle : timers) {
+        demon.engine.timers.cancel(handle);
+    }
+    timers.clear();
+
     input_map.clear();
     buttons_map_.clear();
 }
@@ -0,0 +1,381 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <asyncTaskChain.h>
+#include <asyncTaskManager.h>
+#include <clockObject.h>
+#include <nullAudioManager.h>
+#include <nullAudioSound.h>
+
+#include "pathUtils.hpp"
+#include "soundManager.hpp"
+#include "taskUtils.hpp"
+
+namespace {
+    // Idle effect sounds kept per file
+    const size_t MAX_POOLED_PER_FILE = 8;
+
+    // Voices quieter than this are never worth a real slot
+    const float MIN_AUDIBILITY = 0.001f;
+
+    double get_now() {
+        return ClockObject::get_global_clock()->get_frame_time();
+    }
+}
+
+SoundManager::SoundManager() :
+    _initialized(false),
+    _max_voices(32),
+    _category_volume{ 1.0f, 1.0f },
+    _min_distance(1.0f),
+    _max_distance(100.0f),
+    _null_sound_length(1.0),
+    _num_virtual(0) {}
+
+SoundManager::~SoundManager() {}
+
+void SoundManager::initialize(bool null_audio) {
+    if (_initialized)
+        return;
+
+    _initialized = true;
+
+    // Falls back to a null manager when there is no audio device or library
+    if (null_audio) {
+        _effects_manager = new NullAudioManager();
+        _music_manager = new NullAudioManager();
+    } else {
+        _effects_manager = AudioManager::create_AudioManager();
+        _music_manager = AudioManager::create_AudioManager();
+    }
+
+    // The music manager refills stream buffers in its update, run
+    // it on its own thread so streams don't depend on frame rate.
+    AsyncTaskManager* task_mgr = AsyncTaskManager::get_global_ptr();
+    AsyncTaskChain* chain = task_mgr->find_task_chain("AudioStream");
+    if (chain == nullptr) {
+        chain = task_mgr->make_task_chain("AudioStream");
+        chain->set_num_threads(1);
+    }
+
+    PT(AudioManager) music_manager = _music_manager;
+    _stream_task = make_task([music_manager](AsyncTask* task) -> AsyncTask::DoneStatus {
+        music_manager->update();
+        task->set_delay(0.02);
+        return AsyncTask::DS_again;
+    }, "AudioStreamUpdate");
+    _stream_task->set_task_chain("AudioStream");
+    task_mgr->add(_stream_task);
+}
+
+void SoundManager::shutdown() {
+    if (!_initialized)
+        return;
+
+    stop_all();
+
+    if (_stream_task != nullptr) {
+        _stream_task->remove();
+        _stream_task = nullptr;
+    }
+
+    _effect_pool.clear();
+    _voices.clear();
+    _free_voices.clear();
+    _num_virtual = 0;
+
+    _music_manager->shutdown();
+    _effects_manager->shutdown();
+    _music_manager = nullptr;
+    _effects_manager = nullptr;
+    _initialized = false;
+}
+
+bool SoundManager::is_null() const {
+    return _effects_manager == nullptr || !_effects_manager->is_valid();
+}
+
+PT(AudioSound) SoundManager::load(const std::string& path, bool stream) {
+    initialize();
+    return get_sound(PathUtils::to_engine_specific(path), stream ? MUSIC : EFFECT);
+}
+
+SoundHandle SoundManager::play(
+    const std::string& path,
+    Category category,
+    int priority,
+    float volume,
+    bool loop,
+    NodePath emitter) {
+
+    initialize();
+
+    std::string engine_path = PathUtils::to_engine_specific(path);
+    PT(AudioSound) sound = acquire_sound(engine_path, category);
+    if (sound == nullptr)
+        return SoundHandle();
+
+    uint32_t index;
+    if (!_free_voices.empty()) {
+        index = _free_voices.back();
+        _free_voices.pop_back();
+    } else {
+        index = static_cast<uint32_t>(_voices.size());
+        _voices.emplace_back();
+        _voices.back().generation = 0;
+        _voices.back().active = false;
+    }
+
+    Voice& voice = _voices[index];
+    voice.path = engine_path;
+    voice.category = category;
+    voice.sound = sound;
+    voice.emitter = emitter;
+    voice.priority = priority;
+    voice.volume = volume;
+    voice.loop = loop;
+    voice.active = true;
+    voice.is_virtual = true;
+    voice.start_time = get_now();
+    voice.audibility = compute_audibility(voice);
+    ++_num_virtual;
+
+    // Start right away if there is a free slot, otherwise
+    // the next update decides whether it is worth one.
+    if (get_num_voices() - _num_virtual < _max_voices && voice.audibility > MIN_AUDIBILITY)
+        make_real(voice, voice.start_time);
+
+    SoundHandle handle;
+    handle.index = index;
+    handle.generation = voice.generation;
+    return handle;
+}
+
+void SoundManager::stop(SoundHandle& handle) {
+    if (Voice* voice = get_voice(handle))
+        release_voice(*voice);
+    handle = SoundHandle();
+}
+
+void SoundManager::stop_all() {
+    for (Voice& voice : _voices) {
+        if (voice.active)
+            release_voice(voice);
+    }
+}
+
+bool SoundManager::is_playing(const SoundHandle& handle) const {
+    return get_voice(handle) != nullptr;
+}
+
+bool SoundManager::is_virtual(const SoundHandle& handle) const {
+    const Voice* voice = get_voice(handle);
+    return voice != nullptr && voice->is_virtual;
+}
+
+void SoundManager::set_volume(const SoundHandle& handle, float volume) {
+    if (Voice* voice = get_voice(handle))
+        voice->volume = volume;
+}
+
+void SoundManager::set_listener(NodePath listener) {
+    _listener = listener;
+}
+
+void SoundManager::set_max_voices(int max_voices) {
+    _max_voices = std::max(max_voices, 0);
+}
+
+void SoundManager::set_category_volume(Category category, float volume) {
+    _category_volume[category] = std::max(volume, 0.0f);
+}
+
+void SoundManager::set_distance_range(float min_distance, float max_distance) {
+    _min_distance = std::max(min_distance, 0.001f);
+    _max_distance = std::max(max_distance, _min_distance);
+}
+
+void SoundManager::set_null_sound_length(double seconds) {
+    _null_sound_length = std::max(seconds, 0.0);
+}
+
+void SoundManager::update() {
+    if (!_initialized)
+        return;
+
+    _effects_manager->update();
+
+    double now = get_now();
+    bool null_audio = is_null();
+    std::vector<Voice*> voices;
+
+    for (Voice& voice : _voices) {
+        if (!voice.active)
+            continue;
+
+        // One shots end when the sound stops, or for virtual voices
+        // once their position would have passed the end. Null sounds
+        // never play, their voices only go by the time passed.
+        double elapsed = now - voice.start_time;
+        bool finished = false;
+        if (!voice.loop) {
+            if (null_audio)
+                finished = elapsed >= _null_sound_length;
+            else if (voice.is_virtual)
+                finished = elapsed >= voice.sound->length();
+            else
+                finished = voice.sound->status() != AudioSound::PLAYING;
+        }
+
+        if (finished) {
+            release_voice(voice);
+            continue;
+        }
+
+        voice.audibility = compute_audibility(voice);
+        voices.push_back(&voice);
+    }
+
+    // Highest priority first, then loudest
+    std::sort(voices.begin(), voices.end(), [](const Voice* a, const Voice* b) {
+        if (a->priority != b->priority)
+            return a->priority > b->priority;
+        return a->audibility > b->audibility;
+    });
+
+    // Virtualise first so slots are free before others become real
+    for (size_t i = 0; i < voices.size(); ++i) {
+        Voice& voice = *voices[i];
+        bool audible = (int)i < _max_voices && voice.audibility > MIN_AUDIBILITY;
+        if (!audible && !voice.is_virtual)
+            make_virtual(voice);
+    }
+
+    for (size_t i = 0; i < voices.size(); ++i) {
+        Voice& voice = *voices[i];
+        bool audible = (int)i < _max_voices && voice.audibility > MIN_AUDIBILITY;
+        if (audible && voice.is_virtual)
+            make_real(voice, now);
+        else if (audible)
+            voice.sound->set_volume(voice.audibility);
+    }
+}
+
+int SoundManager::get_max_voices() const {
+    return _max_voices;
+}
+
+int SoundManager::get_num_voices() const {
+    return static_cast<int>(_voices.size() - _free_voices.size());
+}
+
+int SoundManager::get_num_virtual() const {
+    return _num_virtual;
+}
+
+SoundManager::Voice* SoundManager::get_voice(const SoundHandle& handle) {
+    if (handle.index >= _voices.size())
+        return nullptr;
+
+    Voice& voice = _voices[handle.index];
+    return (voice.active && voice.generation == handle.generation) ? &voice : nullptr;
+}
+
+const SoundManager::Voice* SoundManager::get_voice(const SoundHandle& handle) const {
+    if (handle.index >= _voices.size())
+        return nullptr;
+
+    const Voice& voice = _voices[handle.index];
+    return (voice.active && voice.generation == handle.generation) ? &voice : nullptr;
+}
+
+PT(AudioSound) SoundManager::acquire_sound(const std::string& path, Category category) {
+    if (category == MUSIC)
+        return get_sound(path, MUSIC);
+
+    // Every sound of the same file shares the decoded sample data in the
+    // manager's cache, pooling also saves creating the sound objects.
+    std::vector<PT(AudioSound)>& pool = _effect_pool[path];
+    if (!pool.empty()) {
+        PT(AudioSound) sound = pool.back();
+        pool.pop_back();
+        return sound;
+    }
+
+    return get_sound(path, EFFECT);
+}
+
+PT(AudioSound) SoundManager::get_sound(const std::string& path, Category category) {
+    PT(AudioSound) sound = category == MUSIC ?
+        _music_manager->get_sound(path, false, AudioManager::SM_stream) :
+        _effects_manager->get_sound(path, false, AudioManager::SM_sample);
+
+    // A real manager hands out a null sound for files it can't load, with
+    // the null manager every sound is one
+    if (sound == nullptr || (!is_null() && sound->is_of_type(NullAudioSound::get_class_type()))) {
+        std::cerr << "SoundManager: could not load " << path << std::endl;
+        return nullptr;
+    }
+    return sound;
+}
+
+void SoundManager::release_voice(Voice& voice) {
+    voice.sound->stop();
+
+    if (voice.is_virtual)
+        --_num_virtual;
+
+    if (voice.category == EFFECT) {
+        std::vector<PT(AudioSound)>& pool = _effect_pool[voice.path];
+        if (pool.size() < MAX_POOLED_PER_FILE)
+            pool.push_back(voice.sound);
+    }
+
+    voice.sound = nullptr;
+    voice.emitter = NodePath();
+    voice.active = false;
+    voice.is_virtual = false;
+    ++voice.generation;
+    _free_voices.push_back(static_cast<uint32_t>(&voice - _voices.data()));
+}
+
+void SoundManager::make_real(Voice& voice, double now) {
+    double position = now - voice.start_time;
+    double length = voice.sound->length();
+    if (voice.loop && length > 0.0)
+        position = std::fmod(position, length);
+
+    voice.sound->set_loop(voice.loop);
+    voice.sound->set_volume(voice.audibility);
+    voice.sound->set_time(static_cast<PN_stdfloat>(position));
+    voice.sound->play();
+
+    voice.is_virtual = false;
+    --_num_virtual;
+}
+
+void SoundManager::make_virtual(Voice& voice) {
+    // The position keeps moving with start_time, nothing else to remember
+    voice.sound->stop();
+    voice.is_virtual = true;
+    ++_num_virtual;
+}
+
+float SoundManager::compute_audibility(const Voice& voice) const {
+    float audibility = voice.volume * _category_volume[voice.category];
+
+    if (!voice.emitter.is_empty() && !_listener.is_empty()) {
+        float distance = voice.emitter.get_distance(_listener);
+        if (distance >= _max_distance)
+            return 0.0f;
+
+        // Inverse distance, faded to silence at the max distance
+        if (distance > _min_distance) {
+            float fade = 1.0f - (distance - _min_distance) / (_max_distance - _min_distance);
+            audibility *= (_min_distance / distance) * fade;
+        }
+    }
+
+    return audibility;
+}
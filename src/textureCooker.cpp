@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <pnmImage.h>
+
+#include "jobSystem.hpp"
+#include "textureCooker.hpp"
+
+namespace {
+    // Halves the image until it fits the size limit, keeping the aspect
+    void scale_to_max_size(PNMImage& image, const TextureCooker::Options& options) {
+        if (options.max_size <= 0 || std::max(image.get_x_size(), image.get_y_size()) <= options.max_size)
+            return;
+
+        int x_size = image.get_x_size();
+        int y_size = image.get_y_size();
+        while (std::max(x_size, y_size) > options.max_size) {
+            x_size = std::max(x_size / 2, 1);
+            y_size = std::max(y_size / 2, 1);
+        }
+
+        PNMImage scaled(x_size, y_size, image.get_num_channels(), image.get_maxval(), image.get_type());
+        scaled.gaussian_filter_from(options.filter_radius, image);
+        image = scaled;
+    }
+
+    PNMImage make_mip_level(const PNMImage& above, float radius) {
+        int x_size = std::max(above.get_x_size() / 2, 1);
+        int y_size = std::max(above.get_y_size() / 2, 1);
+
+        PNMImage level(x_size, y_size, above.get_num_channels(), above.get_maxval(), above.get_type());
+        level.gaussian_filter_from(radius, above);
+        return level;
+    }
+
+    // Cube map faces in the layout the GPU samples them with, 's' and 't'
+    // in -1..1. Texture::load stores image rows bottom up, so 't' runs
+    // up the image.
+    LVector3 face_direction(int face, float s, float t) {
+        switch (face) {
+        case 0: return LVector3(1, -t, -s);
+        case 1: return LVector3(-1, -t, s);
+        case 2: return LVector3(s, 1, t);
+        case 3: return LVector3(s, -1, -t);
+        case 4: return LVector3(s, -t, 1);
+        default: return LVector3(-s, -t, -1);
+        }
+    }
+
+    int direction_face(const LVector3& dir, float& s, float& t) {
+        float ax = std::fabs(dir[0]), ay = std::fabs(dir[1]), az = std::fabs(dir[2]);
+        if (ax >= ay && ax >= az) {
+            s = (dir[0] > 0 ? -dir[2] : dir[2]) / ax;
+            t = -dir[1] / ax;
+            return dir[0] > 0 ? 0 : 1;
+        }
+        if (ay >= az) {
+            s = dir[0] / ay;
+            t = (dir[1] > 0 ? dir[2] : -dir[2]) / ay;
+            return dir[1] > 0 ? 2 : 3;
+        }
+        s = (dir[2] > 0 ? dir[0] : -dir[0]) / az;
+        t = -dir[1] / az;
+        return dir[2] > 0 ? 4 : 5;
+    }
+
+    // Bilinear, clamped to the face, directions past its edge are on the next face
+    LColorf sample_cube(const std::vector<PNMImage>& faces, const LVector3& dir) {
+        float s, t;
+        const PNMImage& image = faces[direction_face(dir, s, t)];
+        int size = image.get_x_size();
+
+        float x = (s + 1.0f) * 0.5f * size - 0.5f;
+        float y = (1.0f - t) * 0.5f * size - 0.5f;
+        x = std::min(std::max(x, 0.0f), float(size - 1));
+        y = std::min(std::max(y, 0.0f), float(size - 1));
+
+        int x0 = int(x), y0 = int(y);
+        int x1 = std::min(x0 + 1, size - 1), y1 = std::min(y0 + 1, size - 1);
+        float fx = x - x0, fy = y - y0;
+
+        auto texel = [&image](int px, int py) {
+            LRGBColorf rgb = image.get_xel(px, py);
+            return LColorf(rgb[0], rgb[1], rgb[2], image.has_alpha() ? image.get_alpha(px, py) : 1.0f);
+        };
+        return (texel(x0, y0) * (1 - fx) + texel(x1, y0) * fx) * (1 - fy) +
+               (texel(x0, y1) * (1 - fx) + texel(x1, y1) * fx) * fy;
+    }
+
+    // One face of the next mip level of a prefiltered cube map. Each texel
+    // is a gaussian over directions around its own, 'sigma' in texels of
+    // the level above, so taps near an edge read the neighbouring faces
+    // and rough levels have no seams. Taps are spread on the tangent plane,
+    // which is close to the angle for the small blurs of one level.
+    PNMImage prefilter_cube_face(const std::vector<PNMImage>& above, int face, float sigma) {
+        const PNMImage& source = above[face];
+        int size = std::max(source.get_x_size() / 2, 1);
+        PNMImage level(size, size, source.get_num_channels(), source.get_maxval(), source.get_type());
+
+        // A face is 2 units across at distance 1
+        float angle = sigma * 2.0f / source.get_x_size();
+        int num_taps = std::min(std::max(int(std::ceil(2.0f * sigma)), 2), 8);
+        float step = 2.0f * angle / num_taps;
+
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                float s = (x + 0.5f) / size * 2.0f - 1.0f;
+                float t = 1.0f - (y + 0.5f) / size * 2.0f;
+                LVector3 dir = face_direction(face, s, t);
+                dir.normalize();
+
+                LVector3 up = std::fabs(dir[2]) < 0.999f ? LVector3(0, 0, 1) : LVector3(1, 0, 0);
+                LVector3 tangent = up.cross(dir);
+                tangent.normalize();
+                LVector3 bitangent = dir.cross(tangent);
+
+                LColorf sum(0, 0, 0, 0);
+                float weight_sum = 0.0f;
+                for (int j = -num_taps; j <= num_taps; ++j) {
+                    for (int i = -num_taps; i <= num_taps; ++i) {
+                        float u = i * step, v = j * step;
+                        float weight = std::exp(-(u * u + v * v) / (2.0f * angle * angle));
+                        sum += sample_cube(above, dir + tangent * u + bitangent * v) * weight;
+                        weight_sum += weight;
+                    }
+                }
+
+                LColorf color = sum / weight_sum;
+                level.set_xel(x, y, color[0], color[1], color[2]);
+                if (level.has_alpha())
+                    level.set_alpha(x, y, color[3]);
+            }
+        }
+        return level;
+    }
+
+    Texture::Format get_format(int num_channels) {
+        switch (num_channels) {
+        case 1: return Texture::F_luminance;
+        case 2: return Texture::F_luminance_alpha;
+        case 3: return Texture::F_rgb;
+        default: return Texture::F_rgba;
+        }
+    }
+
+    void compress(Texture* texture, const std::string& name) {
+        Texture::CompressionMode mode = Texture::has_alpha(texture->get_format()) ?
+            Texture::CM_dxt5 : Texture::CM_dxt1;
+
+        // Needs a Panda3D built with squish, otherwise stays uncompressed
+        if (!texture->compress_ram_image(mode))
+            std::cerr << "TextureCooker: block compression unavailable for " << name << std::endl;
+    }
+}
+
+PT(Texture) TextureCooker::cook(const Filename& source, const Options& options) {
+    PNMImage image;
+    if (!image.read(source)) {
+        std::cerr << "TextureCooker: could not read " << source << std::endl;
+        return nullptr;
+    }
+
+    scale_to_max_size(image, options);
+
+    PT(Texture) texture = new Texture(source.get_basename_wo_extension());
+    if (!texture->load(image)) {
+        std::cerr << "TextureCooker: could not convert " << source << std::endl;
+        return nullptr;
+    }
+    texture->set_filename(source);
+    texture->set_fullpath(source);
+
+    if (options.generate_mipmaps) {
+        // Each level is filtered from the one above, unlike
+        // generate_ram_mipmap_images which uses a box filter.
+        PNMImage level_image = image;
+
+        for (int level = 1; level_image.get_x_size() > 1 || level_image.get_y_size() > 1; ++level) {
+            PNMImage next = make_mip_level(level_image, options.filter_radius);
+
+            PT(Texture) level_texture = new Texture;
+            level_texture->load(next);
+            texture->set_ram_mipmap_image(level, level_texture->get_ram_image());
+
+            level_image = next;
+        }
+
+        texture->set_minfilter(SamplerState::FT_linear_mipmap_linear);
+    }
+
+    if (options.compress)
+        compress(texture, source.get_fullpath());
+
+    return texture;
+}
+
+PT(Texture) TextureCooker::cook_cube_map(const std::vector<Filename>& faces, const Options& options, JobSystem* job_system) {
+    if (faces.size() != 6) {
+        std::cerr << "TextureCooker: a cube map needs 6 faces, got " << faces.size() << std::endl;
+        return nullptr;
+    }
+
+    // levels[face][mip], every face is decoded and filtered by its own job
+    std::vector<std::vector<PNMImage>> levels(6);
+    std::atomic<bool> failed(false);
+
+    auto cook_faces = [&](size_t begin, size_t end) {
+        for (size_t face = begin; face < end; ++face) {
+            std::vector<PNMImage>& face_levels = levels[face];
+            face_levels.emplace_back();
+            if (!face_levels[0].read(faces[face])) {
+                std::cerr << "TextureCooker: could not read " << faces[face] << std::endl;
+                failed = true;
+                continue;
+            }
+
+            scale_to_max_size(face_levels[0], options);
+            if (!options.generate_mipmaps || options.prefilter)
+                continue;
+
+            for (int level = 1; face_levels.back().get_x_size() > 1; ++level)
+                face_levels.push_back(make_mip_level(face_levels.back(), options.filter_radius));
+        }
+    };
+
+    auto run_faces = [job_system](const std::function<void(size_t, size_t)>& fn) {
+        if (job_system != nullptr && job_system->is_running())
+            job_system->parallel_for(0, 6, fn, 1);
+        else
+            fn(0, 6);
+    };
+
+    run_faces(cook_faces);
+
+    if (failed)
+        return nullptr;
+
+    const PNMImage& first = levels[0][0];
+    for (const std::vector<PNMImage>& face_levels : levels) {
+        const PNMImage& top = face_levels[0];
+        if (top.get_x_size() != top.get_y_size() || top.get_x_size() != first.get_x_size() ||
+            top.get_num_channels() != first.get_num_channels()) {
+            std::cerr << "TextureCooker: cube map faces must be square and alike, " << faces[0] << std::endl;
+            return nullptr;
+        }
+    }
+
+    // Prefiltered levels read across the faces, so every face of a level
+    // is done before the next level starts
+    if (options.generate_mipmaps && options.prefilter) {
+        for (int level = 1; levels[0].back().get_x_size() > 1; ++level) {
+            std::vector<PNMImage> above;
+            for (const std::vector<PNMImage>& face_levels : levels)
+                above.push_back(face_levels.back());
+
+            float sigma = options.filter_radius * (1 + level);
+            run_faces([&](size_t begin, size_t end) {
+                for (size_t face = begin; face < end; ++face)
+                    levels[face].push_back(prefilter_cube_face(above, int(face), sigma));
+            });
+        }
+    }
+
+    // Levels were added, the top one may have moved
+    const PNMImage& top = levels[0][0];
+    PT(Texture) texture = new Texture(faces[0].get_basename_wo_extension());
+    texture->setup_cube_map(
+        top.get_x_size(),
+        top.get_maxval() > 255 ? Texture::T_unsigned_short : Texture::T_unsigned_byte,
+        get_format(top.get_num_channels()));
+
+    for (int face = 0; face < 6; ++face) {
+        for (int level = 0; level < (int)levels[face].size(); ++level) {
+            if (!texture->load(levels[face][level], face, level)) {
+                std::cerr << "TextureCooker: could not convert " << faces[face] << std::endl;
+                return nullptr;
+            }
+        }
+    }
+
+    if (options.generate_mipmaps)
+        texture->set_minfilter(SamplerState::FT_linear_mipmap_linear);
+    else
+        texture->set_minfilter(SamplerState::FT_linear);
+    texture->set_magfilter(SamplerState::FT_linear);
+
+    if (options.compress)
+        compress(texture, faces[0].get_fullpath());
+
+    return texture;
+}
+
+std::vector<std::string> TextureCooker::get_cube_map_faces(const std::string& pattern) {
+    std::vector<std::string> faces;
+    size_t hash = pattern.find('#');
+    if (hash == std::string::npos)
+        return faces;
+
+    for (int face = 0; face < 6; ++face) {
+        std::string path = pattern;
+        path.replace(hash, 1, std::to_string(face));
+        faces.push_back(path);
+    }
+    return faces;
+}
+
+bool TextureCooker::cook(const Filename& source, const Filename& output, const Options& options) {
+    PT(Texture) texture = cook(source, options);
+    if (texture == nullptr)
+        return false;
+
+    // The format follows the extension, '.txo' keeps the ram images as they are
+    Filename txo_file = output;
+    txo_file.make_dir();
+    return texture->write(txo_file);
+}
+
+bool TextureCooker::is_cookable(const std::string& path) {
+    static const char* extensions[] = {
+        ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".tif", ".tiff", ".sgi", ".rgb",
+    };
+
+    std::string lower_path = path;
+    std::transform(lower_path.begin(), lower_path.end(), lower_path.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    for (const char* ext : extensions) {
+        size_t ext_len = std::strlen(ext);
+        if (lower_path.size() > ext_len &&
+            lower_path.compare(lower_path.size() - ext_len, ext_len, ext) == 0)
+            return true;
+    }
+    return false;
+}
+
+std::string TextureCooker::get_cache_extension(const Options& options) {
+    std::string extension;
+    if (options.compress)
+        extension += ".dxt";
+    if (!options.generate_mipmaps)
+        extension += ".nomip";
+    if (options.max_size > 0)
+        extension += ".max" + std::to_string(options.max_size);
+    // '.pf' files were filtered per face, with seams
+    if (options.prefilter)
+        extension += ".pf2";
+    return extension + ".txo";
+}
@@ -0,0 +1,456 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <asyncTaskManager.h>
+#include <boundingSphere.h>
+#include <camera.h>
+#include <config_putil.h>
+#include <displayRegion.h>
+#include <geomNode.h>
+#include <lens.h>
+#include <nodePathCollection.h>
+#include <pnmImageHeader.h>
+#include <textureAttrib.h>
+#include <virtualFileSystem.h>
+
+#include "textureStreamer.hpp"
+#include "taskUtils.hpp"
+
+namespace {
+    void add_attrib_textures(const RenderState* state, std::vector<Texture*>& textures) {
+        const TextureAttrib* attrib;
+        if (state == nullptr || !state->get_attrib(attrib))
+            return;
+
+        for (int i = 0; i < attrib->get_num_on_stages(); ++i) {
+            textures.push_back(attrib->get_on_texture(attrib->get_on_stage(i)));
+        }
+    }
+}
+
+TextureStreamer::TextureStreamer() :
+    _base_size(64),
+    _max_size(0),
+    _budget(0),
+    _resident_bytes(0),
+    _update_interval(10),
+    _frame(0),
+    _max_in_flight(4),
+    _num_in_flight(0),
+    _search_scene(false) {}
+
+PT(Texture) TextureStreamer::load(const std::string& path) {
+    auto it = _entries.find(path);
+    if (it != _entries.end())
+        return it->second.texture;
+
+    Filename fullpath(path);
+    if (!VirtualFileSystem::get_global_ptr()->resolve_filename(fullpath, get_model_path())) {
+        std::cerr << "TextureStreamer: could not find " << path << std::endl;
+        return nullptr;
+    }
+
+    PNMImageHeader header;
+    if (!header.read_header(fullpath)) {
+        std::cerr << "TextureStreamer: could not read " << fullpath << std::endl;
+        return nullptr;
+    }
+
+    Entry entry;
+    entry.fullpath = fullpath;
+    entry.full_x_size = header.get_x_size();
+    entry.full_y_size = header.get_y_size();
+    entry.num_components = header.get_num_channels();
+    entry.max_size = _max_size;
+    entry.screen_size = 0.0f;
+
+    entry.base_level = 0;
+    while (std::max(entry.full_x_size >> entry.base_level, entry.full_y_size >> entry.base_level) > _base_size)
+        ++entry.base_level;
+
+    // Only the base level is decoded up front, the reader scales
+    // while decoding where the format supports it (e.g. JPEG).
+    PNMImage image;
+    image.set_read_size(
+        std::max(entry.full_x_size >> entry.base_level, 1),
+        std::max(entry.full_y_size >> entry.base_level, 1));
+    if (!image.read(fullpath))
+        return nullptr;
+
+    entry.texture = new Texture(fullpath.get_basename_wo_extension());
+    entry.texture->load(image);
+    entry.texture->set_filename(path);
+    entry.texture->set_fullpath(fullpath);
+    // Mipmaps are generated by the driver for whatever level is resident
+    entry.texture->set_minfilter(SamplerState::FT_linear_mipmap_linear);
+
+    entry.base_image = entry.texture->get_ram_image();
+    entry.base_x_size = entry.texture->get_x_size();
+    entry.base_y_size = entry.texture->get_y_size();
+    entry.base_format = entry.texture->get_format();
+    entry.base_component_type = entry.texture->get_component_type();
+    entry.resident_level = entry.base_level;
+    entry.desired_level = entry.base_level;
+
+    _resident_bytes += get_level_bytes(entry, entry.resident_level);
+
+    PT(Texture) texture = entry.texture;
+    _entries.emplace(path, std::move(entry));
+
+    // it may already be set on nodes anywhere in the scene, look for its
+    // users on the next update
+    _search_scene = true;
+    _frame = -1;
+    return texture;
+}
+
+bool TextureStreamer::is_streamed(const Texture* texture) const {
+    for (const auto& pair : _entries) {
+        if (pair.second.texture == texture)
+            return true;
+    }
+    return false;
+}
+
+void TextureStreamer::set_camera(NodePath camera, NodePath scene_root) {
+    _camera = camera;
+    _scene_root = scene_root;
+    _search_scene = true;
+    _frame = -1;
+}
+
+void TextureStreamer::update(const std::string& task_chain) {
+    if (_entries.empty())
+        return;
+
+    // Apply finished decodes
+    for (auto& pair : _entries) {
+        Entry& entry = pair.second;
+        if (entry.request != nullptr && entry.request->done)
+            apply_request(entry);
+    }
+
+    if (++_frame % _update_interval != 0)
+        return;
+
+    if (_search_scene)
+        find_users();
+    else
+        update_users();
+
+    estimate_screen_sizes();
+    fit_to_budget();
+
+    for (auto& pair : _entries) {
+        Entry& entry = pair.second;
+        if (entry.request != nullptr)
+            continue;
+
+        if (entry.desired_level == entry.base_level && entry.resident_level != entry.base_level) {
+            // Dropping back to the base level needs no decode
+            restore_base(entry);
+        }
+        else if (entry.desired_level != entry.resident_level && _num_in_flight < _max_in_flight) {
+            request_level(entry, entry.desired_level, task_chain);
+        }
+    }
+}
+
+void TextureStreamer::clear() {
+    _entries.clear();
+    _searched_children.clear();
+    _resident_bytes = 0;
+    _num_in_flight = 0;
+}
+
+void TextureStreamer::set_base_size(int size) {
+    _base_size = std::max(size, 1);
+}
+
+void TextureStreamer::set_max_size(int size) {
+    _max_size = std::max(size, 0);
+    for (auto& pair : _entries) {
+        pair.second.max_size = _max_size;
+    }
+}
+
+void TextureStreamer::set_max_size(const std::string& path, int size) {
+    auto it = _entries.find(path);
+    if (it != _entries.end())
+        it->second.max_size = std::max(size, 0);
+}
+
+void TextureStreamer::set_budget(size_t bytes) {
+    _budget = bytes;
+}
+
+void TextureStreamer::set_update_interval(int num_frames) {
+    _update_interval = std::max(num_frames, 1);
+}
+
+size_t TextureStreamer::get_budget() const {
+    return _budget;
+}
+
+size_t TextureStreamer::get_resident_bytes() const {
+    return _resident_bytes;
+}
+
+size_t TextureStreamer::get_num_textures() const {
+    return _entries.size();
+}
+
+size_t TextureStreamer::get_num_pending() const {
+    return _num_in_flight;
+}
+
+int TextureStreamer::get_level_for_size(const Entry& entry, int size) const {
+    // Lowest resolution level that still has at least 'size' texels on its long side
+    int level = entry.base_level;
+    while (level > 0 && std::max(entry.full_x_size >> level, entry.full_y_size >> level) < size)
+        --level;
+
+    int max_size = entry.max_size;
+    while (max_size > 0 && level < entry.base_level &&
+           std::max(entry.full_x_size >> level, entry.full_y_size >> level) > max_size)
+        ++level;
+
+    return level;
+}
+
+size_t TextureStreamer::get_level_bytes(const Entry& entry, int level) const {
+    size_t x_size = std::max(entry.full_x_size >> level, 1);
+    size_t y_size = std::max(entry.full_y_size >> level, 1);
+
+    // a full mip chain adds a third
+    return x_size * y_size * entry.num_components * 4 / 3;
+}
+
+void TextureStreamer::find_users() {
+    // The whole scene, only when the streamed textures or the scene change
+    for (auto& pair : _entries) {
+        pair.second.users.clear();
+    }
+    _searched_children.clear();
+    _search_scene = false;
+
+    if (_scene_root.is_empty())
+        return;
+
+    add_users(_scene_root);
+    for (int i = 0; i < _scene_root.get_num_children(); ++i) {
+        _searched_children.push_back(_scene_root.get_child(i).node());
+    }
+}
+
+void TextureStreamer::update_users() {
+    if (_scene_root.is_empty())
+        return;
+
+    // Users removed from the scene leave
+    for (auto& pair : _entries) {
+        std::vector<NodePath>& users = pair.second.users;
+        users.erase(std::remove_if(users.begin(), users.end(), [this](const NodePath& user) {
+            return user.is_empty() || !_scene_root.is_ancestor_of(user);
+        }), users.end());
+    }
+
+    // Children that appeared since the last update are searched once,
+    // the list also keeps removed ones from coming back at the same address
+    std::vector<PT(PandaNode)> children;
+    for (int i = 0; i < _scene_root.get_num_children(); ++i) {
+        NodePath child = _scene_root.get_child(i);
+        children.push_back(child.node());
+
+        if (std::find(_searched_children.begin(), _searched_children.end(), child.node()) == _searched_children.end())
+            add_users(child);
+    }
+    _searched_children.swap(children);
+}
+
+void TextureStreamer::add_users(NodePath root) {
+    if (root.is_empty() || _entries.empty())
+        return;
+
+    std::unordered_map<const Texture*, Entry*> streamed;
+    for (auto& pair : _entries) {
+        streamed[pair.second.texture] = &pair.second;
+    }
+
+    std::vector<Texture*> textures;
+    NodePathCollection geom_nps = root.find_all_matches("**/+GeomNode");
+    if (root.node()->is_geom_node())
+        geom_nps.add_path(root);
+
+    for (int i = 0; i < geom_nps.get_num_paths(); ++i) {
+        NodePath geom_np = geom_nps.get_path(i);
+        GeomNode* geom_node = DCAST(GeomNode, geom_np.node());
+
+        // textures can be set on the node, an ancestor or a single geom
+        textures.clear();
+        add_attrib_textures(geom_np.get_net_state(), textures);
+        for (int j = 0; j < geom_node->get_num_geoms(); ++j) {
+            add_attrib_textures(geom_node->get_geom_state(j), textures);
+        }
+
+        for (Texture* texture : textures) {
+            auto it = streamed.find(texture);
+            if (it == streamed.end())
+                continue;
+
+            std::vector<NodePath>& users = it->second->users;
+            if (std::find(users.begin(), users.end(), geom_np) == users.end())
+                users.push_back(geom_np);
+        }
+    }
+}
+
+void TextureStreamer::estimate_screen_sizes() {
+    Camera* camera = _camera.is_empty() ? nullptr : DCAST(Camera, _camera.node());
+    Lens* lens = camera != nullptr ? camera->get_lens() : nullptr;
+
+    int viewport_height = 1080;
+    if (camera != nullptr && camera->get_num_display_regions() > 0)
+        viewport_height = camera->get_display_region(0)->get_pixel_height();
+
+    for (auto& pair : _entries) {
+        Entry& entry = pair.second;
+        entry.screen_size = 0.0f;
+
+        if (lens == nullptr)
+            continue;
+
+        for (const NodePath& user : entry.users) {
+            if (user.is_empty() || user.is_hidden())
+                continue;
+
+            CPT(BoundingVolume) bounds = user.get_bounds();
+            const BoundingSphere* sphere = bounds->as_bounding_sphere();
+            if (sphere == nullptr || sphere->is_empty() || sphere->is_infinite())
+                continue;
+
+            LPoint3 center = _camera.get_relative_point(user, sphere->get_center());
+            PN_stdfloat radius = _camera.get_relative_vector(user, LVector3(sphere->get_radius(), 0, 0)).length();
+
+            // behind the camera
+            if (center[1] < -radius)
+                continue;
+
+            // diameter of the bounds on screen, in pixels
+            float size;
+            if (lens->is_orthographic()) {
+                size = 2.0f * radius / lens->get_film_size()[1] * viewport_height;
+            } else {
+                float half_fov = deg_2_rad(lens->get_fov()[1]) * 0.5f;
+                float distance = std::max((float)center.length(), (float)lens->get_near());
+                size = radius / (distance * std::tan(half_fov)) * viewport_height;
+            }
+
+            entry.screen_size = std::max(entry.screen_size, size);
+        }
+
+        entry.desired_level = get_level_for_size(entry, (int)std::ceil(entry.screen_size));
+    }
+}
+
+void TextureStreamer::fit_to_budget() {
+    if (_budget == 0)
+        return;
+
+    size_t total = 0;
+    std::vector<Entry*> entries;
+    for (auto& pair : _entries) {
+        total += get_level_bytes(pair.second, pair.second.desired_level);
+        entries.push_back(&pair.second);
+    }
+
+    // Smallest on screen loses resolution first, a level per pass so
+    // large textures aren't dropped all the way when one step is enough.
+    std::sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b) {
+        return a->screen_size < b->screen_size;
+    });
+
+    bool reduced = true;
+    while (total > _budget && reduced) {
+        reduced = false;
+        for (Entry* entry : entries) {
+            if (total <= _budget)
+                break;
+            if (entry->desired_level >= entry->base_level)
+                continue;
+
+            total -= get_level_bytes(*entry, entry->desired_level);
+            ++entry->desired_level;
+            total += get_level_bytes(*entry, entry->desired_level);
+            reduced = true;
+        }
+    }
+}
+
+void TextureStreamer::request_level(Entry& entry, int level, const std::string& task_chain) {
+    auto request = std::make_shared<Request>();
+    request->level = level;
+    entry.request = request;
+    ++_num_in_flight;
+
+    Filename fullpath = entry.fullpath;
+    int x_size = std::max(entry.full_x_size >> level, 1);
+    int y_size = std::max(entry.full_y_size >> level, 1);
+
+    PT(AsyncTask) task = make_task([request, fullpath, x_size, y_size](AsyncTask*) -> AsyncTask::DoneStatus {
+        PNMImage image;
+        image.set_read_size(x_size, y_size);
+        if (image.read(fullpath)) {
+            if (image.get_x_size() != x_size || image.get_y_size() != y_size) {
+                PNMImage scaled(x_size, y_size, image.get_num_channels(), image.get_maxval());
+                scaled.quick_filter_from(image);
+                image = std::move(scaled);
+            }
+
+            request->staged = new Texture;
+            request->staged->load(image);
+        }
+
+        request->done = true;
+        return AsyncTask::DS_done;
+    }, "StreamTexture:" + fullpath.get_basename());
+
+    task->set_task_chain(task_chain);
+    // finer levels are more expensive and less urgent
+    task->set_priority(-level);
+    AsyncTaskManager::get_global_ptr()->add(task);
+}
+
+void TextureStreamer::apply_request(Entry& entry) {
+    std::shared_ptr<Request> request = std::move(entry.request);
+    entry.request = nullptr;
+    --_num_in_flight;
+
+    Texture* staged = request->staged;
+    if (staged == nullptr || !staged->has_ram_image())
+        return;
+
+    _resident_bytes -= get_level_bytes(entry, entry.resident_level);
+
+    // Swap the image in place, geometry keeps using the same Texture
+    entry.texture->setup_2d_texture(
+        staged->get_x_size(), staged->get_y_size(),
+        staged->get_component_type(), staged->get_format());
+    entry.texture->set_ram_image(staged->get_ram_image());
+    entry.resident_level = request->level;
+
+    _resident_bytes += get_level_bytes(entry, entry.resident_level);
+}
+
+void TextureStreamer::restore_base(Entry& entry) {
+    _resident_bytes -= get_level_bytes(entry, entry.resident_level);
+
+    entry.texture->setup_2d_texture(
+        entry.base_x_size, entry.base_y_size,
+        entry.base_component_type, entry.base_format);
+    entry.texture->set_ram_image(entry.base_image);
+    entry.resident_level = entry.base_level;
+
+    _resident_bytes += get_level_bytes(entry, entry.resident_level);
+}
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <cmath>
+
+#include "timerWheel.hpp"
+
+// ------------------------------------ TimerWheel ------------------------------------ //
+TimerWheel::TimerWheel() :
+    _current_tick(0),
+    _next_sequence(0),
+    _num_pending(0) {}
+
+TimerHandle TimerWheel::schedule(uint64_t delay, std::function<void()> callback) {
+    // The slot of the current tick has already fired
+    delay = std::max<uint64_t>(delay, 1);
+
+    int32_t index = allocate_node();
+    Node& node = _nodes[index];
+    node.callback = std::move(callback);
+    node.due_tick = _current_tick + delay;
+    node.sequence = _next_sequence++;
+
+    insert(index);
+    _num_pending++;
+
+    TimerHandle handle;
+    handle.index = static_cast<uint32_t>(index);
+    handle.generation = node.generation;
+    return handle;
+}
+
+bool TimerWheel::cancel(const TimerHandle& handle) {
+    if (!is_pending(handle))
+        return false;
+
+    int32_t index = static_cast<int32_t>(handle.index);
+    if (_nodes[index].slot != NONE)
+        unlink(index);
+
+    // Timers collected for the current tick are skipped once freed
+    free_node(index);
+    _num_pending--;
+    return true;
+}
+
+bool TimerWheel::is_pending(const TimerHandle& handle) const {
+    if (!handle.is_valid() || handle.index >= _nodes.size())
+        return false;
+
+    const Node& node = _nodes[handle.index];
+    return node.generation == handle.generation && node.callback != nullptr;
+}
+
+void TimerWheel::advance(uint64_t ticks) {
+    for (uint64_t i = 0; i < ticks; ++i) {
+        tick();
+    }
+}
+
+void TimerWheel::clear() {
+    for (Slot& slot : _slots) {
+        slot = Slot();
+    }
+
+    _free_nodes.clear();
+    for (int32_t i = static_cast<int32_t>(_nodes.size()) - 1; i >= 0; --i) {
+        if (_nodes[i].callback != nullptr)
+            _nodes[i].generation++;
+        _nodes[i].callback = nullptr;
+        _nodes[i].prev = _nodes[i].next = _nodes[i].slot = NONE;
+        _free_nodes.push_back(i);
+    }
+
+    _firing.clear();
+    _num_pending = 0;
+}
+
+uint64_t TimerWheel::get_current_tick() const {
+    return _current_tick;
+}
+
+size_t TimerWheel::get_num_pending() const {
+    return _num_pending;
+}
+
+int32_t TimerWheel::allocate_node() {
+    if (!_free_nodes.empty()) {
+        int32_t index = _free_nodes.back();
+        _free_nodes.pop_back();
+        return index;
+    }
+
+    _nodes.emplace_back();
+    return static_cast<int32_t>(_nodes.size()) - 1;
+}
+
+void TimerWheel::free_node(int32_t index) {
+    Node& node = _nodes[index];
+    node.callback = nullptr;
+    node.prev = node.next = node.slot = NONE;
+
+    // invalidate outstanding handles, 0 is reserved for 'no timer'
+    node.generation++;
+    if (node.generation == 0)
+        node.generation = 1;
+
+    _free_nodes.push_back(index);
+}
+
+void TimerWheel::insert(int32_t index) {
+    Node& node = _nodes[index];
+    uint64_t delay = node.due_tick > _current_tick ? node.due_tick - _current_tick : 0;
+
+    // Timers further away than the wheel can hold are parked in the
+    // outermost level and re-inserted when it cascades.
+    uint64_t due = _current_tick + std::min(delay, MAX_DELAY);
+
+    int32_t slot;
+    if (delay < LEVEL0_SLOTS) {
+        slot = static_cast<int32_t>(due & (LEVEL0_SLOTS - 1));
+    }
+    else {
+        int level = 1;
+        int shift = LEVEL0_BITS;
+        while (level < NUM_LEVELS - 1 && delay >= (uint64_t(1) << (shift + LEVELN_BITS))) {
+            shift += LEVELN_BITS;
+            level++;
+        }
+
+        int32_t level_slot = static_cast<int32_t>((due >> shift) & (LEVELN_SLOTS - 1));
+        slot = LEVEL0_SLOTS + (level - 1) * LEVELN_SLOTS + level_slot;
+    }
+
+    link(slot, index);
+}
+
+void TimerWheel::link(int32_t slot, int32_t index) {
+    Node& node = _nodes[index];
+    Slot& s = _slots[slot];
+
+    node.slot = slot;
+    node.prev = s.tail;
+    node.next = NONE;
+
+    if (s.tail != NONE)
+        _nodes[s.tail].next = index;
+    else
+        s.head = index;
+    s.tail = index;
+}
+
+void TimerWheel::unlink(int32_t index) {
+    Node& node = _nodes[index];
+    Slot& s = _slots[node.slot];
+
+    if (node.prev != NONE)
+        _nodes[node.prev].next = node.next;
+    else
+        s.head = node.next;
+
+    if (node.next != NONE)
+        _nodes[node.next].prev = node.prev;
+    else
+        s.tail = node.prev;
+
+    node.prev = node.next = node.slot = NONE;
+}
+
+void TimerWheel::cascade(int level) {
+    int shift = LEVEL0_BITS + (level - 1) * LEVELN_BITS;
+    int32_t level_slot = static_cast<int32_t>((_current_tick >> shift) & (LEVELN_SLOTS - 1));
+    Slot& s = _slots[LEVEL0_SLOTS + (level - 1) * LEVELN_SLOTS + level_slot];
+
+    // Move every timer of this slot down to a finer level
+    int32_t index = s.head;
+    s.head = s.tail = NONE;
+
+    while (index != NONE) {
+        int32_t next = _nodes[index].next;
+        _nodes[index].prev = _nodes[index].next = _nodes[index].slot = NONE;
+        insert(index);
+        index = next;
+    }
+}
+
+void TimerWheel::tick() {
+    _current_tick++;
+
+    // Cascade outer levels whenever the level below wraps around
+    int shift = LEVEL0_BITS;
+    for (int level = 1; level < NUM_LEVELS; ++level) {
+        if ((_current_tick & ((uint64_t(1) << shift) - 1)) != 0)
+            break;
+        cascade(level);
+        shift += LEVELN_BITS;
+    }
+
+    Slot& s = _slots[_current_tick & (LEVEL0_SLOTS - 1)];
+    if (s.head == NONE)
+        return;
+
+    _firing.clear();
+    int32_t index = s.head;
+    while (index != NONE) {
+        int32_t next = _nodes[index].next;
+        unlink(index);
+
+        // parked timers that are still not due go back into the wheel
+        if (_nodes[index].due_tick > _current_tick)
+            insert(index);
+        else
+            _firing.emplace_back(index, _nodes[index].generation);
+
+        index = next;
+    }
+
+    // Cascaded and directly scheduled timers can end up interleaved,
+    // restore scheduling order so that firing order is deterministic.
+    std::sort(_firing.begin(), _firing.end(),
+        [this](const std::pair<int32_t, uint32_t>& a, const std::pair<int32_t, uint32_t>& b) {
+            return _nodes[a.first].sequence < _nodes[b.first].sequence;
+        });
+
+    for (size_t i = 0; i < _firing.size(); ++i) {
+        int32_t firing_index = _firing[i].first;
+        Node& node = _nodes[firing_index];
+
+        // cancelled by a timer that fired before it
+        if (node.generation != _firing[i].second || node.callback == nullptr)
+            continue;
+
+        std::function<void()> callback = std::move(node.callback);
+        free_node(firing_index);
+        _num_pending--;
+
+        callback();
+    }
+    _firing.clear();
+}
+
+// ------------------------------------ TimerService ------------------------------------ //
+TimerService::TimerService() : _last_ms(0), _started(false) {}
+
+TimerHandle TimerService::after_frames(int num_frames, std::function<void()> callback) {
+    TimerHandle handle = _frame_wheel.schedule(
+        static_cast<uint64_t>(std::max(num_frames, 0)),
+        std::move(callback));
+    handle.wheel = FRAME_WHEEL;
+    return handle;
+}
+
+TimerHandle TimerService::after_seconds(double seconds, std::function<void()> callback) {
+    uint64_t ms = static_cast<uint64_t>(std::ceil(std::max(seconds, 0.0) * 1000.0));
+    TimerHandle handle = _time_wheel.schedule(ms, std::move(callback));
+    handle.wheel = TIME_WHEEL;
+    return handle;
+}
+
+bool TimerService::cancel(TimerHandle& handle) {
+    bool cancelled = (handle.wheel == FRAME_WHEEL) ?
+        _frame_wheel.cancel(handle) :
+        _time_wheel.cancel(handle);
+
+    handle = TimerHandle();
+    return cancelled;
+}
+
+bool TimerService::is_pending(const TimerHandle& handle) const {
+    return (handle.wheel == FRAME_WHEEL) ?
+        _frame_wheel.is_pending(handle) :
+        _time_wheel.is_pending(handle);
+}
+
+void TimerService::update(double frame_time) {
+    uint64_t now_ms = static_cast<uint64_t>(std::max(frame_time, 0.0) * 1000.0);
+    if (!_started) {
+        _last_ms = now_ms;
+        _started = true;
+    }
+
+    _frame_wheel.advance(1);
+
+    if (now_ms > _last_ms) {
+        _time_wheel.advance(now_ms - _last_ms);
+        _last_ms = now_ms;
+    }
+}
+
+void TimerService::clear() {
+    _frame_wheel.clear();
+    _time_wheel.clear();
+}
+
+size_t TimerService::get_num_pending() const {
+    return _frame_wheel.get_num_pending() + _time_wheel.get_num_pending();
+}
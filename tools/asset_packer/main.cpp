@@ -0,0 +1,75 @@
+// Builds an asset pack from an assets folder, e.g.
+//
+//   asset_packer <project_dir>/assets <project_dir>/assets.pack --compress
+//
+// The editor mounts '<dir>.pack' over '<dir>' on startup, see Demon::setup_paths.
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "assetPack.hpp"
+
+namespace fs = std::filesystem;
+
+static void print_usage() {
+    std::cout <<
+        "usage: asset_packer <assets_dir> <output.pack> [options]\n"
+        "  --compress     zlib compress entries where it saves space\n"
+        "  --align <n>    entry alignment in bytes (default 64)\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+
+    fs::path assets_dir = argv[1];
+    std::string output = argv[2];
+    bool compress = false;
+    uint32_t alignment = 64;
+
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--compress") == 0) {
+            compress = true;
+        }
+        else if (std::strcmp(argv[i], "--align") == 0 && i + 1 < argc) {
+            alignment = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (!fs::is_directory(assets_dir)) {
+        std::cerr << "Not a directory: " << assets_dir << std::endl;
+        return 1;
+    }
+
+    std::vector<AssetPack::Input> inputs;
+    uint64_t total_size = 0;
+
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(assets_dir)) {
+        if (!entry.is_regular_file())
+            continue;
+
+        // pack paths always use '/'
+        std::string path = fs::relative(entry.path(), assets_dir).generic_string();
+        inputs.push_back({ path, entry.path().string() });
+        total_size += entry.file_size();
+    }
+
+    if (!AssetPack::write(output, inputs, compress, alignment)) {
+        std::cerr << "Failed to write " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << "Packed " << inputs.size() << " files (" << total_size << " bytes) into "
+              << output << " (" << fs::file_size(output) << " bytes)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Cooks images to '.txo' with a filtered mip chain, e.g.
+//
+//   texture_cooker stock/models/ralph.jpg ralph.txo --compress
+//   texture_cooker <project_dir>/assets <project_dir>/cooked --compress
+//   texture_cooker skybox/sky_#.png sky.txo --cube --prefilter
+//
+// A directory input cooks every image below it, keeping the folder layout.
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "jobSystem.hpp"
+#include "textureCooker.hpp"
+
+namespace fs = std::filesystem;
+
+static void print_usage() {
+    std::cout <<
+        "usage: texture_cooker <input> <output> [options]\n"
+        "  --compress       DXT1/DXT5 block compression\n"
+        "  --no-mips        don't generate mipmaps\n"
+        "  --max-size <n>   limit the largest side of the top level\n"
+        "  --radius <r>     mip filter radius (default 1.0)\n"
+        "  --cube           input is a cube map pattern, '#' is the face 0-5\n"
+        "  --prefilter      blur cube map mips more per level\n";
+}
+
+static bool cook_file(const fs::path& input, const fs::path& output, const TextureCooker::Options& options) {
+    Filename source = Filename::from_os_specific(input.string());
+    Filename target = Filename::from_os_specific(output.string());
+
+    if (!TextureCooker::cook(source, target, options)) {
+        std::cerr << "Failed: " << input << std::endl;
+        return false;
+    }
+
+    std::cout << input.string() << " -> " << output.string()
+              << " (" << fs::file_size(input) << " -> " << fs::file_size(output) << " bytes)" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+
+    fs::path input = argv[1];
+    fs::path output = argv[2];
+    TextureCooker::Options options;
+    bool cube_map = false;
+
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--compress") == 0) {
+            options.compress = true;
+        }
+        else if (std::strcmp(argv[i], "--no-mips") == 0) {
+            options.generate_mipmaps = false;
+        }
+        else if (std::strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+            options.max_size = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--radius") == 0 && i + 1 < argc) {
+            options.filter_radius = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--cube") == 0) {
+            cube_map = true;
+        }
+        else if (std::strcmp(argv[i], "--prefilter") == 0) {
+            options.prefilter = true;
+        }
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (cube_map) {
+        std::vector<Filename> faces;
+        for (const std::string& face : TextureCooker::get_cube_map_faces(input.string()))
+            faces.push_back(Filename::from_os_specific(face));
+
+        JobSystem job_system;
+        job_system.start();
+        PT(Texture) texture = TextureCooker::cook_cube_map(faces, options, &job_system);
+        job_system.stop();
+
+        Filename target = Filename::from_os_specific(output.string());
+        target.make_dir();
+        if (texture == nullptr || !texture->write(target)) {
+            std::cerr << "Failed: " << input << std::endl;
+            return 1;
+        }
+        std::cout << input.string() << " -> " << output.string() << std::endl;
+        return 0;
+    }
+
+    if (!fs::is_directory(input))
+        return cook_file(input, output, options) ? 0 : 1;
+
+    int num_failed = 0;
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(input)) {
+        if (!entry.is_regular_file() || !TextureCooker::is_cookable(entry.path().string()))
+            continue;
+
+        fs::path target = output / fs::relative(entry.path(), input);
+        target.replace_extension(".txo");
+        if (!cook_file(entry.path(), target, options))
+            ++num_failed;
+    }
+
+    return num_failed == 0 ? 0 : 1;
+}